@@ -0,0 +1,36 @@
+#include "bench.hpp"
+#include <assets/assets.hpp>
+#include <assets/file.hpp>
+#include <assets/shaders.hpp>
+
+void addAssetBenchmarks(std::vector<BenchEntry>& benchmarks) {
+	benchmarks.push_back({"assets/read_file", [](Bench& bench) {
+		bench.run([] {
+			std::vector<char> source = readFile(Identifier("core", "vertex"), AssetType::Shader);
+			keep(source);
+		});
+	}});
+
+	benchmarks.push_back({"assets/compile_shader", [](Bench& bench) {
+		bench.run("vertex", [] {
+			std::vector<uint32_t> code = compileShader(Identifier("core", "vertex"), ShaderType::Vertex);
+			keep(code);
+		});
+		bench.run("mesher", [] {
+			std::vector<uint32_t> code = compileShader(Identifier("core", "mesher"), ShaderType::Compute);
+			keep(code);
+		});
+	}});
+
+	// Identifiers are built and resolved to a path on every asset load.
+	benchmarks.push_back({"assets/identifier", [](Bench& bench) {
+		bench.run("construct", [] {
+			Identifier id("core", "vertex");
+			keep(id);
+		});
+		bench.run("resolve", [] {
+			std::filesystem::path path = getFilePath(Identifier("core", "vertex"), AssetType::Shader);
+			keep(path);
+		});
+	}});
+}
@@ -0,0 +1,176 @@
+#include "bench.hpp"
+#include <core/allocations.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+const double DEFAULT_MIN_SECONDS = 0.2;
+const int SAMPLES = 5;
+
+Bench::Bench(std::string name, double minSeconds) : name(name), minSeconds(minSeconds) {}
+
+// Seconds taken by iterations calls of op.
+static double timeOps(const std::function<void()>& op, uint64_t iterations) {
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < iterations; i++) op();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Bench::run(const std::function<void()>& op, double items, std::string itemName) {
+	run("", op, items, itemName);
+}
+
+void Bench::run(const std::string& variant, const std::function<void()>& op, double items, std::string itemName) {
+	// One untimed call warms caches and lets lazily built state settle.
+	op();
+
+	uint64_t iterations = 1;
+	for (;;) {
+		double seconds = timeOps(op, iterations);
+		if (seconds >= minSeconds) break;
+		// Aim a little past the target so the next try usually is the last.
+		double scale = seconds > 0.0 ? minSeconds * 1.2 / seconds : 100.0;
+		iterations = std::max(iterations + 1, static_cast<uint64_t>(iterations * std::min(scale, 100.0)));
+	}
+
+	std::array<double, SAMPLES> samples;
+	uint64_t allocations = threadAllocations();
+	uint64_t bytes = threadAllocatedBytes();
+	for (double& sample : samples) sample = timeOps(op, iterations);
+	allocations = threadAllocations() - allocations;
+	bytes = threadAllocatedBytes() - bytes;
+	std::sort(samples.begin(), samples.end());
+
+	double ops = static_cast<double>(iterations) * SAMPLES;
+	BenchResult result;
+	result.name = variant.empty() ? name : name + "/" + variant;
+	result.iterations = iterations;
+	result.nsPerOp = samples[SAMPLES / 2] * 1e9 / static_cast<double>(iterations);
+	result.allocsPerOp = allocations / ops;
+	result.bytesPerOp = bytes / ops;
+	result.itemsPerOp = items;
+	result.itemName = itemName;
+	measured.push_back(result);
+}
+
+void Bench::skip(std::string reason) {
+	skipReason = reason;
+}
+
+static std::string escape(const std::string& text) {
+	std::string out;
+	for (char c : text) {
+		if (c == '"' || c == '\\') out += '\\';
+		out += c;
+	}
+	return out;
+}
+
+static void printResult(const BenchResult& result) {
+	std::cout << std::left << std::setw(40) << result.name << std::right << std::fixed
+		<< std::setw(14) << std::setprecision(1) << result.nsPerOp << " ns/op"
+		<< std::setw(12) << std::setprecision(1) << result.bytesPerOp << " B/op"
+		<< std::setw(10) << std::setprecision(2) << result.allocsPerOp << " allocs/op";
+	if (result.itemsPerOp > 0.0) {
+		std::cout << std::setw(14) << std::setprecision(0) << result.itemsPerOp * 1e9 / result.nsPerOp << " " << result.itemName << "/s";
+	}
+	std::cout << std::endl;
+}
+
+static void writeJson(const std::string& path, const std::vector<BenchResult>& results) {
+	std::ostringstream json;
+	json << std::setprecision(6);
+	json << "{\n";
+	json << "  \"allocations_counted\": " << (allocationsCounted() ? "true" : "false") << ",\n";
+	json << "  \"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& result = results[i];
+		json << "    {\"name\": \"" << escape(result.name) << "\""
+			<< ", \"iterations\": " << result.iterations
+			<< ", \"ns_per_op\": " << result.nsPerOp
+			<< ", \"bytes_per_op\": " << result.bytesPerOp
+			<< ", \"allocs_per_op\": " << result.allocsPerOp;
+		if (result.itemsPerOp > 0.0) {
+			json << ", \"items_per_op\": " << result.itemsPerOp
+				<< ", \"item\": \"" << escape(result.itemName) << "\"";
+		}
+		json << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	json << "  ]\n}\n";
+
+	std::ofstream file(path);
+	if (!file.is_open()) throw std::runtime_error("failed to open " + path);
+	file << json.str();
+}
+
+static void usage() {
+	std::cout << "usage: game_bench [--filter text] [--json path] [--min-time seconds] [--gpu] [--list]" << std::endl;
+}
+
+// Runs from the build directory like the game, so asset paths resolve.
+// GPU benchmarks open a window and need a Vulkan device such as lavapipe,
+// so they only run with --gpu.
+int main(int argc, char **argv) {
+	std::string filter;
+	std::string jsonPath;
+	double minSeconds = DEFAULT_MIN_SECONDS;
+	bool gpu = false;
+	bool list = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+		else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+		else if (arg == "--min-time" && i + 1 < argc) minSeconds = std::stod(argv[++i]);
+		else if (arg == "--gpu") gpu = true;
+		else if (arg == "--list") list = true;
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	std::vector<BenchEntry> benchmarks;
+	addAssetBenchmarks(benchmarks);
+	addWorldBenchmarks(benchmarks);
+	addNetBenchmarks(benchmarks);
+	addRenderingBenchmarks(benchmarks, gpu);
+
+	if (!allocationsCounted()) {
+		std::cout << "allocation counting is off in this build; bytes and allocs read 0" << std::endl;
+	}
+
+	std::vector<BenchResult> results;
+	for (const BenchEntry& entry : benchmarks) {
+		if (!filter.empty() && entry.name.find(filter) == std::string::npos) continue;
+		if (list) {
+			std::cout << entry.name << std::endl;
+			continue;
+		}
+
+		Bench bench(entry.name, minSeconds);
+		try {
+			entry.function(bench);
+		} catch (std::exception & err) {
+			std::cout << entry.name << ": std::exception: " << err.what() << std::endl;
+			return 1;
+		}
+
+		if (!bench.skipped().empty()) {
+			std::cout << std::left << std::setw(40) << entry.name << "skipped: " << bench.skipped() << std::endl;
+		}
+		for (const BenchResult& result : bench.results()) {
+			printResult(result);
+			results.push_back(result);
+		}
+	}
+
+	if (!jsonPath.empty()) writeJson(jsonPath, results);
+	return 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class World;
+class JobSystem;
+
+// What one benchmark measured. Times are the median over samples;
+// allocations are those made on the benchmarking thread only, so work
+// handed to the job system shows up in time but not in bytes or counts.
+struct BenchResult {
+	std::string name;
+	uint64_t iterations = 0;
+	double nsPerOp = 0.0;
+	double bytesPerOp = 0.0;
+	double allocsPerOp = 0.0;
+	// Items, such as chunks or rays, each operation processes; 0 when
+	// the benchmark does not count them.
+	double itemsPerOp = 0.0;
+	std::string itemName;
+};
+
+// Handed to every benchmark. Setup runs before run(), untimed; run()
+// repeats op until a sample takes at least minSeconds, then times
+// several such samples. A benchmark comparing cases runs each as a
+// variant, reported as name/variant.
+class Bench {
+public:
+	Bench(std::string name, double minSeconds);
+
+	void run(const std::function<void()>& op, double items = 0.0, std::string itemName = "");
+	void run(const std::string& variant, const std::function<void()>& op, double items = 0.0, std::string itemName = "");
+	// Reports the benchmark as not run, such as GPU ones without a device.
+	void skip(std::string reason);
+
+	const std::vector<BenchResult>& results() const { return measured; }
+	const std::string& skipped() const { return skipReason; }
+private:
+	std::string name;
+	double minSeconds;
+	std::vector<BenchResult> measured;
+	std::string skipReason;
+};
+
+using BenchFunction = std::function<void(Bench&)>;
+
+struct BenchEntry {
+	std::string name;
+	BenchFunction function;
+};
+
+// Each file of benchmarks adds its own to the list.
+void addAssetBenchmarks(std::vector<BenchEntry>& benchmarks);
+void addWorldBenchmarks(std::vector<BenchEntry>& benchmarks);
+void addNetBenchmarks(std::vector<BenchEntry>& benchmarks);
+void addRenderingBenchmarks(std::vector<BenchEntry>& benchmarks, bool gpu);
+
+// Generated and lit terrain covering radius chunks around the origin,
+// the same for every run.
+void buildBenchWorld(World& world, int radius, JobSystem& jobs);
+
+// Keeps the compiler from discarding a result nothing else reads.
+template <typename T>
+inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const T *sink;
+	sink = &value;
+#endif
+}
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Compares two game_bench JSON reports and flags regressions.
+
+    ./game_bench --json current.json
+    python3 ../bench/compare.py baseline.json current.json
+
+A benchmark regresses when its ns/op grows by more than --threshold
+(a fraction, 0.10 by default), or when it allocates more per op than the
+baseline did. Exits with status 1 if anything regressed, so CI can fail
+on it. Benchmarks only present in one report are listed but never fail.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as file:
+        report = json.load(file)
+    return report, {entry["name"]: entry for entry in report["benchmarks"]}
+
+
+def change(old, new):
+    if old == 0:
+        return 0.0 if new == 0 else float("inf")
+    return new / old - 1.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10, help="allowed ns/op growth, as a fraction")
+    args = parser.parse_args()
+
+    baseline_report, baseline = load(args.baseline)
+    current_report, current = load(args.current)
+    # Allocation counts mean nothing when either build did not count them.
+    allocations = baseline_report.get("allocations_counted") and current_report.get("allocations_counted")
+
+    regressions = []
+    print(f"{'benchmark':<40} {'baseline ns':>14} {'current ns':>14} {'change':>9}  allocs/op")
+    for name in sorted(baseline.keys() & current.keys()):
+        old, new = baseline[name], current[name]
+        time = change(old["ns_per_op"], new["ns_per_op"])
+
+        problems = []
+        if time > args.threshold:
+            problems.append(f"{time:+.1%} time")
+        # Half an allocation of slack absorbs warm-up noise in the counts.
+        if allocations and new["allocs_per_op"] > old["allocs_per_op"] + 0.5:
+            problems.append(f"{old['allocs_per_op']:.2f} -> {new['allocs_per_op']:.2f} allocs")
+
+        flag = "  REGRESSION: " + ", ".join(problems) if problems else ""
+        print(f"{name:<40} {old['ns_per_op']:>14.1f} {new['ns_per_op']:>14.1f} {time:>+9.1%}  {new['allocs_per_op']:.2f}{flag}")
+        if problems:
+            regressions.append(name)
+
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:<40} missing from current report")
+    for name in sorted(current.keys() - baseline.keys()):
+        print(f"{name:<40} new, no baseline")
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s)")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,73 @@
+#include "bench.hpp"
+#include <net/client.hpp>
+#include <net/protocol.hpp>
+#include <world/blocks.hpp>
+#include <world/generator.hpp>
+#include <world/world.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+
+const uint64_t NET_BENCH_SEED = 0x5eed;
+const size_t BLOCK_CHANGE_BATCH = 64;
+
+static Message parsed(const std::vector<uint8_t>& frame) {
+	Message message;
+	size_t consumed = 0;
+	parseFrame(frame.data(), frame.size(), message, consumed);
+	return message;
+}
+
+void addNetBenchmarks(std::vector<BenchEntry>& benchmarks) {
+	// What the server does once per chunk and edit, and every client
+	// does per chunk received.
+	benchmarks.push_back({"net/chunk_data", [](Bench& bench) {
+		Chunk chunk(ChunkPos{0, 0});
+		TerrainGenerator(NET_BENCH_SEED).generate(chunk);
+
+		std::vector<uint8_t> frame;
+		bench.run("encode", [&] {
+			frame.clear();
+			writeChunkData(frame, chunk);
+			keep(frame);
+		}, 1.0, "chunks");
+
+		Message message = parsed(frame);
+		Chunk decoded(ChunkPos{0, 0});
+		bench.run("decode", [&] {
+			readChunkData(message, decoded);
+			keep(decoded);
+		}, 1.0, "chunks");
+	}});
+
+	benchmarks.push_back({"net/block_changes", [](Bench& bench) {
+		std::mt19937 random(3);
+		BlockChangeBatch batch;
+		batch.pos = {0, 4, 0};
+		for (size_t i = 0; i < BLOCK_CHANGE_BATCH; i++) {
+			batch.changes.emplace_back(static_cast<uint16_t>(random() % SECTION_VOLUME), static_cast<BlockId>(random() % CORE_BLOCK_COUNT));
+		}
+
+		std::vector<uint8_t> frame;
+		bench.run("encode", [&] {
+			frame.clear();
+			writeBlockChanges(frame, batch);
+			keep(frame);
+		}, static_cast<double>(BLOCK_CHANGE_BATCH), "changes");
+
+		// Applied through a receiver, as a client does, so this includes
+		// marking sections dirty.
+		World world;
+		auto chunk = std::make_unique<Chunk>(ChunkPos{0, 0});
+		TerrainGenerator(NET_BENCH_SEED).generate(*chunk);
+		world.addChunk(std::move(chunk));
+		Message message = parsed(frame);
+		ChunkReceiver receiver;
+		bench.run("apply", [&] {
+			receiver.apply(message, world);
+			world.takeDirtySections();
+			world.takeLightEdits();
+			world.takeBlockEdits();
+		}, static_cast<double>(BLOCK_CHANGE_BATCH), "changes");
+	}});
+}
@@ -0,0 +1,188 @@
+#include "bench.hpp"
+#include <rendering/arena.hpp>
+#include <rendering/camera.hpp>
+#include <rendering/mesher.hpp>
+#include <rendering/occlusion.hpp>
+#include <rendering/renderer.hpp>
+#include <rendering/translucency.hpp>
+#include <rendering/visibility.hpp>
+#include <rendering/window.hpp>
+#include <core/frame_arena.hpp>
+#include <world/world.hpp>
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+const uint32_t SORT_QUADS = 4096;
+const uint32_t ARENA_CAPACITY = 1 << 20;
+const vk::DeviceSize COPY_SIZE = 16 << 20;
+const float CULL_ASPECT = 16.0f / 9.0f;
+
+// Meshes every section of a bench world and keeps what the renderer
+// would: connectivity for the visibility walk, and occluder boxes.
+struct CullScene {
+	VisibilityGraph visibility;
+	std::unordered_map<SectionPos, Occluder, SectionPosHash> occluders;
+};
+
+static void buildCullScene(CullScene& scene, JobSystem& jobs) {
+	World world;
+	buildBenchWorld(world, 8, jobs);
+
+	MeshBatch batch;
+	meshDirtySections(world, jobs, batch);
+	for (size_t i = 0; i < batch.positions.size(); i++) {
+		SectionPos pos = batch.positions[i];
+		const SectionMesh& mesh = batch.meshes[i];
+		scene.visibility.set(pos, mesh.connectivity);
+		if (mesh.occluderTop > mesh.occluderBottom) {
+			glm::vec3 origin(pos.x * SECTION_SIZE, pos.y * SECTION_SIZE, pos.z * SECTION_SIZE);
+			scene.occluders[pos] = {origin + glm::vec3(0.0f, mesh.occluderBottom, 0.0f), origin + glm::vec3(SECTION_SIZE, mesh.occluderTop, SECTION_SIZE)};
+		}
+	}
+}
+
+// Created by the first GPU benchmark; needs a window and a device, which
+// on CI is lavapipe under a virtual display. Members are destroyed
+// renderer first.
+struct GpuContext {
+	std::unique_ptr<Window> window;
+	std::unique_ptr<JobSystem> jobs;
+	std::unique_ptr<Renderer> renderer;
+
+	Renderer& get() {
+		if (!renderer) {
+			window = std::make_unique<Window>("game_bench", 64, 64);
+			jobs = std::make_unique<JobSystem>();
+			renderer = std::make_unique<Renderer>(*window, *jobs);
+		}
+		return *renderer;
+	}
+};
+
+static void addGpuBenchmarks(std::vector<BenchEntry>& benchmarks) {
+	auto context = std::make_shared<GpuContext>();
+
+	benchmarks.push_back({"gpu/create_buffer", [context](Bench& bench) {
+		Renderer& renderer = context->get();
+		bench.run("host_visible", [&] {
+			vk::DeviceMemory memory;
+			vk::Buffer buffer = renderer.createBuffer(64 << 10, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging, memory);
+			renderer.destroyBuffer(buffer, memory);
+		});
+		bench.run("device_local", [&] {
+			vk::DeviceMemory memory;
+			vk::Buffer buffer = renderer.createBuffer(64 << 10, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Meshes, memory);
+			renderer.destroyBuffer(buffer, memory);
+		});
+	}});
+
+	// Includes waiting for the copy, so it measures transfer throughput
+	// rather than how fast commands are recorded.
+	benchmarks.push_back({"gpu/copy_buffer", [context](Bench& bench) {
+		Renderer& renderer = context->get();
+		vk::DeviceMemory sourceMemory, targetMemory;
+		vk::Buffer source = renderer.createBuffer(COPY_SIZE, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging, sourceMemory);
+		vk::Buffer target = renderer.createBuffer(COPY_SIZE, vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Other, targetMemory);
+
+		bench.run("16MiB", [&] {
+			renderer.copyBuffer(source, target, COPY_SIZE);
+			renderer.end();
+			renderer.collectRetired();
+		}, static_cast<double>(COPY_SIZE >> 20), "MiB");
+
+		renderer.destroyBuffer(source, sourceMemory);
+		renderer.destroyBuffer(target, targetMemory);
+	}});
+}
+
+void addRenderingBenchmarks(std::vector<BenchEntry>& benchmarks, bool gpu) {
+	// The walk and the occlusion test the renderer runs every frame,
+	// over a 16x16 chunk area seen from above the terrain.
+	benchmarks.push_back({"rendering/culling", [](Bench& bench) {
+		JobSystem jobs;
+		CullScene scene;
+		buildCullScene(scene, jobs);
+
+		Camera camera;
+		camera.position = glm::vec3(8.0f, 100.0f, 8.0f);
+		camera.pitch = -0.3f;
+		glm::mat4 viewProjection = camera.projection(CULL_ASPECT) * camera.view();
+		Frustum frustum(viewProjection);
+
+		std::vector<Occluder> occluders;
+		for (const auto& [pos, occluder] : scene.occluders) {
+			if (occluders.size() < MAX_OCCLUDERS) occluders.push_back(occluder);
+		}
+
+		LinearArena scratch;
+		std::vector<SectionPos> visible;
+		OcclusionCuller occlusion;
+
+		bench.run("walk", [&] {
+			scratch.reset();
+			scene.visibility.collect(camera.position, frustum, visible, scratch);
+			keep(visible);
+		}, 1.0, "frames");
+
+		bench.run("walk_occlusion", [&] {
+			scratch.reset();
+			scene.visibility.collect(camera.position, frustum, visible, scratch);
+			occlusion.render(viewProjection, occluders.data(), occluders.size(), jobs);
+			occlusion.cull(visible, jobs, scratch);
+			keep(visible);
+		}, 1.0, "frames");
+	}});
+
+	// Mixed sizes like section meshes, freed out of order so the free
+	// list splinters the way the mesh arena does.
+	benchmarks.push_back({"rendering/arena_allocator", [](Bench& bench) {
+		ArenaAllocator allocator(ARENA_CAPACITY);
+		std::mt19937 random(11);
+		std::uniform_int_distribution<uint32_t> size(1, 64);
+		std::vector<uint32_t> live;
+
+		bench.run([&] {
+			if (live.size() > 512 || (!live.empty() && random() % 2)) {
+				size_t i = random() % live.size();
+				allocator.free(live[i]);
+				live[i] = live.back();
+				live.pop_back();
+			} else if (std::optional<uint32_t> offset = allocator.allocate(size(random) * 64)) {
+				live.push_back(*offset);
+			}
+		});
+	}});
+
+	benchmarks.push_back({"rendering/linear_arena", [](Bench& bench) {
+		LinearArena arena;
+		bench.run([&] {
+			for (int i = 0; i < 64; i++) keep(arena.allocate(256, 16));
+			arena.reset();
+		}, 64.0, "allocations");
+	}});
+
+	benchmarks.push_back({"rendering/radix_sort", [](Bench& bench) {
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> coordinate(0.0f, static_cast<float>(SECTION_SIZE));
+		std::vector<glm::vec3> centers(SORT_QUADS);
+		for (glm::vec3& center : centers) center = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+
+		std::vector<uint32_t> keys(SORT_QUADS), scratch(SORT_QUADS);
+		std::vector<uint16_t> indices(SORT_QUADS * 6);
+		glm::vec3 eye(-20.0f, 30.0f, -10.0f);
+
+		bench.run([&] {
+			sortTranslucentQuads(centers.data(), SORT_QUADS, eye, keys.data(), scratch.data(), indices.data());
+			keep(indices);
+		}, SORT_QUADS, "quads");
+	}});
+
+	if (gpu) {
+		addGpuBenchmarks(benchmarks);
+	} else {
+		for (const char *name : {"gpu/create_buffer", "gpu/copy_buffer"}) {
+			benchmarks.push_back({name, [](Bench& bench) { bench.skip("needs --gpu"); }});
+		}
+	}
+}
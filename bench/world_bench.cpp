@@ -0,0 +1,173 @@
+#include "bench.hpp"
+#include <world/generator.hpp>
+#include <world/light.hpp>
+#include <world/query.hpp>
+#include <world/region.hpp>
+#include <world/ticks.hpp>
+#include <world/world.hpp>
+#include <rendering/mesher.hpp>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <random>
+
+const uint64_t BENCH_SEED = 0x5eed;
+const int REGION_BENCH_CHUNKS = 64;
+const size_t RAY_BATCH = 1024;
+
+void buildBenchWorld(World& world, int radius, JobSystem& jobs) {
+	TerrainGenerator generator(BENCH_SEED);
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	std::vector<Chunk *> targets;
+	for (int x = -radius; x < radius; x++) {
+		for (int z = -radius; z < radius; z++) {
+			chunks.push_back(std::make_unique<Chunk>(ChunkPos{x, z}));
+			targets.push_back(chunks.back().get());
+		}
+	}
+
+	generator.generate(targets, jobs);
+	for (std::unique_ptr<Chunk>& chunk : chunks) world.addChunk(std::move(chunk));
+	updateLight(world, jobs);
+}
+
+static std::vector<Ray> benchRays(glm::vec3 origin, float spread, float pitch, size_t count) {
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> offset(-spread, spread);
+	std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+	std::vector<Ray> rays(count);
+	for (Ray& ray : rays) {
+		float yaw = angle(random);
+		ray.origin = origin + glm::vec3(offset(random), 0.0f, offset(random));
+		ray.direction = glm::normalize(glm::vec3(std::sin(yaw) * std::cos(pitch), std::sin(pitch), -std::cos(yaw) * std::cos(pitch)));
+		ray.maxDistance = 64.0f;
+	}
+	return rays;
+}
+
+void addWorldBenchmarks(std::vector<BenchEntry>& benchmarks) {
+	benchmarks.push_back({"world/generate", [](Bench& bench) {
+		TerrainGenerator generator(BENCH_SEED);
+		int next = 0;
+		bench.run([&] {
+			Chunk chunk(ChunkPos{next++, 0});
+			generator.generate(chunk);
+			keep(chunk);
+		}, 1.0, "chunks");
+	}});
+
+	// One chunk's worth of height noise, the generator's hottest batch.
+	benchmarks.push_back({"world/noise_columns", [](Bench& bench) {
+		Noise noise(BENCH_SEED);
+		std::vector<float> x(SECTION_SIZE * SECTION_SIZE), z(x.size()), out(x.size());
+		for (size_t i = 0; i < x.size(); i++) {
+			x[i] = static_cast<float>(i % SECTION_SIZE);
+			z[i] = static_cast<float>(i / SECTION_SIZE);
+		}
+
+		bench.run(Noise::vectorized() ? "avx2" : "scalar", [&] {
+			std::fill(out.begin(), out.end(), 0.0f);
+			noise.fractal2D(x.data(), z.data(), x.size(), 6, 1.0f / 256.0f, out.data());
+			keep(out);
+		}, static_cast<double>(x.size()), "columns");
+	}});
+
+	benchmarks.push_back({"world/region", [](Bench& bench) {
+		JobSystem jobs;
+		TerrainGenerator generator(BENCH_SEED);
+		std::vector<std::unique_ptr<Chunk>> chunks;
+		std::vector<Chunk *> targets;
+		for (int i = 0; i < REGION_BENCH_CHUNKS; i++) {
+			chunks.push_back(std::make_unique<Chunk>(ChunkPos{i % REGION_SIZE, i / REGION_SIZE}));
+			targets.push_back(chunks.back().get());
+		}
+		generator.generate(targets, jobs);
+
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / "game_bench_region";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+
+		{
+			RegionStorage storage(directory);
+			bench.run("save", [&] {
+				for (const std::unique_ptr<Chunk>& chunk : chunks) storage.saveChunk(*chunk);
+			}, REGION_BENCH_CHUNKS, "chunks");
+
+			bench.run("load", [&] {
+				for (const std::unique_ptr<Chunk>& chunk : chunks) {
+					Chunk loaded(chunk->pos);
+					storage.loadChunk(chunk->pos, loaded);
+					keep(loaded);
+				}
+			}, REGION_BENCH_CHUNKS, "chunks");
+		}
+
+		std::filesystem::remove_all(directory);
+	}});
+
+	// Sparse rays start above the terrain and mostly cross open air,
+	// dense ones start underground and stop within a few blocks.
+	benchmarks.push_back({"world/raycast", [](Bench& bench) {
+		JobSystem jobs;
+		World world;
+		buildBenchWorld(world, 4, jobs);
+
+		std::vector<RayHit> hits(RAY_BATCH);
+		std::vector<Ray> sparse = benchRays(glm::vec3(0.0f, 150.0f, 0.0f), 48.0f, 0.1f, RAY_BATCH);
+		std::vector<Ray> dense = benchRays(glm::vec3(0.0f, 30.0f, 0.0f), 48.0f, 0.0f, RAY_BATCH);
+
+		bench.run("sparse", [&] {
+			raycast(world, sparse.data(), sparse.size(), hits.data());
+			keep(hits);
+		}, RAY_BATCH, "rays");
+		bench.run("dense", [&] {
+			raycast(world, dense.data(), dense.size(), hits.data());
+			keep(hits);
+		}, RAY_BATCH, "rays");
+	}});
+
+	// An idle tick over loaded terrain is only random ticks, so its cost
+	// follows the sections with grass rather than the chunk count.
+	benchmarks.push_back({"world/block_ticks", [](Bench& bench) {
+		JobSystem jobs;
+		World world;
+		buildBenchWorld(world, 8, jobs);
+		world.takeBlockEdits();
+
+		BlockTicker ticker(BENCH_SEED);
+		bench.run([&] {
+			ticker.tick(world, jobs);
+			world.takeLightEdits();
+			world.takeDirtySections();
+			keep(ticker.changes());
+		}, static_cast<double>(world.getTickingSections().size()), "sections");
+	}});
+
+	// A surface section has the most faces; the packed form is what the
+	// compute mesher reads instead.
+	benchmarks.push_back({"world/mesher", [](Bench& bench) {
+		JobSystem jobs;
+		World world;
+		buildBenchWorld(world, 1, jobs);
+
+		SectionPos pos{0, SEA_LEVEL / SECTION_SIZE, 0};
+		auto input = std::make_unique<MeshInput>();
+		SectionMesh mesh;
+		PackedSection packed;
+
+		bench.run("gather", [&] {
+			gatherSection(world, pos, *input);
+			keep(*input);
+		}, 1.0, "sections");
+		bench.run("mesh", [&] {
+			meshSection(*input, mesh);
+			keep(mesh);
+		}, 1.0, "sections");
+		bench.run("pack", [&] {
+			packSection(*input, packed);
+			keep(packed);
+		}, 1.0, "sections");
+	}});
+}
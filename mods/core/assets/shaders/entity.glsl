@@ -0,0 +1,41 @@
+#version 450
+
+// Draws every instance of one entity model. Models are built around the
+// entity's feet; instances carry where the last tick left them, and the
+// vertex moves them on by their velocity until the next tick arrives.
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec2 inLight;
+layout(location = 3) in vec4 inInstance;
+layout(location = 4) in vec4 inMotion;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// Seconds since the tick the instances were taken from.
+layout(push_constant) uniform PushConstants {
+    float elapsed;
+};
+
+void main() {
+    float yaw = inInstance.w;
+    float scale = inMotion.w;
+    vec3 local = inPosition * scale;
+    vec3 rotated = vec3(
+        local.x * cos(yaw) - local.z * sin(yaw),
+        local.y,
+        local.x * sin(yaw) + local.z * cos(yaw)
+    );
+
+    vec3 position = inInstance.xyz + inMotion.xyz * elapsed + rotated;
+    gl_Position = ubo.proj * ubo.view * vec4(position, 1.0);
+
+    float level = max(inLight.x, inLight.y);
+    float brightness = mix(0.05, 1.0, pow(0.8, 15.0 * (1.0 - level)));
+    fragColor = vec4(inColor.rgb * brightness, inColor.a);
+}
@@ -0,0 +1,131 @@
+#version 450
+
+// Meshes the opaque faces of packed sections, one invocation per block
+// and one row of workgroups per section. Faces and shades match the CPU
+// mesher; only the order of the quads differs.
+
+layout(local_size_x = 64) in;
+
+const int SIZE = 16;
+const int INPUT_SIZE = 18;
+const uint VERTEX_FLOATS = 9;
+const uint HEADER_WORDS = 8;
+const uint COMMAND_WORDS = 5;
+// Size of the block table; ids wrap like the CPU lookups do.
+const uint MAX_BLOCKS = 4096u;
+
+struct BlockInfo {
+    vec4 color;
+    uint opaque;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+// Headers, palettes, indices and light of every section in the batch,
+// at word offsets relative to inputOffset.
+layout(std430, binding = 0) readonly buffer Input {
+    uint words[];
+};
+
+layout(std430, binding = 1) readonly buffer Blocks {
+    BlockInfo blocks[];
+};
+
+layout(std430, binding = 2) writeonly buffer Vertices {
+    float vertices[];
+};
+
+// VkDrawIndexedIndirectCommand per section. indexCount starts at zero
+// and doubles as the section's quad counter.
+layout(std430, binding = 3) buffer Commands {
+    uint commands[];
+};
+
+layout(push_constant) uniform PushConstants {
+    uint inputOffset;
+};
+
+const ivec3 NORMALS[6] = ivec3[6](
+    ivec3(-1, 0, 0), ivec3(1, 0, 0),
+    ivec3(0, -1, 0), ivec3(0, 1, 0),
+    ivec3(0, 0, -1), ivec3(0, 0, 1)
+);
+
+const float SHADES[6] = float[6](0.8, 0.8, 0.5, 1.0, 0.7, 0.7);
+
+const ivec3 CORNERS[24] = ivec3[24](
+    ivec3(0, 0, 0), ivec3(0, 0, 1), ivec3(0, 1, 1), ivec3(0, 1, 0),
+    ivec3(1, 0, 0), ivec3(1, 1, 0), ivec3(1, 1, 1), ivec3(1, 0, 1),
+    ivec3(0, 0, 0), ivec3(1, 0, 0), ivec3(1, 0, 1), ivec3(0, 0, 1),
+    ivec3(0, 1, 0), ivec3(0, 1, 1), ivec3(1, 1, 1), ivec3(1, 1, 0),
+    ivec3(0, 0, 0), ivec3(0, 1, 0), ivec3(1, 1, 0), ivec3(1, 0, 0),
+    ivec3(0, 0, 1), ivec3(1, 0, 1), ivec3(1, 1, 1), ivec3(0, 1, 1)
+);
+
+uint header;
+
+uint field(uint index) {
+    return words[inputOffset + header + index];
+}
+
+uint cellIndex(ivec3 p) {
+    return uint(((p.y + 1) * INPUT_SIZE + (p.z + 1)) * INPUT_SIZE + (p.x + 1));
+}
+
+// Indices never straddle a word, so each cell is one shift and mask.
+uint blockAt(uint cell) {
+    uint bits = field(1);
+    uint perWord = 32u / bits;
+    uint word = words[inputOffset + field(2) + cell / perWord];
+    uint index = (word >> ((cell % perWord) * bits)) & ((1u << bits) - 1u);
+    return words[inputOffset + field(0) + index] & (MAX_BLOCKS - 1u);
+}
+
+uint lightAt(uint cell) {
+    return (words[inputOffset + field(3) + cell / 4u] >> ((cell % 4u) * 8u)) & 0xFFu;
+}
+
+void main() {
+    header = gl_WorkGroupID.y * HEADER_WORDS;
+
+    uint i = gl_GlobalInvocationID.x;
+    ivec3 p = ivec3(i % SIZE, i / (SIZE * SIZE), (i / SIZE) % SIZE);
+
+    uint id = blockAt(cellIndex(p));
+    if (blocks[id].opaque == 0u) return;
+
+    vec4 color = blocks[id].color;
+    uint vertexOffset = field(4);
+    uint command = field(5) * COMMAND_WORDS;
+    uint capacity = field(6);
+
+    for (int face = 0; face < 6; face++) {
+        uint neighbour = cellIndex(p + NORMALS[face]);
+        if (blocks[blockAt(neighbour)].opaque != 0u) continue;
+
+        uint quad = atomicAdd(commands[command], 6u) / 6u;
+        // Only reachable if the CPU face count disagrees with this
+        // shader; validation reports it.
+        if (quad >= capacity) continue;
+
+        // Faces take the light of the cell they face.
+        uint level = lightAt(neighbour);
+        vec2 light = vec2(float(level & 0xFu), float(level >> 4u)) / 15.0;
+        vec3 shaded = color.rgb * SHADES[face];
+
+        for (int corner = 0; corner < 4; corner++) {
+            vec3 position = vec3(p + CORNERS[face * 4 + corner]);
+            uint base = (vertexOffset + quad * 4u + uint(corner)) * VERTEX_FLOATS;
+            vertices[base + 0u] = position.x;
+            vertices[base + 1u] = position.y;
+            vertices[base + 2u] = position.z;
+            vertices[base + 3u] = shaded.r;
+            vertices[base + 4u] = shaded.g;
+            vertices[base + 5u] = shaded.b;
+            vertices[base + 6u] = color.a;
+            vertices[base + 7u] = light.x;
+            vertices[base + 8u] = light.y;
+        }
+    }
+}
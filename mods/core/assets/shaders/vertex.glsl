@@ -1,18 +1,35 @@
 #version 450
 
-layout(location = 0) in vec2 inPosition;
-layout(location = 1) in vec3 inColor;
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec2 inLight;
 
-layout(location = 0) out vec3 fragColor;
+layout(location = 0) out vec4 fragColor;
 
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
     mat4 view;
     mat4 proj;
 } ubo;
 
+struct DrawData {
+    vec4 origin;
+};
+
+layout(std430, binding = 1) readonly buffer DrawBuffer {
+    DrawData draws[];
+};
+
+layout(push_constant) uniform PushConstants {
+    uint drawIndex;
+};
+
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
-}
+    vec3 position = inPosition + draws[drawIndex].origin.xyz;
+    gl_Position = ubo.proj * ubo.view * vec4(position, 1.0);
 
+    // Light levels fall off geometrically, with a floor so unlit caves
+    // are not pitch black.
+    float level = max(inLight.x, inLight.y);
+    float brightness = mix(0.05, 1.0, pow(0.8, 15.0 * (1.0 - level)));
+    fragColor = vec4(inColor.rgb * brightness, inColor.a);
+}
@@ -19,6 +19,10 @@ fs::path getFilePath(Identifier id, AssetType ty) {
 	return fs::current_path() / ".." / "mods" / id.space / "assets" / assetDirectory / (id.name + assetExtension);
 }
 
+fs::path getWorldPath(std::string name) {
+	return fs::current_path() / ".." / "saves" / name;
+}
+
 std::vector<char> readFile(Identifier id, AssetType ty) {
 	auto filename = getFilePath(id, ty);
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
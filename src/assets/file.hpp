@@ -8,3 +8,4 @@
 
 std::filesystem::path getFilePath(Identifier id, AssetType ty);
 std::vector<char> readFile(Identifier id, AssetType ty);
+std::filesystem::path getWorldPath(std::string name);
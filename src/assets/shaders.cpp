@@ -11,6 +11,9 @@ std::vector<uint32_t> compileShader(Identifier id, ShaderType ty) {
 		case ShaderType::Fragment:
 			kind = shaderc_fragment_shader;
 			break;
+		case ShaderType::Compute:
+			kind = shaderc_compute_shader;
+			break;
 	}
 
 	shaderc::Compiler compiler;
@@ -7,7 +7,8 @@
 
 enum ShaderType {
 	Vertex,
-	Fragment
+	Fragment,
+	Compute
 };
 
 vk::ShaderModule createShaderModule(Identifier id, ShaderType ty, vk::Device device);
@@ -0,0 +1,58 @@
+#include <core/allocations.hpp>
+#include <cstdlib>
+#include <new>
+
+#if !defined(NDEBUG) || defined(COUNT_ALLOCATIONS)
+
+static thread_local uint64_t allocations = 0;
+static thread_local uint64_t allocatedBytes = 0;
+
+void *operator new(size_t size) {
+	allocations++;
+	allocatedBytes += size;
+	if (size == 0) size = 1;
+
+	for (;;) {
+		if (void *memory = std::malloc(size)) return memory;
+
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+void operator delete(void *memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+	std::free(memory);
+}
+
+uint64_t threadAllocations() {
+	return allocations;
+}
+
+uint64_t threadAllocatedBytes() {
+	return allocatedBytes;
+}
+
+bool allocationsCounted() {
+	return true;
+}
+
+#else
+
+uint64_t threadAllocations() {
+	return 0;
+}
+
+uint64_t threadAllocatedBytes() {
+	return 0;
+}
+
+bool allocationsCounted() {
+	return false;
+}
+
+#endif
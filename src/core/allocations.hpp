@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Global operator new calls made so far by the calling thread, and the
+// bytes they asked for. Debug builds, and any build configured with
+// COUNT_ALLOCATIONS, replace operator new to count them; other builds
+// leave the allocator alone and always report 0.
+uint64_t threadAllocations();
+uint64_t threadAllocatedBytes();
+bool allocationsCounted();
@@ -0,0 +1,30 @@
+#include <core/frame_arena.hpp>
+#include <algorithm>
+
+LinearArena::LinearArena(size_t capacity) : size(capacity) {
+	if (capacity > 0) block.reset(new std::byte[capacity]);
+}
+
+void *LinearArena::allocate(size_t bytes, size_t alignment) {
+	size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+	if (block && aligned + bytes <= size) {
+		offset = aligned + bytes;
+		return block.get() + aligned;
+	}
+
+	// new[] only guarantees fundamental alignment, which is all the
+	// containers using this need.
+	overflow.emplace_back(new std::byte[std::max<size_t>(bytes, 1)]);
+	overflowBytes += bytes;
+	return overflow.back().get();
+}
+
+void LinearArena::reset() {
+	if (overflowBytes > 0) {
+		size = std::max(size * 2, offset + overflowBytes + alignof(std::max_align_t) * overflow.size());
+		block.reset(new std::byte[size]);
+		overflow.clear();
+		overflowBytes = 0;
+	}
+	offset = 0;
+}
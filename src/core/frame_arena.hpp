@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator for memory that lives for one frame. Allocation moves a
+// pointer, freeing does nothing, and reset() releases everything at once.
+// Requests past the end spill into extra heap blocks; the next reset
+// replaces the block with one big enough for the whole frame, so a
+// steady frame stops touching the heap after the first few.
+class LinearArena {
+public:
+	LinearArena(size_t capacity = 0);
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	void *allocate(size_t size, size_t alignment);
+	void reset();
+
+	size_t capacity() const { return size; }
+	size_t used() const { return offset + overflowBytes; }
+private:
+	std::unique_ptr<std::byte[]> block;
+	size_t size = 0;
+	size_t offset = 0;
+	std::vector<std::unique_ptr<std::byte[]>> overflow;
+	size_t overflowBytes = 0;
+};
+
+// Standard allocator handing out memory from a LinearArena, for
+// containers that are thrown away with the frame.
+template <typename T>
+class FrameAllocator {
+public:
+	using value_type = T;
+
+	FrameAllocator(LinearArena& arena) : arena(&arena) {}
+	template <typename U>
+	FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+	T *allocate(size_t count) {
+		return static_cast<T *>(arena->allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	void deallocate(T *, size_t) {}
+
+	template <typename U>
+	bool operator==(const FrameAllocator<U>& other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const FrameAllocator<U>& other) const { return arena != other.arena; }
+private:
+	template <typename U>
+	friend class FrameAllocator;
+
+	LinearArena *arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
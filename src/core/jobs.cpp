@@ -0,0 +1,162 @@
+#include <core/jobs.hpp>
+#include <algorithm>
+
+void JobGroup::add() {
+	pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JobGroup::release() {
+	// Held across the decrement so a waiter that sees zero cannot destroy
+	// the group while this thread is still touching it.
+	std::lock_guard<std::mutex> lock(mutex);
+	if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		finished.notify_all();
+	}
+}
+
+void JobGroup::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this] { return done(); });
+}
+
+JobSystem::JobSystem(unsigned threads) {
+	threads = std::max(threads, 1u);
+	backgroundLimit = std::max(threads / 2, 1u);
+	for (unsigned i = 0; i < threads; i++) {
+		workers.emplace_back([this] { work(); });
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	available.notify_all();
+
+	for (auto& worker : workers) worker.join();
+}
+
+void JobSystem::submit(std::function<void()> job, JobGroup *group) {
+	if (group) group->add();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push({std::move(job), group});
+	}
+	available.notify_one();
+}
+
+void JobSystem::submitBackground(std::function<void()> job, JobGroup *group) {
+	if (group) group->add();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		background.push({std::move(job), group});
+	}
+	available.notify_one();
+}
+
+// Only takes regular jobs: a parallelFor waiting on a few microseconds
+// of work must not pick up a save that takes milliseconds.
+bool JobSystem::runOne() {
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (queue.size == 0) return false;
+		job = queue.pop();
+	}
+
+	job.run();
+	if (job.group) job.group->release();
+	return true;
+}
+
+void JobSystem::work() {
+	for (;;) {
+		Job job;
+		bool isBackground = false;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			auto canRunBackground = [this] { return background.size > 0 && backgroundRunning < backgroundLimit; };
+			// Queued background jobs still run once stopping, so the
+			// groups waiting on them finish.
+			available.wait(lock, [&] {
+				return queue.size > 0 || canRunBackground() || (stopping && background.size == 0);
+			});
+			if (queue.size > 0) {
+				job = queue.pop();
+			} else if (canRunBackground()) {
+				job = background.pop();
+				backgroundRunning++;
+				isBackground = true;
+			} else {
+				return;
+			}
+		}
+
+		job.run();
+		if (isBackground) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				backgroundRunning--;
+			}
+			available.notify_one();
+		}
+		if (job.group) job.group->release();
+	}
+}
+
+// Called with the mutex held.
+void JobSystem::JobQueue::push(Job job) {
+	if (size == jobs.size()) {
+		std::vector<Job> grown(std::max<size_t>(jobs.size() * 2, 64));
+		for (size_t i = 0; i < size; i++) {
+			grown[i] = std::move(jobs[(head + i) % jobs.size()]);
+		}
+		jobs = std::move(grown);
+		head = 0;
+	}
+
+	jobs[(head + size) % jobs.size()] = std::move(job);
+	size++;
+}
+
+// Called with the mutex held and the queue not empty.
+JobSystem::Job JobSystem::JobQueue::pop() {
+	Job job = std::move(jobs[head]);
+	head = (head + 1) % jobs.size();
+	size--;
+	return job;
+}
+
+struct ParallelRange {
+	void (*call)(const void *, size_t);
+	const void *body;
+	size_t count;
+	size_t batches;
+};
+
+void JobSystem::forRange(size_t count, void (*call)(const void *, size_t), const void *body) {
+	if (count == 0) return;
+
+	// The calling thread helps drain the queue while it waits, so nested
+	// parallelFor calls from inside a job cannot starve the pool. Each job
+	// captures only a pointer and its batch number, which std::function
+	// stores inline without allocating.
+	JobGroup group;
+	ParallelRange range = {call, body, count, std::min<size_t>(count, workers.size() * 4)};
+	for (size_t b = 0; b < range.batches; b++) {
+		const ParallelRange *shared = &range;
+		submit([shared, b] {
+			size_t begin = shared->count * b / shared->batches;
+			size_t end = shared->count * (b + 1) / shared->batches;
+			for (size_t i = begin; i < end; i++) shared->call(shared->body, i);
+		}, &group);
+	}
+
+	while (!group.done()) {
+		if (!runOne()) std::this_thread::yield();
+	}
+	group.wait();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts outstanding jobs so a caller can wait for just the work it
+// submitted instead of draining the whole pool.
+class JobGroup {
+public:
+	void wait();
+	bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+private:
+	friend class JobSystem;
+
+	std::atomic<size_t> pending{0};
+	std::mutex mutex;
+	std::condition_variable finished;
+
+	void add();
+	void release();
+};
+
+class JobSystem {
+public:
+	JobSystem(unsigned threads = std::thread::hardware_concurrency());
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void submit(std::function<void()> job, JobGroup *group = nullptr);
+	// For long work off the tick, like saves. Background jobs only run
+	// when no other job is queued, on at most half the workers, and never
+	// on a thread waiting in parallelFor.
+	void submitBackground(std::function<void()> job, JobGroup *group = nullptr);
+	// Runs body(i) for every i below count and returns once all are done.
+	// The body is only referenced, never copied into a std::function, so
+	// no capture is too big to run without allocating.
+	template <typename F>
+	void parallelFor(size_t count, const F& body) {
+		forRange(count, [](const void *body, size_t i) { (*static_cast<const F *>(body))(i); }, &body);
+	}
+	unsigned threadCount() const { return static_cast<unsigned>(workers.size()); }
+private:
+	struct Job {
+		std::function<void()> run;
+		JobGroup *group;
+	};
+
+	// Ring buffer rather than a deque, so a steady stream of jobs reuses
+	// the same storage instead of allocating blocks as it moves.
+	struct JobQueue {
+		std::vector<Job> jobs;
+		size_t head = 0;
+		size_t size = 0;
+
+		void push(Job job);
+		Job pop();
+	};
+
+	std::vector<std::thread> workers;
+	JobQueue queue;
+	JobQueue background;
+	unsigned backgroundRunning = 0;
+	unsigned backgroundLimit = 1;
+	std::mutex mutex;
+	std::condition_variable available;
+	bool stopping = false;
+
+	void forRange(size_t count, void (*call)(const void *, size_t), const void *body);
+	void work();
+	bool runOne();
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+// Bounded lock-free queue for exactly one producer and one consumer
+// thread. Head and tail sit on separate cache lines so the two sides do
+// not contend. push fails instead of blocking when the queue is full and
+// leaves the value untouched, so the producer can retry with it later.
+template <typename T, size_t Capacity>
+class SpscQueue {
+	static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+public:
+	template <typename U>
+	bool push(U&& value) {
+		size_t tail = tailIndex.load(std::memory_order_relaxed);
+		if (tail - headCache == Capacity) {
+			headCache = headIndex.load(std::memory_order_acquire);
+			if (tail - headCache == Capacity) return false;
+		}
+
+		slots[tail & (Capacity - 1)] = std::forward<U>(value);
+		tailIndex.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::optional<T> pop() {
+		size_t head = headIndex.load(std::memory_order_relaxed);
+		if (head == tailCache) {
+			tailCache = tailIndex.load(std::memory_order_acquire);
+			if (head == tailCache) return std::nullopt;
+		}
+
+		std::optional<T> value(std::move(slots[head & (Capacity - 1)]));
+		headIndex.store(head + 1, std::memory_order_release);
+		return value;
+	}
+private:
+	T slots[Capacity];
+
+	alignas(64) std::atomic<size_t> tailIndex{0};
+	size_t headCache = 0;
+
+	alignas(64) std::atomic<size_t> headIndex{0};
+	size_t tailCache = 0;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+// Single-writer, single-reader latest-value exchange. The writer fills
+// its back slot and publishes it by swapping with the middle slot; the
+// reader swaps the middle slot into its front slot only when something
+// new was published. Neither side ever waits, and the reader always sees
+// the most recent complete value.
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const T& initial) : slots{initial, initial, initial} {}
+
+	T& back() { return slots[backIndex]; }
+
+	void publish() {
+		uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel);
+		backIndex = previous & INDEX;
+	}
+
+	// Returns true when the front slot was replaced by a newer value.
+	bool update() {
+		if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+		uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+		frontIndex = previous & INDEX;
+		return true;
+	}
+
+	const T& front() const { return slots[frontIndex]; }
+private:
+	static constexpr uint8_t INDEX = 0x3;
+	static constexpr uint8_t FRESH = 0x4;
+
+	T slots[3] = {};
+	uint8_t backIndex = 0;
+	std::atomic<uint8_t> middle{1};
+	uint8_t frontIndex = 2;
+};
@@ -1,23 +1,445 @@
 #include <iostream>
 #include <rendering/window.hpp>
 #include <rendering/renderer.hpp>
+#include <rendering/flythrough.hpp>
 #include <assets/file.hpp>
 #include <assets/assets.hpp>
 #include <assets/shaders.hpp>
+#include <core/jobs.hpp>
+#include <core/spsc_queue.hpp>
+#include <core/triple_buffer.hpp>
+#include <net/client.hpp>
+#include <world/entities.hpp>
+#include <world/generator.hpp>
+#include <world/light.hpp>
+#include <world/region.hpp>
+#include <world/saver.hpp>
+#include <world/ticks.hpp>
+#include <world/world.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main()
-{
-	Window window("Game", 800, 600);
-	Renderer renderer(window);
+const auto AUTOSAVE_INTERVAL = std::chrono::minutes(5);
+const int SPAWN_RADIUS = 8;
 
-	compileShader(Identifier("core", "vertex"), ShaderType::Vertex);
+const auto TICK_LENGTH = std::chrono::duration<double>(1.0 / 30.0);
+// Ticks the simulation may fall behind before it drops them instead of
+// trying to catch up.
+const int MAX_TICK_BACKLOG = 5;
+const float MOVE_SPEED = 20.0f;
+const float TURN_SPEED = 1.5f;
+const size_t MESH_QUEUE_SIZE = 16;
+const float MOB_SPEED = 2.0f;
+const float ITEM_SPIN = 2.0f;
+const float PARTICLE_LIFETIME = 4.0f;
+// Simulated time between flythrough frames, whatever the real frame took.
+const float FLYTHROUGH_STEP = 1.0f / 60.0f;
+const float ORBIT_RADIUS = 80.0f;
+const float ORBIT_HEIGHT = 100.0f;
 
-	while (!window.shouldClose()) {
+// Everything the render thread needs from one simulation tick: the
+// camera before and after it, the entities after it, and when it was
+// due.
+struct FrameSnapshot {
+	CameraState previous;
+	CameraState current;
+	EntityInstances entities;
+	std::chrono::steady_clock::time_point time;
+};
+
+// State shared by the simulation and render threads. Snapshots only need
+// the latest value, mesh batches must all arrive in order.
+struct ThreadShared {
+	std::atomic<bool> running{true};
+	TripleBuffer<FrameSnapshot> frames;
+	SpscQueue<std::unique_ptr<MeshBatch>, MESH_QUEUE_SIZE> meshes;
+	// Sections the renderer evicted under memory pressure and now has
+	// room for again; the simulation marks them dirty to remesh them.
+	std::mutex restoreMutex;
+	std::vector<SectionPos> restored;
+};
+
+// Chunk times, if asked for, are how long each chunk took to load or
+// generate.
+static void loadSpawn(World& world, RegionStorage& storage, const TerrainGenerator& generator, JobSystem& jobs, std::vector<double> *chunkMilliseconds = nullptr) {
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	for (int x = -SPAWN_RADIUS; x < SPAWN_RADIUS; x++) {
+		for (int z = -SPAWN_RADIUS; z < SPAWN_RADIUS; z++) {
+			chunks.push_back(std::make_unique<Chunk>(ChunkPos{x, z}));
+		}
+	}
+
+	std::vector<char> generated(chunks.size(), 0);
+	std::vector<double> milliseconds(chunks.size());
+	jobs.parallelFor(chunks.size(), [&](size_t i) {
+		auto start = std::chrono::steady_clock::now();
+		if (!storage.loadChunk(chunks[i]->pos, *chunks[i])) {
+			generator.generate(*chunks[i]);
+			generated[i] = 1;
+		}
+		milliseconds[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	});
+	if (chunkMilliseconds) *chunkMilliseconds = milliseconds;
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		if (generated[i]) world.markUnsaved(chunks[i]->pos);
+		world.addChunk(std::move(chunks[i]));
+	}
+}
+
+static int surfaceHeight(const World& world, int x, int z) {
+	for (int y = CHUNK_HEIGHT - 1; y > 0; y--) {
+		if (isSolid(world.getBlock(x, y, z))) return y + 1;
+	}
+	return CHUNK_HEIGHT;
+}
+
+// Scatters walking mobs, spinning items and short-lived particles over
+// the spawn area to exercise the entity path.
+static void spawnDemoEntities(EntityStore& store, const World& world, size_t count) {
+	std::mt19937 random(static_cast<uint32_t>(WORLD_SEED));
+	std::uniform_real_distribution<float> coordinate(-SPAWN_RADIUS * SECTION_SIZE + 1.0f, SPAWN_RADIUS * SECTION_SIZE - 1.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+	std::uniform_real_distribution<float> spread(0.5f, 1.0f);
+
+	for (size_t i = 0; i < count; i++) {
+		EntityDesc desc;
+		desc.position.x = coordinate(random);
+		desc.position.z = coordinate(random);
+		desc.position.y = static_cast<float>(surfaceHeight(world, static_cast<int>(std::floor(desc.position.x)), static_cast<int>(std::floor(desc.position.z))));
+		desc.yaw = angle(random);
+
+		switch (i % 3) {
+			case 0:
+				desc.mask = COMPONENT_POSITION | COMPONENT_VELOCITY | COMPONENT_YAW;
+				desc.model = EntityModel::Mob;
+				desc.velocity = glm::vec3(std::sin(desc.yaw), 0.0f, -std::cos(desc.yaw)) * MOB_SPEED;
+				break;
+			case 1:
+				desc.mask = COMPONENT_POSITION | COMPONENT_VELOCITY | COMPONENT_YAW | COMPONENT_SPIN;
+				desc.model = EntityModel::Item;
+				desc.spin = ITEM_SPIN;
+				break;
+			default:
+				desc.mask = COMPONENT_POSITION | COMPONENT_VELOCITY | COMPONENT_LIFETIME;
+				desc.model = EntityModel::Particle;
+				desc.position.y += 4.0f;
+				desc.velocity = glm::vec3(std::cos(desc.yaw), 6.0f, std::sin(desc.yaw));
+				desc.lifetime = PARTICLE_LIFETIME * spread(random);
+				break;
+		}
+
+		store.spawn(desc);
+	}
+}
+
+static void moveCamera(CameraState& camera, const std::array<bool, GLFW_KEY_LAST + 1>& held, float dt) {
+	if (held[GLFW_KEY_LEFT]) camera.yaw -= TURN_SPEED * dt;
+	if (held[GLFW_KEY_RIGHT]) camera.yaw += TURN_SPEED * dt;
+	if (held[GLFW_KEY_UP]) camera.pitch += TURN_SPEED * dt;
+	if (held[GLFW_KEY_DOWN]) camera.pitch -= TURN_SPEED * dt;
+	camera.pitch = std::clamp(camera.pitch, -1.5f, 1.5f);
+
+	glm::vec3 forward(std::sin(camera.yaw), 0.0f, -std::cos(camera.yaw));
+	glm::vec3 right(std::cos(camera.yaw), 0.0f, std::sin(camera.yaw));
+	glm::vec3 motion(0.0f);
+	if (held[GLFW_KEY_W]) motion += forward;
+	if (held[GLFW_KEY_S]) motion -= forward;
+	if (held[GLFW_KEY_D]) motion += right;
+	if (held[GLFW_KEY_A]) motion -= right;
+	if (held[GLFW_KEY_SPACE]) motion.y += 1.0f;
+	if (held[GLFW_KEY_LEFT_SHIFT]) motion.y -= 1.0f;
+	camera.position += motion * (MOVE_SPEED * dt);
+}
+
+// Runs at a fixed rate regardless of frame rate. It owns the world: all
+// edits, block updates, lighting, meshing and saving happen here, and the
+// renderer only sees the finished meshes.
+// Recording, if given, gets a keyframe every KEYFRAME_INTERVAL.
+// Connected to a server, the client streams the world in around the
+// camera instead, and the server does the saving.
+static void simulate(Window& window, World& world, WorldSaver *saver, ChunkClient *client, JobSystem& jobs, ThreadShared& shared, MeshBackend backend, size_t entityCount, CameraPath *recording) {
+	std::array<bool, GLFW_KEY_LAST + 1> held = {};
+	EntityStore entities;
+	spawnDemoEntities(entities, world, entityCount);
+	BlockTicker ticker(WORLD_SEED);
+	CameraState camera = shared.frames.back().current;
+	std::unique_ptr<MeshBatch> pending;
+
+	auto nextTick = std::chrono::steady_clock::now();
+	auto lastSave = nextTick;
+	float dt = static_cast<float>(TICK_LENGTH.count());
+	uint64_t ticksPerKeyframe = static_cast<uint64_t>(std::lround(KEYFRAME_INTERVAL / dt));
+	uint64_t tick = 0;
+	bool connected = true;
+
+	while (shared.running) {
+		while (std::optional<InputEvent> event = window.input.pop()) {
+			if (event->type == InputType::Key && event->key >= 0 && event->key <= GLFW_KEY_LAST) {
+				held[event->key] = event->action != GLFW_RELEASE;
+			}
+		}
+
+		CameraState previous = camera;
+		moveCamera(camera, held, dt);
+		if (recording && tick++ % ticksPerKeyframe == 0) recording->add(camera);
+		if (client && connected) {
+			ChunkPos center = chunkOf(static_cast<int>(std::floor(camera.position.x)), static_cast<int>(std::floor(camera.position.z)));
+			try {
+				connected = client->update(world, center);
+			} catch (std::exception & err) {
+				std::cout << "std::exception: " << err.what() << std::endl;
+				connected = false;
+			}
+			if (!connected) std::cout << "lost connection to server" << std::endl;
+		}
+		// The server runs block updates for the worlds it streams.
+		if (client) {
+			world.takeBlockEdits();
+		} else {
+			ticker.tick(world, jobs);
+		}
+		updateLight(world, jobs);
+		updateEntities(entities, world, jobs, dt);
+		{
+			std::lock_guard<std::mutex> lock(shared.restoreMutex);
+			for (SectionPos pos : shared.restored) world.markSectionDirty(pos);
+			shared.restored.clear();
+		}
+
+		// A full queue leaves the batch pending; later edits stay dirty in
+		// the world until it drains.
+		if (!pending) {
+			pending = std::make_unique<MeshBatch>();
+			meshDirtySections(world, jobs, *pending, backend);
+			if (pending->positions.empty()) pending.reset();
+		}
+		if (pending) shared.meshes.push(std::move(pending));
+
+		FrameSnapshot& frame = shared.frames.back();
+		frame.previous = previous;
+		frame.current = camera;
+		frame.time = nextTick;
+		extractInstances(entities, jobs, frame.entities);
+		shared.frames.publish();
+
+		auto now = std::chrono::steady_clock::now();
+		if (saver && now - lastSave >= AUTOSAVE_INTERVAL && saver->snapshot(world)) {
+			lastSave = now;
+		}
+
+		nextTick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(TICK_LENGTH);
+		if (now - nextTick > TICK_LENGTH * MAX_TICK_BACKLOG) nextTick = now;
+		std::this_thread::sleep_until(nextTick);
+	}
+}
+
+// Draws as fast as presentation allows, blending the two most recent
+// simulation ticks by how far the current time is past the newer one.
+static void render(Window& window, Renderer& renderer, ThreadShared& shared) {
+	MeshBatch empty;
+
+	while (shared.running) {
+		bool updated = false;
+		while (std::optional<std::unique_ptr<MeshBatch>> batch = shared.meshes.pop()) {
+			renderer.updateMeshes(**batch);
+			updated = true;
+		}
+		if (!updated) renderer.updateMeshes(empty);
+		{
+			std::lock_guard<std::mutex> lock(shared.restoreMutex);
+			renderer.takeRestored(shared.restored);
+		}
+
+		shared.frames.update();
+		const FrameSnapshot& frame = shared.frames.front();
+		float t = static_cast<float>((std::chrono::steady_clock::now() - frame.time) / TICK_LENGTH);
+		CameraState::lerp(frame.previous, frame.current, std::clamp(t, 0.0f, 1.0f)).apply(renderer.camera);
+		// Entities are extrapolated from the newer tick instead, so they
+		// never lag a tick behind the world around them.
+		renderer.setEntities(&frame.entities, static_cast<float>(std::clamp(t, 0.0f, 1.0f) * TICK_LENGTH.count()));
+
+		renderer.tick(window);
+	}
+
+	renderer.end();
+}
+
+// Flies the camera along path for a fixed number of frames on the main
+// thread, advancing simulated time by FLYTHROUGH_STEP per frame, so two
+// runs over the same world draw the same frames.
+static void flythrough(Window& window, Renderer& renderer, World& world, JobSystem& jobs, const CameraPath& path, uint64_t frames, MeshBackend backend, FlythroughReport& report) {
+	MeshBatch batch;
+	std::vector<SectionPos> restored;
+	bool ready = false;
+	auto start = std::chrono::steady_clock::now();
+	auto last = start;
+
+	for (uint64_t frame = 0; frame < frames && !window.shouldClose(); frame++) {
 		window.tick();
+
+		updateLight(world, jobs);
+		batch = MeshBatch();
+		meshDirtySections(world, jobs, batch, backend);
+		renderer.updateMeshes(batch);
+		renderer.takeRestored(restored);
+		for (SectionPos pos : restored) world.markSectionDirty(pos);
+		restored.clear();
+
+		path.sample(frame * FLYTHROUGH_STEP).apply(renderer.camera);
 		renderer.tick(window);
+
+		auto now = std::chrono::steady_clock::now();
+		report.frameMilliseconds.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+		last = now;
+
+		if (!ready && world.dirtySectionCount() == 0) {
+			report.worldReadyMilliseconds = std::chrono::duration<double, std::milli>(now - start).count();
+			ready = true;
+		}
 	}
 
 	renderer.end();
+	report.step = FLYTHROUGH_STEP;
+	report.peakCpuBytes = peakResidentBytes();
+	report.peakDeviceBytes = renderer.deviceMemoryPeak();
+	const MemoryCounters& memory = renderer.memoryCounters();
+	for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+		report.deviceCategoryBytes.emplace_back(memoryCategoryName(static_cast<MemoryCategory>(i)), memory.categories[i]);
+	}
+	report.memoryFallbacks = memory.fallbacks;
+	report.evictedSections = renderer.evictedSections();
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 3 && std::string(argv[1]) == "--compact") {
+		RegionStorage(argv[2]).compact();
+		return 0;
+	}
+
+	bool dynamicResolution = false;
+	MeshBackend meshBackend = MeshBackend::Cpu;
+	size_t entityCount = 0;
+	uint64_t flythroughFrames = 0;
+	std::string flythroughOutput = "flythrough.json";
+	std::string pathFile;
+	std::string recordFile;
+	std::string serverAddress;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		// Benchmark mode: renders a fixed number of frames along a camera
+		// path over a freshly generated world, then writes a report.
+		if (arg == "--flythrough" && i + 1 < argc) flythroughFrames = std::stoull(argv[++i]);
+		if (arg == "--flythrough-output" && i + 1 < argc) flythroughOutput = argv[++i];
+		// Path for the flythrough, as written by --record-path.
+		if (arg == "--path" && i + 1 < argc) pathFile = argv[++i];
+		if (arg == "--record-path" && i + 1 < argc) recordFile = argv[++i];
+		// Plays on a game_server instead of a local world.
+		if (arg == "--connect" && i + 1 < argc) serverAddress = argv[++i];
+		if (arg == "--entities" && i + 1 < argc) entityCount = std::stoul(argv[++i]);
+		if (arg == "--dynamic-resolution") dynamicResolution = true;
+		if (arg == "--gpu-meshing") meshBackend = MeshBackend::Gpu;
+		// Meshes on both and reports any section where they disagree.
+		if (arg == "--validate-gpu-meshing") meshBackend = MeshBackend::GpuValidated;
+	}
+
+	// Mods register their blocks before this; ids are fixed from here on.
+	freezeBlocks();
+
+	JobSystem jobs;
+	Window window("Game", 800, 600, flythroughFrames == 0);
+	Renderer renderer(window, jobs);
+	renderer.setDynamicResolution(dynamicResolution);
+
+	compileShader(Identifier("core", "vertex"), ShaderType::Vertex);
+
+	if (flythroughFrames > 0) {
+		CameraPath path = CameraPath::orbit(ORBIT_RADIUS, ORBIT_HEIGHT);
+		try {
+			if (!pathFile.empty()) path = CameraPath::load(pathFile);
+		} catch (std::exception & err) {
+			std::cout << "std::exception: " << err.what() << std::endl;
+			exit(-1);
+		}
+
+		// Generated from the seed every time; nothing is saved.
+		std::filesystem::path worldPath = getWorldPath("flythrough");
+		std::filesystem::remove_all(worldPath);
+
+		FlythroughReport report;
+		report.seed = WORLD_SEED;
+		{
+			World world;
+			RegionStorage storage(worldPath);
+			TerrainGenerator generator(WORLD_SEED);
+			loadSpawn(world, storage, generator, jobs, &report.chunkMilliseconds);
+			flythrough(window, renderer, world, jobs, path, flythroughFrames, meshBackend, report);
+		}
+		std::filesystem::remove_all(worldPath);
+
+		try {
+			writeFlythroughReport(flythroughOutput, report);
+		} catch (std::exception & err) {
+			std::cout << "std::exception: " << err.what() << std::endl;
+			exit(-1);
+		}
+		std::cout << "wrote " << flythroughOutput << std::endl;
+		return 0;
+	}
+
+	World world;
+	std::unique_ptr<RegionStorage> storage;
+	std::unique_ptr<WorldSaver> saver;
+	std::unique_ptr<ChunkClient> client;
+	if (serverAddress.empty()) {
+		storage = std::make_unique<RegionStorage>(getWorldPath("world"));
+		saver = std::make_unique<WorldSaver>(*storage, jobs);
+		TerrainGenerator generator(WORLD_SEED);
+		loadSpawn(world, *storage, generator, jobs);
+	} else {
+		try {
+			client = std::make_unique<ChunkClient>(serverAddress, static_cast<uint8_t>(SPAWN_RADIUS));
+		} catch (std::exception & err) {
+			std::cout << "std::exception: " << err.what() << std::endl;
+			exit(-1);
+		}
+	}
+
+	ThreadShared shared;
+	CameraPath recording;
+	shared.frames.back().time = std::chrono::steady_clock::now();
+	shared.frames.publish();
+
+	std::thread simulation(simulate, std::ref(window), std::ref(world), saver.get(), client.get(), std::ref(jobs), std::ref(shared), meshBackend, entityCount, recordFile.empty() ? nullptr : &recording);
+	std::thread rendering(render, std::ref(window), std::ref(renderer), std::ref(shared));
+
+	// GLFW only allows event handling on the main thread.
+	while (!window.shouldClose()) {
+		window.waitEvents(0.01);
+	}
+
+	shared.running = false;
+	simulation.join();
+	rendering.join();
+	if (saver) saver->flush(world);
+	try {
+		if (!recordFile.empty()) recording.save(recordFile);
+	} catch (std::exception & err) {
+		std::cout << "std::exception: " << err.what() << std::endl;
+		exit(-1);
+	}
 
 	return 0;
 }
@@ -0,0 +1,80 @@
+#include <net/client.hpp>
+#include <stdexcept>
+
+void ChunkReceiver::apply(const Message& message, World& world) {
+	counts.messages++;
+
+	switch (message.type) {
+		case MessageType::ChunkData: {
+			auto chunk = std::make_unique<Chunk>(ChunkPos{0, 0});
+			readChunkData(message, *chunk);
+			world.addChunk(std::move(chunk));
+			counts.chunks++;
+			break;
+		}
+		case MessageType::SectionData: {
+			Section section;
+			SectionPos pos = readSectionData(message, section);
+			const Chunk *current = world.getChunk({pos.x, pos.z});
+			if (!current || pos.y < 0 || pos.y >= SECTIONS_PER_CHUNK) break;
+
+			// Re-adding a copy with the new section rebuilds occupancy and
+			// light like a freshly loaded chunk; the copy shares the rest.
+			auto chunk = std::make_unique<Chunk>(*current);
+			chunk->sections[pos.y] = section;
+			world.addChunk(std::move(chunk));
+			counts.sections++;
+			break;
+		}
+		case MessageType::BlockChanges: {
+			readBlockChanges(message, batch);
+			int baseX = batch.pos.x * SECTION_SIZE;
+			int baseY = batch.pos.y * SECTION_SIZE;
+			int baseZ = batch.pos.z * SECTION_SIZE;
+			for (const auto& [index, id] : batch.changes) {
+				int x = index % SECTION_SIZE;
+				int z = index / SECTION_SIZE % SECTION_SIZE;
+				int y = index / (SECTION_SIZE * SECTION_SIZE);
+				world.setBlock(baseX + x, baseY + y, baseZ + z, id);
+			}
+			counts.blockChanges += batch.changes.size();
+			break;
+		}
+		case MessageType::UnloadChunk:
+			world.removeChunk(readUnloadChunk(message));
+			counts.unloads++;
+			break;
+		default:
+			break;
+	}
+}
+
+ChunkClient::ChunkClient(const std::string& address, uint8_t viewRadius) {
+	socket = Connection::connect(address);
+	writeHello(socket->output(), viewRadius);
+	if (!socket->flush()) throw std::runtime_error("lost connection to " + address);
+}
+
+bool ChunkClient::update(World& world, ChunkPos center) {
+	if (!reported || *reported != center) {
+		writePosition(socket->output(), center);
+		reported = center;
+	}
+
+	socket->flush();
+	socket->receive();
+	while (std::optional<Message> message = socket->next()) {
+		if (message->type == MessageType::Welcome) {
+			WelcomeMessage welcome = readWelcome(*message);
+			if (welcome.version != PROTOCOL_VERSION) throw std::runtime_error("server speaks protocol " + std::to_string(welcome.version));
+			serverSeed = welcome.seed;
+			continue;
+		}
+		receiver.apply(*message, world);
+	}
+	return socket->open();
+}
+
+void ChunkClient::setBlock(int32_t x, int32_t y, int32_t z, BlockId id) {
+	writeSetBlock(socket->output(), x, y, z, id);
+}
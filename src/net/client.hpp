@@ -0,0 +1,53 @@
+#pragma once
+
+#include <net/protocol.hpp>
+#include <net/socket.hpp>
+#include <world/world.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+// What a client has taken in, for the load generator and logs.
+struct ClientStats {
+	uint64_t chunks = 0;
+	uint64_t sections = 0;
+	uint64_t blockChanges = 0;
+	uint64_t unloads = 0;
+	uint64_t messages = 0;
+};
+
+// Applies server messages to the client's copy of the world. Everything
+// goes through World, so received chunks and edits mark their sections
+// dirty and reach the mesher like local changes do.
+class ChunkReceiver {
+public:
+	// Throws std::runtime_error on a malformed payload.
+	void apply(const Message& message, World& world);
+	const ClientStats& stats() const { return counts; }
+private:
+	BlockChangeBatch batch;
+	ClientStats counts;
+};
+
+// The game's end of a server connection: says hello, reports which
+// chunk the player is in, and feeds what comes back into the world.
+class ChunkClient {
+public:
+	// Connects and sends the hello; throws std::runtime_error on failure.
+	ChunkClient(const std::string& address, uint8_t viewRadius);
+
+	// Sends the position when it crossed into another chunk, then applies
+	// every complete message. Returns false once the server is gone.
+	bool update(World& world, ChunkPos center);
+	void setBlock(int32_t x, int32_t y, int32_t z, BlockId id);
+
+	std::optional<uint64_t> seed() const { return serverSeed; }
+	const ClientStats& stats() const { return receiver.stats(); }
+	const Connection& connection() const { return *socket; }
+private:
+	std::unique_ptr<Connection> socket;
+	ChunkReceiver receiver;
+	std::optional<ChunkPos> reported;
+	std::optional<uint64_t> serverSeed;
+};
@@ -0,0 +1,243 @@
+#include <net/protocol.hpp>
+#include <world/chunk_codec.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+const size_t FRAME_HEADER_SIZE = sizeof(uint32_t) + 1;
+
+template<typename T>
+static void put(std::vector<uint8_t>& out, T value) {
+	uint8_t bytes[sizeof(T)];
+	memcpy(bytes, &value, sizeof(T));
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+static T take(const uint8_t *&ip, const uint8_t *end) {
+	if (static_cast<size_t>(end - ip) < sizeof(T)) {
+		throw std::runtime_error("truncated message!");
+	}
+
+	T value;
+	memcpy(&value, ip, sizeof(T));
+	ip += sizeof(T);
+	return value;
+}
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+static uint32_t takeVarint(const uint8_t *&ip, const uint8_t *end) {
+	uint32_t value = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		uint8_t byte = take<uint8_t>(ip, end);
+		value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) return value;
+	}
+	throw std::runtime_error("varint too long!");
+}
+
+// The length is patched in by endFrame once the payload is written.
+static size_t beginFrame(std::vector<uint8_t>& out, MessageType type) {
+	size_t start = out.size();
+	put<uint32_t>(out, 0);
+	put<uint8_t>(out, static_cast<uint8_t>(type));
+	return start;
+}
+
+static void endFrame(std::vector<uint8_t>& out, size_t start) {
+	uint32_t length = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+	memcpy(out.data() + start, &length, sizeof(length));
+}
+
+static void expect(const Message& message, MessageType type) {
+	if (message.type != type) throw std::runtime_error("unexpected message type!");
+}
+
+bool parseFrame(const uint8_t *data, size_t size, Message& message, size_t& consumed) {
+	if (size < FRAME_HEADER_SIZE) return false;
+
+	uint32_t length;
+	memcpy(&length, data, sizeof(length));
+	if (length == 0 || length > MAX_FRAME_SIZE) throw std::runtime_error("invalid frame length!");
+	if (size < sizeof(uint32_t) + length) return false;
+
+	message.type = static_cast<MessageType>(data[sizeof(uint32_t)]);
+	message.data = data + FRAME_HEADER_SIZE;
+	message.size = length - 1;
+	consumed = sizeof(uint32_t) + length;
+	return true;
+}
+
+void writeHello(std::vector<uint8_t>& out, uint8_t viewRadius) {
+	size_t frame = beginFrame(out, MessageType::Hello);
+	put<uint32_t>(out, PROTOCOL_VERSION);
+	put<uint8_t>(out, viewRadius);
+	endFrame(out, frame);
+}
+
+void writePosition(std::vector<uint8_t>& out, ChunkPos pos) {
+	size_t frame = beginFrame(out, MessageType::Position);
+	put<int32_t>(out, pos.x);
+	put<int32_t>(out, pos.z);
+	endFrame(out, frame);
+}
+
+void writeSetBlock(std::vector<uint8_t>& out, int32_t x, int32_t y, int32_t z, BlockId id) {
+	size_t frame = beginFrame(out, MessageType::SetBlock);
+	put<int32_t>(out, x);
+	put<int32_t>(out, y);
+	put<int32_t>(out, z);
+	put<BlockId>(out, id);
+	endFrame(out, frame);
+}
+
+void writeWelcome(std::vector<uint8_t>& out, uint64_t seed) {
+	size_t frame = beginFrame(out, MessageType::Welcome);
+	put<uint32_t>(out, PROTOCOL_VERSION);
+	put<uint64_t>(out, seed);
+	endFrame(out, frame);
+}
+
+void writeChunkData(std::vector<uint8_t>& out, const Chunk& chunk) {
+	std::vector<uint8_t> payload = encodeChunk(chunk);
+	size_t frame = beginFrame(out, MessageType::ChunkData);
+	out.insert(out.end(), payload.begin(), payload.end());
+	endFrame(out, frame);
+}
+
+void writeSectionData(std::vector<uint8_t>& out, SectionPos pos, const Section& section) {
+	size_t frame = beginFrame(out, MessageType::SectionData);
+	put<int32_t>(out, pos.x);
+	put<int32_t>(out, pos.y);
+	put<int32_t>(out, pos.z);
+	encodeSection(out, section);
+	endFrame(out, frame);
+}
+
+void writeBlockChanges(std::vector<uint8_t>& out, BlockChangeBatch& batch) {
+	std::stable_sort(batch.changes.begin(), batch.changes.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	size_t frame = beginFrame(out, MessageType::BlockChanges);
+	put<int32_t>(out, batch.pos.x);
+	put<int32_t>(out, batch.pos.y);
+	put<int32_t>(out, batch.pos.z);
+	putVarint(out, static_cast<uint32_t>(batch.changes.size()));
+
+	uint16_t previous = 0;
+	for (const auto& [index, id] : batch.changes) {
+		putVarint(out, index - previous);
+		putVarint(out, id);
+		previous = index;
+	}
+	endFrame(out, frame);
+}
+
+void writeUnloadChunk(std::vector<uint8_t>& out, ChunkPos pos) {
+	size_t frame = beginFrame(out, MessageType::UnloadChunk);
+	put<int32_t>(out, pos.x);
+	put<int32_t>(out, pos.z);
+	endFrame(out, frame);
+}
+
+HelloMessage readHello(const Message& message) {
+	expect(message, MessageType::Hello);
+	const uint8_t *ip = message.data;
+	const uint8_t *end = message.data + message.size;
+
+	HelloMessage hello;
+	hello.version = take<uint32_t>(ip, end);
+	hello.viewRadius = take<uint8_t>(ip, end);
+	return hello;
+}
+
+ChunkPos readPosition(const Message& message) {
+	expect(message, MessageType::Position);
+	const uint8_t *ip = message.data;
+	const uint8_t *end = message.data + message.size;
+
+	ChunkPos pos;
+	pos.x = take<int32_t>(ip, end);
+	pos.z = take<int32_t>(ip, end);
+	return pos;
+}
+
+SetBlockMessage readSetBlock(const Message& message) {
+	expect(message, MessageType::SetBlock);
+	const uint8_t *ip = message.data;
+	const uint8_t *end = message.data + message.size;
+
+	SetBlockMessage edit;
+	edit.x = take<int32_t>(ip, end);
+	edit.y = take<int32_t>(ip, end);
+	edit.z = take<int32_t>(ip, end);
+	edit.id = take<BlockId>(ip, end);
+	return edit;
+}
+
+WelcomeMessage readWelcome(const Message& message) {
+	expect(message, MessageType::Welcome);
+	const uint8_t *ip = message.data;
+	const uint8_t *end = message.data + message.size;
+
+	WelcomeMessage welcome;
+	welcome.version = take<uint32_t>(ip, end);
+	welcome.seed = take<uint64_t>(ip, end);
+	return welcome;
+}
+
+void readChunkData(const Message& message, Chunk& chunk) {
+	expect(message, MessageType::ChunkData);
+	decodeChunk(message.data, message.size, chunk);
+}
+
+SectionPos readSectionData(const Message& message, Section& section) {
+	expect(message, MessageType::SectionData);
+	const uint8_t *ip = message.data;
+	const uint8_t *end = message.data + message.size;
+
+	SectionPos pos;
+	pos.x = take<int32_t>(ip, end);
+	pos.y = take<int32_t>(ip, end);
+	pos.z = take<int32_t>(ip, end);
+	decodeSection(ip, end, section);
+	return pos;
+}
+
+void readBlockChanges(const Message& message, BlockChangeBatch& batch) {
+	expect(message, MessageType::BlockChanges);
+	const uint8_t *ip = message.data;
+	const uint8_t *end = message.data + message.size;
+
+	batch.pos.x = take<int32_t>(ip, end);
+	batch.pos.y = take<int32_t>(ip, end);
+	batch.pos.z = take<int32_t>(ip, end);
+	uint32_t count = takeVarint(ip, end);
+	if (count > SECTION_VOLUME) throw std::runtime_error("too many block changes!");
+
+	batch.changes.clear();
+	uint32_t index = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		index += takeVarint(ip, end);
+		uint32_t id = takeVarint(ip, end);
+		if (index >= SECTION_VOLUME || id > UINT16_MAX) throw std::runtime_error("invalid block change!");
+		batch.changes.emplace_back(static_cast<uint16_t>(index), static_cast<BlockId>(id));
+	}
+}
+
+ChunkPos readUnloadChunk(const Message& message) {
+	expect(message, MessageType::UnloadChunk);
+	const uint8_t *ip = message.data;
+	const uint8_t *end = message.data + message.size;
+
+	ChunkPos pos;
+	pos.x = take<int32_t>(ip, end);
+	pos.z = take<int32_t>(ip, end);
+	return pos;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <world/chunk.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+const uint32_t PROTOCOL_VERSION = 1;
+// Frames larger than this are treated as a broken stream.
+const uint32_t MAX_FRAME_SIZE = 1 << 22;
+// A section with more changes than this in one tick is resent whole.
+const size_t MAX_SECTION_CHANGES = 256;
+
+// Every frame is a little-endian uint32 length, then a type byte and
+// that many bytes of payload, less one for the type.
+enum class MessageType : uint8_t {
+	// Client to server.
+	Hello = 1,
+	Position = 2,
+	SetBlock = 3,
+	// Server to client.
+	Welcome = 16,
+	ChunkData = 17,
+	SectionData = 18,
+	BlockChanges = 19,
+	UnloadChunk = 20
+};
+
+// A received frame's payload, pointing into the connection's buffer
+// until its next receive.
+struct Message {
+	MessageType type;
+	const uint8_t *data;
+	size_t size;
+};
+
+// Block edits inside one section, as indices into the section
+// (Section::index) and the new ids.
+struct BlockChangeBatch {
+	SectionPos pos;
+	std::vector<std::pair<uint16_t, BlockId>> changes;
+};
+
+struct HelloMessage {
+	uint32_t version;
+	uint8_t viewRadius;
+};
+
+struct SetBlockMessage {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+	BlockId id;
+};
+
+struct WelcomeMessage {
+	uint32_t version;
+	uint64_t seed;
+};
+
+void writeHello(std::vector<uint8_t>& out, uint8_t viewRadius);
+void writePosition(std::vector<uint8_t>& out, ChunkPos pos);
+void writeSetBlock(std::vector<uint8_t>& out, int32_t x, int32_t y, int32_t z, BlockId id);
+void writeWelcome(std::vector<uint8_t>& out, uint64_t seed);
+// The chunk's sections as palettes and packed indices, then compressed;
+// the same encoding the region files use.
+void writeChunkData(std::vector<uint8_t>& out, const Chunk& chunk);
+void writeSectionData(std::vector<uint8_t>& out, SectionPos pos, const Section& section);
+// Changes are sorted by index and stored as varint index deltas and ids,
+// so a batch of nearby edits costs a couple of bytes each. Sorts batch.
+void writeBlockChanges(std::vector<uint8_t>& out, BlockChangeBatch& batch);
+void writeUnloadChunk(std::vector<uint8_t>& out, ChunkPos pos);
+
+// Readers throw std::runtime_error on malformed payloads.
+HelloMessage readHello(const Message& message);
+ChunkPos readPosition(const Message& message);
+SetBlockMessage readSetBlock(const Message& message);
+WelcomeMessage readWelcome(const Message& message);
+void readChunkData(const Message& message, Chunk& chunk);
+SectionPos readSectionData(const Message& message, Section& section);
+void readBlockChanges(const Message& message, BlockChangeBatch& batch);
+ChunkPos readUnloadChunk(const Message& message);
+
+// Splits the next complete frame off the front of data, or returns
+// false when it has not all arrived. consumed is set to the frame's
+// length including its header.
+bool parseFrame(const uint8_t *data, size_t size, Message& message, size_t& consumed);
@@ -0,0 +1,222 @@
+#include <net/socket.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+const size_t RECEIVE_CHUNK = 64 << 10;
+const int LISTEN_BACKLOG = 128;
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+bool isTcpAddress(const std::string& address) {
+	size_t colon = address.rfind(':');
+	return colon != std::string::npos && address.find('/') == std::string::npos && colon + 1 < address.size();
+}
+
+static void setNonBlocking(int fd) {
+	int flags = fcntl(fd, F_GETFL, 0);
+	fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static sockaddr_un unixAddress(const std::string& path) {
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("socket path too long: " + path);
+	memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	return address;
+}
+
+// Resolves "host:port" to the first IPv4 or IPv6 address.
+static addrinfo *tcpAddress(const std::string& address, bool passive) {
+	size_t colon = address.rfind(':');
+	std::string host = address.substr(0, colon);
+	std::string port = address.substr(colon + 1);
+
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (passive) hints.ai_flags = AI_PASSIVE;
+
+	addrinfo *result = nullptr;
+	if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result) != 0 || !result) {
+		throw std::runtime_error("failed to resolve " + address);
+	}
+	return result;
+}
+
+Connection::Connection(int fd) : socket(fd) {
+	setNonBlocking(socket);
+#ifdef SO_NOSIGPIPE
+	int one = 1;
+	setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+Connection::~Connection() {
+	close();
+}
+
+std::unique_ptr<Connection> Connection::connect(const std::string& address) {
+	int fd = -1;
+
+	if (isTcpAddress(address)) {
+		addrinfo *info = tcpAddress(address, false);
+		fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+		if (fd >= 0 && ::connect(fd, info->ai_addr, info->ai_addrlen) != 0) {
+			::close(fd);
+			fd = -1;
+		}
+		freeaddrinfo(info);
+
+		// Chunk data goes out in bursts; waiting to coalesce only adds
+		// latency.
+		int one = 1;
+		if (fd >= 0) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	} else {
+		sockaddr_un target = unixAddress(address);
+		fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&target), sizeof(target)) != 0) {
+			::close(fd);
+			fd = -1;
+		}
+	}
+
+	if (fd < 0) throw std::runtime_error("failed to connect to " + address);
+	return std::make_unique<Connection>(fd);
+}
+
+void Connection::close() {
+	if (socket >= 0) ::close(socket);
+	socket = -1;
+}
+
+bool Connection::flush() {
+	while (open() && sent < out.size()) {
+		ssize_t written = ::send(socket, out.data() + sent, out.size() - sent, SEND_FLAGS);
+		if (written > 0) {
+			sent += written;
+			totalSent += written;
+		} else if (written < 0 && errno == EINTR) {
+			continue;
+		} else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		} else {
+			close();
+		}
+	}
+
+	// Keep the buffer from creeping forward forever.
+	if (sent == out.size()) {
+		out.clear();
+		sent = 0;
+	} else if (sent > out.size() / 2) {
+		out.erase(out.begin(), out.begin() + sent);
+		sent = 0;
+	}
+	return open();
+}
+
+bool Connection::receive() {
+	if (consumed > 0) {
+		in.erase(in.begin(), in.begin() + consumed);
+		consumed = 0;
+	}
+
+	while (open()) {
+		size_t size = in.size();
+		in.resize(size + RECEIVE_CHUNK);
+		ssize_t received = ::recv(socket, in.data() + size, RECEIVE_CHUNK, 0);
+		in.resize(size + std::max<ssize_t>(received, 0));
+
+		if (received > 0) {
+			totalReceived += received;
+		} else if (received < 0 && errno == EINTR) {
+			continue;
+		} else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		} else {
+			close();
+		}
+	}
+	return open();
+}
+
+std::optional<Message> Connection::next() {
+	Message message;
+	size_t length;
+
+	try {
+		if (!parseFrame(in.data() + consumed, in.size() - consumed, message, length)) return std::nullopt;
+	} catch (std::exception &) {
+		close();
+		in.clear();
+		consumed = 0;
+		return std::nullopt;
+	}
+
+	consumed += length;
+	return message;
+}
+
+Listener::Listener(const std::string& address) {
+	if (isTcpAddress(address)) {
+		addrinfo *info = tcpAddress(address, true);
+		socket = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+		int one = 1;
+		if (socket >= 0) setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		bool bound = socket >= 0 && bind(socket, info->ai_addr, info->ai_addrlen) == 0;
+		std::string error = strerror(errno);
+		freeaddrinfo(info);
+		if (!bound) {
+			if (socket >= 0) ::close(socket);
+			throw std::runtime_error("failed to bind " + address + ": " + error);
+		}
+	} else {
+		sockaddr_un target = unixAddress(address);
+		unlink(address.c_str());
+		socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (socket < 0 || bind(socket, reinterpret_cast<sockaddr *>(&target), sizeof(target)) != 0) {
+			std::string error = strerror(errno);
+			if (socket >= 0) ::close(socket);
+			throw std::runtime_error("failed to bind " + address + ": " + error);
+		}
+		path = address;
+	}
+
+	if (listen(socket, LISTEN_BACKLOG) != 0) {
+		std::string error = strerror(errno);
+		::close(socket);
+		throw std::runtime_error("failed to listen on " + address + ": " + error);
+	}
+	setNonBlocking(socket);
+}
+
+Listener::~Listener() {
+	if (socket >= 0) ::close(socket);
+	if (!path.empty()) unlink(path.c_str());
+}
+
+std::unique_ptr<Connection> Listener::accept() {
+	int fd = ::accept(socket, nullptr, nullptr);
+	if (fd < 0) return nullptr;
+
+	sockaddr_storage address{};
+	socklen_t length = sizeof(address);
+	if (getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length) == 0 && address.ss_family != AF_UNIX) {
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	}
+	return std::make_unique<Connection>(fd);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <net/protocol.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Addresses are "host:port" for TCP and anything else for a UNIX socket
+// path, so the same server runs over loopback or a local socket.
+bool isTcpAddress(const std::string& address);
+
+// A non-blocking stream socket with buffers on both sides. Frames are
+// appended to output() and go out on flush(); receive() reads whatever
+// arrived and next() hands back complete frames one at a time.
+class Connection {
+public:
+	explicit Connection(int fd);
+	~Connection();
+
+	Connection(const Connection&) = delete;
+	Connection& operator=(const Connection&) = delete;
+
+	// Blocks until connected; throws std::runtime_error on failure.
+	static std::unique_ptr<Connection> connect(const std::string& address);
+
+	int fd() const { return socket; }
+	bool open() const { return socket >= 0; }
+	std::vector<uint8_t>& output() { return out; }
+	size_t pending() const { return out.size() - sent; }
+
+	// Both return false once the peer has gone or the stream broke; the
+	// socket is then closed.
+	bool flush();
+	bool receive();
+	// The message points into the input buffer until the next receive().
+	std::optional<Message> next();
+
+	uint64_t bytesSent() const { return totalSent; }
+	uint64_t bytesReceived() const { return totalReceived; }
+	void close();
+private:
+	int socket;
+	std::vector<uint8_t> out;
+	size_t sent = 0;
+	std::vector<uint8_t> in;
+	size_t consumed = 0;
+	uint64_t totalSent = 0;
+	uint64_t totalReceived = 0;
+};
+
+class Listener {
+public:
+	// Throws std::runtime_error when the address cannot be bound. A
+	// stale UNIX socket file is replaced.
+	explicit Listener(const std::string& address);
+	~Listener();
+
+	Listener(const Listener&) = delete;
+	Listener& operator=(const Listener&) = delete;
+
+	int fd() const { return socket; }
+	// Null when nobody is waiting.
+	std::unique_ptr<Connection> accept();
+private:
+	int socket = -1;
+	std::string path;
+};
@@ -0,0 +1,139 @@
+#include <rendering/arena.hpp>
+#include <algorithm>
+#include <cassert>
+
+ArenaAllocator::ArenaAllocator(uint32_t capacity) : total(capacity) {
+	if (capacity > 0) freeBlocks[0] = capacity;
+}
+
+std::optional<uint32_t> ArenaAllocator::allocate(uint32_t size) {
+	if (size == 0) return std::nullopt;
+
+	for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+		if (it->second < size) continue;
+
+		uint32_t offset = it->first;
+		uint32_t remaining = it->second - size;
+		freeBlocks.erase(it);
+		if (remaining > 0) freeBlocks[offset + size] = remaining;
+
+		usedBlocks[offset] = size;
+		usedSlots += size;
+		return offset;
+	}
+
+	return std::nullopt;
+}
+
+void ArenaAllocator::free(uint32_t offset) {
+	auto it = usedBlocks.find(offset);
+	assert(it != usedBlocks.end());
+
+	uint32_t size = it->second;
+	usedBlocks.erase(it);
+	usedSlots -= size;
+	release(offset, size);
+}
+
+void ArenaAllocator::release(uint32_t offset, uint32_t size) {
+	auto next = freeBlocks.lower_bound(offset);
+	if (next != freeBlocks.end() && offset + size == next->first) {
+		size += next->second;
+		next = freeBlocks.erase(next);
+	}
+
+	if (next != freeBlocks.begin()) {
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset) {
+			prev->second += size;
+			return;
+		}
+	}
+
+	freeBlocks[offset] = size;
+}
+
+void ArenaAllocator::grow(uint32_t capacity) {
+	if (capacity <= total) return;
+	uint32_t added = capacity - total;
+	uint32_t offset = total;
+	total = capacity;
+	release(offset, added);
+}
+
+std::vector<ArenaMove> ArenaAllocator::compact(uint32_t budget) {
+	std::vector<ArenaMove> moves;
+	std::vector<std::pair<uint32_t, uint32_t>> sources;
+
+	while (budget > 0 && !usedBlocks.empty() && !freeBlocks.empty()) {
+		auto block = std::prev(usedBlocks.end());
+		uint32_t from = block->first;
+		uint32_t size = block->second;
+		if (size > budget) break;
+
+		auto hole = std::find_if(freeBlocks.begin(), freeBlocks.end(), [&](const auto& free) {
+			return free.second >= size;
+		});
+		if (hole == freeBlocks.end() || hole->first > from) break;
+
+		uint32_t to = hole->first;
+		uint32_t remaining = hole->second - size;
+		freeBlocks.erase(hole);
+		if (remaining > 0) freeBlocks[to + size] = remaining;
+
+		usedBlocks.erase(block);
+		usedBlocks[to] = size;
+		sources.emplace_back(from, size);
+		moves.push_back({from, to, size});
+		budget -= size;
+	}
+
+	for (const auto& [offset, size] : sources) release(offset, size);
+	return moves;
+}
+
+uint32_t ArenaAllocator::largestFree() const {
+	uint32_t largest = 0;
+	for (const auto& [offset, size] : freeBlocks) largest = std::max(largest, size);
+	return largest;
+}
+
+float ArenaAllocator::fragmentation() const {
+	uint32_t free = total - usedSlots;
+	if (free == 0) return 0.0f;
+	return 1.0f - static_cast<float>(largestFree()) / static_cast<float>(free);
+}
+
+RingAllocator::RingAllocator(uint64_t capacity) : total(capacity) {}
+
+std::optional<uint64_t> RingAllocator::allocate(uint64_t size, uint64_t alignment) {
+	if (size == 0) return std::nullopt;
+
+	// Space skipped for alignment, or at the end of the range when the
+	// block has to wrap, counts as used until its tag is released.
+	uint64_t offset = (head + alignment - 1) / alignment * alignment;
+	if (offset + size > total) offset = 0;
+	uint64_t skipped = offset >= head ? offset - head : total - head;
+
+	if (usedBytes + skipped + size > total) return std::nullopt;
+
+	head = offset + size;
+	usedBytes += skipped + size;
+	untagged += skipped + size;
+	return offset;
+}
+
+void RingAllocator::tag(uint64_t value) {
+	if (untagged == 0) return;
+	busy.push_back({value, untagged});
+	untagged = 0;
+}
+
+void RingAllocator::release(uint64_t completed) {
+	while (!busy.empty() && busy.front().value <= completed) {
+		usedBytes -= busy.front().bytes;
+		busy.pop_front();
+	}
+
+	if (usedBytes == 0) head = 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <vector>
+
+// A block the compactor moved to a lower offset; the caller copies the
+// contents and points whatever owned the block at its new place.
+struct ArenaMove {
+	uint32_t from;
+	uint32_t to;
+	uint32_t size;
+};
+
+// First-fit free-list allocator over a range of slots, such as vertices
+// or indices in a GPU buffer. Adjacent free blocks are merged on free, and compact()
+// slides the highest blocks down into holes once the free space is too
+// scattered to serve large requests.
+class ArenaAllocator {
+public:
+	ArenaAllocator(uint32_t capacity = 0);
+
+	std::optional<uint32_t> allocate(uint32_t size);
+	void free(uint32_t offset);
+	void grow(uint32_t capacity);
+
+	// Moves at most budget slots worth of blocks. Sources are released
+	// only after every move is planned, so no move's destination overlaps
+	// another's source and the copies can share one command.
+	std::vector<ArenaMove> compact(uint32_t budget);
+
+	uint32_t capacity() const { return total; }
+	uint32_t used() const { return usedSlots; }
+	uint32_t largestFree() const;
+	// 0 when all free space is one block, approaching 1 as it splinters.
+	float fragmentation() const;
+private:
+	uint32_t total;
+	uint32_t usedSlots = 0;
+	std::map<uint32_t, uint32_t> freeBlocks;
+	std::map<uint32_t, uint32_t> usedBlocks;
+
+	void release(uint32_t offset, uint32_t size);
+};
+
+// FIFO allocator over a circular byte range, such as a staging buffer.
+// Blocks are handed out in order; tag() marks everything allocated since
+// the last tag as busy until a value (a GPU timeline point) is reached,
+// and release() frees them oldest first once it has been.
+class RingAllocator {
+public:
+	RingAllocator(uint64_t capacity = 0);
+
+	std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment);
+	void tag(uint64_t value);
+	void release(uint64_t completed);
+
+	// Value the oldest busy block waits for, or 0 when none is tagged.
+	uint64_t oldest() const { return busy.empty() ? 0 : busy.front().value; }
+	uint64_t capacity() const { return total; }
+	uint64_t used() const { return usedBytes; }
+private:
+	struct Tag {
+		uint64_t value;
+		uint64_t bytes;
+	};
+
+	uint64_t total;
+	uint64_t head = 0;
+	uint64_t usedBytes = 0;
+	uint64_t untagged = 0;
+	std::deque<Tag> busy;
+};
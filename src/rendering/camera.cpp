@@ -1 +1,55 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <rendering/camera.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+glm::vec3 Camera::forward() const {
+	return glm::vec3(std::cos(pitch) * std::sin(yaw), std::sin(pitch), -std::cos(pitch) * std::cos(yaw));
+}
+
+glm::mat4 Camera::view() const {
+	return glm::lookAt(position, position + forward(), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+glm::mat4 Camera::projection(float aspect) const {
+	return glm::perspective(glm::radians(fov), aspect, zNear, zFar);
+}
+
+CameraState CameraState::lerp(const CameraState& from, const CameraState& to, float t) {
+	CameraState state;
+	state.position = from.position + (to.position - from.position) * t;
+	state.yaw = from.yaw + (to.yaw - from.yaw) * t;
+	state.pitch = from.pitch + (to.pitch - from.pitch) * t;
+	return state;
+}
+
+void CameraState::apply(Camera& camera) const {
+	camera.position = position;
+	camera.yaw = yaw;
+	camera.pitch = pitch;
+}
+
+// Gribb-Hartmann extraction; with zero-to-one depth the near plane is
+// the third row alone.
+Frustum::Frustum(const glm::mat4& m) {
+	auto row = [&](int i) {
+		return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+	};
+
+	planes[0] = row(3) + row(0);
+	planes[1] = row(3) - row(0);
+	planes[2] = row(3) + row(1);
+	planes[3] = row(3) - row(1);
+	planes[4] = row(2);
+	planes[5] = row(3) - row(2);
+}
+
+bool Frustum::intersects(glm::vec3 min, glm::vec3 max) const {
+	for (const auto& plane : planes) {
+		// The corner furthest along the plane normal.
+		glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+		if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) return false;
+	}
+	return true;
+}
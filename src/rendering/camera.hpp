@@ -1,9 +1,44 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <array>
 
 struct UniformBufferObject {
-    glm::mat4 model;
     glm::mat4 view;
     glm::mat4 proj;
 };
+
+class Camera {
+public:
+	glm::vec3 position = glm::vec3(0.0f, 120.0f, 0.0f);
+	float yaw = 0.0f;
+	float pitch = -0.5f;
+	float fov = 70.0f;
+	float zNear = 0.1f;
+	float zFar = 1000.0f;
+
+	glm::vec3 forward() const;
+	glm::mat4 view() const;
+	glm::mat4 projection(float aspect) const;
+};
+
+// The part of the camera the simulation owns. Each rendered frame blends
+// the last two simulation ticks, so motion stays smooth at any frame rate.
+struct CameraState {
+	glm::vec3 position = glm::vec3(0.0f, 120.0f, 0.0f);
+	float yaw = 0.0f;
+	float pitch = -0.5f;
+
+	static CameraState lerp(const CameraState& from, const CameraState& to, float t);
+	void apply(Camera& camera) const;
+};
+
+// The six planes of a view-projection matrix, normals pointing inwards.
+class Frustum {
+public:
+	Frustum(const glm::mat4& viewProjection);
+
+	bool intersects(glm::vec3 min, glm::vec3 max) const;
+private:
+	std::array<glm::vec4, 6> planes;
+};
@@ -0,0 +1,149 @@
+#include <rendering/flythrough.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <sys/resource.h>
+
+const int ORBIT_KEYFRAMES = 16;
+
+CameraPath CameraPath::orbit(float radius, float height) {
+	CameraPath path;
+	for (int i = 0; i <= ORBIT_KEYFRAMES; i++) {
+		float angle = 6.2831853f * i / ORBIT_KEYFRAMES;
+		CameraState key;
+		key.position = glm::vec3(radius * std::cos(angle), height + 12.0f * std::sin(2.0f * angle), radius * std::sin(angle));
+		// Facing along the circle; forward is (sin yaw, -cos yaw).
+		key.yaw = angle + 3.1415927f;
+		key.pitch = -0.25f + 0.15f * std::sin(angle);
+		path.add(key);
+	}
+	return path;
+}
+
+CameraPath CameraPath::load(const std::filesystem::path& file) {
+	std::ifstream in(file);
+	if (!in.is_open()) throw std::runtime_error("failed to open camera path " + file.string());
+
+	CameraPath path;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || line[0] == '#') continue;
+		std::istringstream fields(line);
+		CameraState key;
+		if (!(fields >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch)) {
+			throw std::runtime_error("bad keyframe in " + file.string() + ": " + line);
+		}
+		path.add(key);
+	}
+
+	if (path.empty()) throw std::runtime_error("camera path " + file.string() + " has no keyframes");
+	return path;
+}
+
+void CameraPath::save(const std::filesystem::path& file) const {
+	std::ofstream out(file);
+	if (!out.is_open()) throw std::runtime_error("failed to write camera path " + file.string());
+
+	out << "# x y z yaw pitch, one keyframe every " << KEYFRAME_INTERVAL << " s\n";
+	out << std::setprecision(9);
+	for (const CameraState& key : keys) {
+		out << key.position.x << ' ' << key.position.y << ' ' << key.position.z << ' ' << key.yaw << ' ' << key.pitch << '\n';
+	}
+}
+
+float CameraPath::duration() const {
+	return keys.size() < 2 ? 0.0f : (keys.size() - 1) * KEYFRAME_INTERVAL;
+}
+
+template <typename T>
+static T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float t) {
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+CameraState CameraPath::sample(float seconds) const {
+	if (keys.size() < 2) return keys.empty() ? CameraState() : keys[0];
+
+	float time = std::fmod(seconds, duration());
+	size_t segment = std::min(static_cast<size_t>(time / KEYFRAME_INTERVAL), keys.size() - 2);
+	float t = time / KEYFRAME_INTERVAL - segment;
+
+	// The ends repeat their keyframe for the missing neighbour.
+	const CameraState& p0 = keys[segment == 0 ? 0 : segment - 1];
+	const CameraState& p1 = keys[segment];
+	const CameraState& p2 = keys[segment + 1];
+	const CameraState& p3 = keys[std::min(segment + 2, keys.size() - 1)];
+
+	CameraState state;
+	state.position = catmullRom(p0.position, p1.position, p2.position, p3.position, t);
+	state.yaw = catmullRom(p0.yaw, p1.yaw, p2.yaw, p3.yaw, t);
+	state.pitch = std::clamp(catmullRom(p0.pitch, p1.pitch, p2.pitch, p3.pitch, t), -1.5f, 1.5f);
+	return state;
+}
+
+// Nearest-rank percentile of sorted values.
+static double percentile(const std::vector<double>& sorted, double fraction) {
+	if (sorted.empty()) return 0.0;
+	size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static void writeDistribution(std::ostream& out, const char *name, std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	double total = 0.0;
+	for (double value : values) total += value;
+
+	out << "  \"" << name << "\": {"
+		<< "\"count\": " << values.size()
+		<< ", \"mean\": " << (values.empty() ? 0.0 : total / values.size())
+		<< ", \"p50\": " << percentile(values, 0.50)
+		<< ", \"p95\": " << percentile(values, 0.95)
+		<< ", \"p99\": " << percentile(values, 0.99)
+		<< ", \"max\": " << (values.empty() ? 0.0 : values.back())
+		<< "},\n";
+}
+
+void writeFlythroughReport(const std::filesystem::path& path, const FlythroughReport& report) {
+	double total = 0.0;
+	for (double frame : report.frameMilliseconds) total += frame;
+
+	std::ostringstream json;
+	json << std::setprecision(6);
+	json << "{\n";
+	json << "  \"seed\": " << report.seed << ",\n";
+	json << "  \"step_seconds\": " << report.step << ",\n";
+	json << "  \"frames\": " << report.frameMilliseconds.size() << ",\n";
+	json << "  \"average_fps\": " << (total > 0.0 ? report.frameMilliseconds.size() * 1000.0 / total : 0.0) << ",\n";
+	writeDistribution(json, "frame_ms", report.frameMilliseconds);
+	writeDistribution(json, "chunk_load_ms", report.chunkMilliseconds);
+	json << "  \"world_ready_ms\": " << report.worldReadyMilliseconds << ",\n";
+	json << "  \"peak_cpu_bytes\": " << report.peakCpuBytes << ",\n";
+	json << "  \"peak_device_bytes\": " << report.peakDeviceBytes << ",\n";
+	json << "  \"device_bytes\": {";
+	for (size_t i = 0; i < report.deviceCategoryBytes.size(); i++) {
+		json << (i == 0 ? "" : ", ") << "\"" << report.deviceCategoryBytes[i].first << "\": " << report.deviceCategoryBytes[i].second;
+	}
+	json << "},\n";
+	json << "  \"memory_fallbacks\": " << report.memoryFallbacks << ",\n";
+	json << "  \"evicted_sections\": " << report.evictedSections << "\n";
+	json << "}\n";
+
+	std::ofstream out(path);
+	if (!out.is_open()) throw std::runtime_error("failed to write " + path.string());
+	out << json.str();
+}
+
+uint64_t peakResidentBytes() {
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	// Linux reports kilobytes, macOS bytes.
+#ifdef __APPLE__
+	return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <rendering/camera.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Seconds between the keyframes of a camera path.
+const float KEYFRAME_INTERVAL = 1.0f;
+
+// Camera keyframes one KEYFRAME_INTERVAL apart, sampled as a Catmull-Rom
+// spline through them. Yaw is not wrapped, so a recorded turn keeps
+// its direction. Saved as text, one "x y z yaw pitch" line per keyframe.
+class CameraPath {
+public:
+	// A loop over the spawn area, used when no path is given.
+	static CameraPath orbit(float radius, float height);
+	static CameraPath load(const std::filesystem::path& path);
+	void save(const std::filesystem::path& path) const;
+
+	void add(const CameraState& keyframe) { keys.push_back(keyframe); }
+	bool empty() const { return keys.empty(); }
+	float duration() const;
+	// Wraps around once past the end.
+	CameraState sample(float seconds) const;
+private:
+	std::vector<CameraState> keys;
+};
+
+// What a flythrough measured. Chunk times are per chunk, from the start
+// of its generation to it being ready to mesh; worldReady is how long
+// after the first frame the last section of the loaded world was drawn.
+// Device memory by category and the eviction counters are as of the end.
+struct FlythroughReport {
+	uint64_t seed = 0;
+	float step = 0.0f;
+	std::vector<double> frameMilliseconds;
+	std::vector<double> chunkMilliseconds;
+	double worldReadyMilliseconds = 0.0;
+	uint64_t peakCpuBytes = 0;
+	uint64_t peakDeviceBytes = 0;
+	std::vector<std::pair<std::string, uint64_t>> deviceCategoryBytes;
+	uint64_t memoryFallbacks = 0;
+	uint64_t evictedSections = 0;
+};
+
+void writeFlythroughReport(const std::filesystem::path& path, const FlythroughReport& report);
+// Peak resident memory of the process so far.
+uint64_t peakResidentBytes();
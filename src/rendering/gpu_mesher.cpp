@@ -0,0 +1,178 @@
+#include <rendering/gpu_mesher.hpp>
+#include <assets/shaders.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+const uint32_t MESH_WORKGROUP_SIZE = 64;
+const int VERTEX_FLOATS = sizeof(Vertex) / sizeof(float);
+const int QUAD_FLOATS = 4 * VERTEX_FLOATS;
+// Colours and light go through a division on the GPU that need not be
+// correctly rounded.
+const float COMPARE_EPSILON = 1e-4f;
+
+using Quad = std::array<float, QUAD_FLOATS>;
+
+static_assert(sizeof(Vertex) == 9 * sizeof(float), "mesher.glsl writes vertices as nine packed floats");
+
+void GpuMesher::create(vk::Device device) {
+	this->device = device;
+
+	std::array<vk::DescriptorSetLayoutBinding, 4> bindings;
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = vk::DescriptorType::eStorageBuffer;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = vk::ShaderStageFlagBits::eCompute;
+	}
+
+	vk::DescriptorSetLayoutCreateInfo layoutInfo;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+	setLayout = device.createDescriptorSetLayout(layoutInfo);
+
+	vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, static_cast<uint32_t>(bindings.size()));
+	vk::DescriptorPoolCreateInfo poolInfo;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = 1;
+	pool = device.createDescriptorPool(poolInfo);
+
+	vk::DescriptorSetAllocateInfo allocInfo;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+	set = device.allocateDescriptorSets(allocInfo)[0];
+
+	vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t));
+	vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &setLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	layout = device.createPipelineLayout(pipelineLayoutInfo);
+
+	vk::ShaderModule module = createShaderModule(Identifier("core", "mesher"), ShaderType::Compute, device);
+
+	vk::ComputePipelineCreateInfo pipelineInfo;
+	pipelineInfo.stage = vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, module, "main");
+	pipelineInfo.layout = layout;
+	pipeline = device.createComputePipeline(nullptr, pipelineInfo).value;
+
+	device.destroyShaderModule(module);
+}
+
+void GpuMesher::destroy() {
+	if (!ready()) return;
+
+	device.destroyPipeline(pipeline);
+	device.destroyPipelineLayout(layout);
+	device.destroyDescriptorPool(pool);
+	device.destroyDescriptorSetLayout(setLayout);
+	pipeline = nullptr;
+}
+
+bool GpuMesher::bound(vk::Buffer input, vk::Buffer blocks, vk::Buffer vertices, vk::Buffer commands) const {
+	return buffers == std::array<vk::Buffer, 4>{input, blocks, vertices, commands};
+}
+
+void GpuMesher::bind(vk::Buffer input, vk::Buffer blocks, vk::Buffer vertices, vk::Buffer commands) {
+	buffers = {input, blocks, vertices, commands};
+
+	std::array<vk::DescriptorBufferInfo, 4> infos;
+	std::array<vk::WriteDescriptorSet, 4> writes;
+	for (uint32_t i = 0; i < writes.size(); i++) {
+		infos[i] = vk::DescriptorBufferInfo(buffers[i], 0, VK_WHOLE_SIZE);
+		writes[i].dstSet = set;
+		writes[i].dstBinding = i;
+		writes[i].dstArrayElement = 0;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = vk::DescriptorType::eStorageBuffer;
+		writes[i].pBufferInfo = &infos[i];
+	}
+
+	device.updateDescriptorSets(writes, {});
+}
+
+void GpuMesher::dispatch(vk::CommandBuffer buffer, uint32_t inputOffset, uint32_t sections) {
+	buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+	buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, layout, 0, {set}, {});
+	buffer.pushConstants(layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t), &inputOffset);
+	buffer.dispatch(SECTION_VOLUME / MESH_WORKGROUP_SIZE, sections, 1);
+}
+
+uint32_t GpuMesher::packedWords(const PackedSection& packed) {
+	return static_cast<uint32_t>(packed.palette.size() + packed.indices.size() + packed.light.size());
+}
+
+uint32_t GpuMesher::writePacked(uint32_t *words, uint32_t at, const PackedSection& packed, GpuSectionHeader& header) {
+	header.bits = packed.bits;
+
+	header.palette = at;
+	memcpy(words + at, packed.palette.data(), sizeof(uint32_t) * packed.palette.size());
+	at += static_cast<uint32_t>(packed.palette.size());
+
+	header.indices = at;
+	memcpy(words + at, packed.indices.data(), sizeof(uint32_t) * packed.indices.size());
+	at += static_cast<uint32_t>(packed.indices.size());
+
+	header.light = at;
+	memcpy(words + at, packed.light.data(), sizeof(uint32_t) * packed.light.size());
+	return at + static_cast<uint32_t>(packed.light.size());
+}
+
+std::vector<GpuBlockInfo> GpuMesher::blockTable() {
+	// Every id the tables have room for, so the shader's wrapped ids never
+	// read past the end; unregistered ones come out as air.
+	std::vector<GpuBlockInfo> table(MAX_BLOCKS);
+	for (BlockId id = 0; id < MAX_BLOCKS; id++) {
+		table[id].color = blockColor(id);
+		table[id].opaque = isOpaque(id);
+	}
+	return table;
+}
+
+static std::vector<Quad> sortedQuads(const Vertex *vertices, size_t quads) {
+	std::vector<Quad> result(quads);
+	for (size_t i = 0; i < quads; i++) memcpy(result[i].data(), vertices + i * 4, sizeof(Quad));
+
+	// Positions alone tell quads apart: two faces on the same four
+	// corners cannot both be visible.
+	std::sort(result.begin(), result.end(), [](const Quad& a, const Quad& b) {
+		for (int v = 0; v < 4; v++) {
+			for (int c = 0; c < 3; c++) {
+				float x = a[v * VERTEX_FLOATS + c], y = b[v * VERTEX_FLOATS + c];
+				if (x != y) return x < y;
+			}
+		}
+		return false;
+	});
+	return result;
+}
+
+std::string GpuMesher::compare(const std::vector<Vertex>& expected, const Vertex *actual, uint32_t indexCount) {
+	std::ostringstream error;
+	size_t quads = expected.size() / 4;
+	if (indexCount != quads * 6) {
+		error << "expected " << quads << " quads, GPU counted " << indexCount / 6;
+		return error.str();
+	}
+
+	std::vector<Quad> a = sortedQuads(expected.data(), quads);
+	std::vector<Quad> b = sortedQuads(actual, quads);
+
+	for (size_t q = 0; q < quads; q++) {
+		for (int f = 0; f < QUAD_FLOATS; f++) {
+			if (std::fabs(a[q][f] - b[q][f]) <= COMPARE_EPSILON) continue;
+
+			int v = f / VERTEX_FLOATS;
+			const float *corner = &a[q][v * VERTEX_FLOATS];
+			error << "quad at (" << corner[0] << ", " << corner[1] << ", " << corner[2] << ") differs in vertex " << v << " component " << f % VERTEX_FLOATS << ": " << a[q][f] << " vs " << b[q][f];
+			return error.str();
+		}
+	}
+
+	return "";
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <rendering/mesher.hpp>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One per section at the start of a batch's input, as mesher.glsl reads
+// it. Offsets count 32-bit words from the start of the batch's input;
+// command is a slot in the indirect command buffer.
+struct GpuSectionHeader {
+	uint32_t palette;
+	uint32_t bits;
+	uint32_t indices;
+	uint32_t light;
+	uint32_t vertexOffset;
+	uint32_t command;
+	uint32_t quadCount;
+	uint32_t pad;
+};
+
+// Mirrors BlockInfo in mesher.glsl.
+struct GpuBlockInfo {
+	glm::vec4 color;
+	uint32_t opaque;
+	uint32_t pad[3];
+};
+
+// Compute pipeline that writes the opaque faces of packed sections into
+// the mesh arena and counts them in each section's indirect draw
+// command. Buffers belong to the caller; the descriptor set only
+// follows them when one is replaced.
+class GpuMesher {
+public:
+	void create(vk::Device device);
+	void destroy();
+	bool ready() const { return static_cast<bool>(pipeline); }
+
+	bool bound(vk::Buffer input, vk::Buffer blocks, vk::Buffer vertices, vk::Buffer commands) const;
+	// Rewrites the descriptor set, so no dispatch recorded before may
+	// still be pending.
+	void bind(vk::Buffer input, vk::Buffer blocks, vk::Buffer vertices, vk::Buffer commands);
+	// Input starts at word inputOffset of the input buffer with one
+	// header per section.
+	void dispatch(vk::CommandBuffer buffer, uint32_t inputOffset, uint32_t sections);
+
+	// Words a section's palette, indices and light take in the input.
+	static uint32_t packedWords(const PackedSection& packed);
+	// Copies them to words[at] on, filling in the header's offsets, and
+	// returns the word after them.
+	static uint32_t writePacked(uint32_t *words, uint32_t at, const PackedSection& packed, GpuSectionHeader& header);
+	static std::vector<GpuBlockInfo> blockTable();
+	// First difference between the CPU mesher's opaque vertices and the
+	// GPU's, ignoring quad order; empty when they match.
+	static std::string compare(const std::vector<Vertex>& expected, const Vertex *actual, uint32_t indexCount);
+private:
+	vk::Device device;
+	vk::DescriptorSetLayout setLayout;
+	vk::DescriptorPool pool;
+	vk::DescriptorSet set;
+	vk::PipelineLayout layout;
+	vk::Pipeline pipeline;
+	std::array<vk::Buffer, 4> buffers;
+};
@@ -0,0 +1,86 @@
+#include <rendering/instances.hpp>
+
+struct ModelShape {
+	glm::vec3 size;
+	glm::vec4 color;
+};
+
+// Boxes standing on their origin, before the instance's scale.
+static const ModelShape MODEL_SHAPES[ENTITY_MODEL_COUNT] = {
+	{{0.6f, 1.8f, 0.6f}, {0.85f, 0.45f, 0.35f, 1.0f}},
+	{{0.25f, 0.25f, 0.25f}, {0.9f, 0.8f, 0.2f, 1.0f}},
+	{{0.1f, 0.1f, 0.1f}, {1.0f, 1.0f, 1.0f, 1.0f}}
+};
+
+// Same winding and shading as block faces.
+static const int BOX_CORNERS[6][4][3] = {
+	{{0, 0, 0}, {0, 0, 1}, {0, 1, 1}, {0, 1, 0}},
+	{{1, 0, 0}, {1, 1, 0}, {1, 1, 1}, {1, 0, 1}},
+	{{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}},
+	{{0, 1, 0}, {0, 1, 1}, {1, 1, 1}, {1, 1, 0}},
+	{{0, 0, 0}, {0, 1, 0}, {1, 1, 0}, {1, 0, 0}},
+	{{0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}}
+};
+static const float BOX_SHADES[6] = {0.8f, 0.8f, 0.5f, 1.0f, 0.7f, 0.7f};
+
+void extractInstances(EntityStore& store, JobSystem& jobs, EntityInstances& out) {
+	std::vector<Archetype>& archetypes = store.archetypes();
+	out.counts.fill(0);
+
+	for (const Archetype& archetype : archetypes) {
+		if (archetype.model == EntityModel::None || !archetype.has(COMPONENT_POSITION)) continue;
+		out.counts[static_cast<size_t>(archetype.model)] += static_cast<uint32_t>(archetype.size());
+	}
+
+	uint32_t total = 0;
+	for (size_t m = 0; m < ENTITY_MODEL_COUNT; m++) {
+		out.offsets[m] = total;
+		total += out.counts[m];
+	}
+	out.instances.resize(total);
+
+	// Where each archetype's first row goes, found before the parallel
+	// pass so batches can write their rows independently.
+	std::array<uint32_t, ENTITY_MODEL_COUNT> next = out.offsets;
+	std::vector<uint32_t> bases(archetypes.size(), 0);
+	for (size_t a = 0; a < archetypes.size(); a++) {
+		const Archetype& archetype = archetypes[a];
+		if (archetype.model == EntityModel::None || !archetype.has(COMPONENT_POSITION)) continue;
+		bases[a] = next[static_cast<size_t>(archetype.model)];
+		next[static_cast<size_t>(archetype.model)] += static_cast<uint32_t>(archetype.size());
+	}
+
+	store.each(COMPONENT_POSITION, jobs, [&](Archetype& archetype, size_t begin, size_t end) {
+		if (archetype.model == EntityModel::None) return;
+
+		InstanceData *instances = out.instances.data() + bases[&archetype - archetypes.data()];
+		bool velocity = archetype.has(COMPONENT_VELOCITY);
+		bool yaw = archetype.has(COMPONENT_YAW);
+		bool scale = archetype.has(COMPONENT_SCALE);
+
+		for (size_t i = begin; i < end; i++) {
+			InstanceData& instance = instances[i];
+			instance.position = archetype.positions[i];
+			instance.yaw = yaw ? archetype.yaws[i] : 0.0f;
+			instance.velocity = velocity ? archetype.velocities[i] : glm::vec3(0.0f);
+			instance.scale = scale ? archetype.scales[i] : 1.0f;
+		}
+	});
+}
+
+std::vector<Vertex> buildEntityModels() {
+	std::vector<Vertex> vertices;
+	vertices.reserve(ENTITY_MODEL_COUNT * ENTITY_MODEL_VERTICES);
+
+	for (const ModelShape& shape : MODEL_SHAPES) {
+		glm::vec3 min(-shape.size.x * 0.5f, 0.0f, -shape.size.z * 0.5f);
+		for (int face = 0; face < 6; face++) {
+			for (const auto& corner : BOX_CORNERS[face]) {
+				glm::vec3 position = min + glm::vec3(corner[0], corner[1], corner[2]) * shape.size;
+				vertices.push_back({position, glm::vec4(glm::vec3(shape.color) * BOX_SHADES[face], shape.color.a), glm::vec2(0.0f, 1.0f)});
+			}
+		}
+	}
+
+	return vertices;
+}
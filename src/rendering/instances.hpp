@@ -0,0 +1,26 @@
+#pragma once
+
+#include <rendering/mesh.hpp>
+#include <world/entities.hpp>
+#include <core/jobs.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Every entity model is a box of six quads, drawn with the shared quad
+// index buffer.
+const uint32_t ENTITY_MODEL_VERTICES = 24;
+
+// Instances of every drawable entity from one simulation tick, grouped
+// by model: model m owns counts[m] instances from offsets[m] on.
+struct EntityInstances {
+	std::vector<InstanceData> instances;
+	std::array<uint32_t, ENTITY_MODEL_COUNT> offsets = {};
+	std::array<uint32_t, ENTITY_MODEL_COUNT> counts = {};
+};
+
+// Packs the entities with a model into out, one archetype batch per job.
+// Storage in out is reused from tick to tick.
+void extractInstances(EntityStore& store, JobSystem& jobs, EntityInstances& out);
+// Vertices of every model, ENTITY_MODEL_VERTICES each in model order.
+std::vector<Vertex> buildEntityModels();
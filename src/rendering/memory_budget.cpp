@@ -0,0 +1,123 @@
+#include <rendering/memory_budget.hpp>
+#include <algorithm>
+
+const char *memoryCategoryName(MemoryCategory category) {
+	switch (category) {
+	case MemoryCategory::Meshes: return "meshes";
+	case MemoryCategory::Textures: return "textures";
+	case MemoryCategory::Staging: return "staging";
+	case MemoryCategory::Uniforms: return "uniforms";
+	case MemoryCategory::RenderTargets: return "render_targets";
+	case MemoryCategory::Other: return "other";
+	}
+	return "other";
+}
+
+void MemoryBudget::init(vk::PhysicalDevice physicalDevice, bool extension) {
+	this->physicalDevice = physicalDevice;
+	this->extension = extension;
+	properties = physicalDevice.getMemoryProperties();
+	counters.heapCount = properties.memoryHeapCount;
+
+	// The largest device-local heap is the one meshes compete for; on
+	// integrated GPUs it is system memory.
+	for (uint32_t i = 0; i < properties.memoryHeapCount; i++) {
+		const vk::MemoryHeap& heap = properties.memoryHeaps[i];
+		if ((heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) && (!(properties.memoryHeaps[localHeap].flags & vk::MemoryHeapFlagBits::eDeviceLocal) || heap.size > properties.memoryHeaps[localHeap].size)) {
+			localHeap = i;
+		}
+	}
+
+	refresh();
+}
+
+void MemoryBudget::refresh() {
+	if (extension) {
+		auto chain = physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		const vk::PhysicalDeviceMemoryBudgetPropertiesEXT& budget = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		for (uint32_t i = 0; i < properties.memoryHeapCount; i++) {
+			counters.heapBudget[i] = budget.heapBudget[i];
+			driverUsage[i] = budget.heapUsage[i];
+		}
+		ownAtRefresh = own;
+	} else {
+		for (uint32_t i = 0; i < properties.memoryHeapCount; i++) {
+			counters.heapBudget[i] = static_cast<vk::DeviceSize>(properties.memoryHeaps[i].size * DEFAULT_HEAP_BUDGET);
+		}
+	}
+	update();
+}
+
+vk::DeviceSize MemoryBudget::heapUsage(uint32_t heap) const {
+	if (!extension) return own[heap];
+	// The driver's figure is a frame old; add what changed since.
+	vk::DeviceSize usage = driverUsage[heap] + own[heap];
+	return usage > ownAtRefresh[heap] ? usage - ownAtRefresh[heap] : 0;
+}
+
+void MemoryBudget::update() {
+	counters.total = 0;
+	for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) counters.total += counters.categories[i];
+	counters.peak = std::max(counters.peak, counters.total);
+	for (uint32_t i = 0; i < properties.memoryHeapCount; i++) counters.heapUsage[i] = heapUsage(i);
+}
+
+bool MemoryBudget::hasProperties(uint32_t type, vk::MemoryPropertyFlags flags) const {
+	return (properties.memoryTypes[type].propertyFlags & flags) == flags;
+}
+
+bool MemoryBudget::fits(uint32_t heap, vk::DeviceSize size) const {
+	return heapUsage(heap) + size <= counters.heapBudget[heap];
+}
+
+std::optional<uint32_t> MemoryBudget::chooseType(uint32_t typeBits, vk::MemoryPropertyFlags preferred, vk::MemoryPropertyFlags fallback, vk::DeviceSize size) const {
+	std::optional<uint32_t> anyPreferred;
+	for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+		if (!(typeBits & (1 << i)) || !hasProperties(i, preferred)) continue;
+		if (fits(properties.memoryTypes[i].heapIndex, size)) return i;
+		if (!anyPreferred) anyPreferred = i;
+	}
+
+	if (fallback != preferred) {
+		for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+			if ((typeBits & (1 << i)) && hasProperties(i, fallback) && fits(properties.memoryTypes[i].heapIndex, size)) return i;
+		}
+	}
+
+	// Over budget everywhere; let the driver decide whether it fits.
+	return anyPreferred;
+}
+
+void MemoryBudget::allocated(vk::DeviceMemory memory, vk::DeviceSize size, uint32_t type, MemoryCategory category, bool fallback) {
+	uint32_t heap = properties.memoryTypes[type].heapIndex;
+	allocations[memory] = {size, heap, category};
+	own[heap] += size;
+	counters.categories[static_cast<size_t>(category)] += size;
+	if (fallback) counters.fallbacks++;
+	update();
+}
+
+void MemoryBudget::freed(vk::DeviceMemory memory) {
+	auto it = allocations.find(memory);
+	if (it == allocations.end()) return;
+
+	own[it->second.heap] -= it->second.size;
+	counters.categories[static_cast<size_t>(it->second.category)] -= it->second.size;
+	allocations.erase(it);
+	update();
+}
+
+void MemoryBudget::setExternal(MemoryCategory category, vk::DeviceSize size) {
+	size_t index = static_cast<size_t>(category);
+	vk::DeviceSize& previous = external[index];
+	counters.categories[index] = counters.categories[index] - previous + size;
+	// Transient images live in the device-local heap.
+	own[localHeap] = own[localHeap] - previous + size;
+	previous = size;
+	update();
+}
+
+float MemoryBudget::deviceLocalPressure() const {
+	vk::DeviceSize budget = counters.heapBudget[localHeap];
+	return budget == 0 ? 0.0f : static_cast<float>(heapUsage(localHeap)) / budget;
+}
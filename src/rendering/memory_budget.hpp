@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+// What an allocation holds, for the counters and for deciding what to
+// give up under pressure.
+enum class MemoryCategory : uint8_t {
+	Meshes,
+	Textures,
+	Staging,
+	Uniforms,
+	RenderTargets,
+	Other
+};
+
+const size_t MEMORY_CATEGORY_COUNT = 6;
+// Without VK_EXT_memory_budget a heap is assumed to be this much ours.
+const float DEFAULT_HEAP_BUDGET = 0.8f;
+// Fractions of a heap's budget past which growth gives way to eviction,
+// and below which evicted data may come back.
+const float MEMORY_PRESSURE = 0.9f;
+const float MEMORY_RELIEF = 0.75f;
+
+const char *memoryCategoryName(MemoryCategory category);
+
+// Live numbers for the profiler. Heap usage is the driver's when the
+// budget extension is present, otherwise what this process allocated.
+struct MemoryCounters {
+	std::array<vk::DeviceSize, MEMORY_CATEGORY_COUNT> categories = {};
+	std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> heapUsage = {};
+	std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> heapBudget = {};
+	uint32_t heapCount = 0;
+	vk::DeviceSize total = 0;
+	vk::DeviceSize peak = 0;
+	// Allocations that wanted device-local memory and got host memory.
+	uint32_t fallbacks = 0;
+};
+
+// Accounts for every device memory allocation the renderer makes and
+// picks memory types against the heaps' budgets. With
+// VK_EXT_memory_budget the budgets and usage come from the driver,
+// refreshed once a frame, plus whatever was allocated since.
+class MemoryBudget {
+public:
+	static const char *extensionName() { return VK_EXT_MEMORY_BUDGET_EXTENSION_NAME; }
+
+	void init(vk::PhysicalDevice physicalDevice, bool extension);
+	void refresh();
+
+	// A type with all of preferred whose heap has room for size, else
+	// one with all of fallback, else a preferred one regardless.
+	std::optional<uint32_t> chooseType(uint32_t typeBits, vk::MemoryPropertyFlags preferred, vk::MemoryPropertyFlags fallback, vk::DeviceSize size) const;
+	bool hasProperties(uint32_t type, vk::MemoryPropertyFlags properties) const;
+
+	void allocated(vk::DeviceMemory memory, vk::DeviceSize size, uint32_t type, MemoryCategory category, bool fallback);
+	void freed(vk::DeviceMemory memory);
+	// Memory allocated elsewhere as one block, such as the render
+	// graph's transient images; replaces the previous amount.
+	void setExternal(MemoryCategory category, vk::DeviceSize size);
+
+	// Fraction of the main device-local heap's budget in use.
+	float deviceLocalPressure() const;
+	bool fits(uint32_t heap, vk::DeviceSize size) const;
+	uint32_t deviceLocalHeap() const { return localHeap; }
+
+	vk::DeviceSize used() const { return counters.total; }
+	const MemoryCounters& live() const { return counters; }
+private:
+	struct Allocation {
+		vk::DeviceSize size;
+		uint32_t heap;
+		MemoryCategory category;
+	};
+
+	vk::PhysicalDevice physicalDevice;
+	vk::PhysicalDeviceMemoryProperties properties;
+	bool extension = false;
+	uint32_t localHeap = 0;
+	std::unordered_map<VkDeviceMemory, Allocation> allocations;
+	std::array<vk::DeviceSize, MEMORY_CATEGORY_COUNT> external = {};
+	// Bytes per heap this process holds, and how many of them the
+	// driver's last report already included.
+	std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> own = {};
+	std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> ownAtRefresh = {};
+	std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> driverUsage = {};
+	MemoryCounters counters;
+
+	vk::DeviceSize heapUsage(uint32_t heap) const;
+	void update();
+};
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <vulkan/vulkan.hpp>
 #include <glm/glm.hpp>
 #include <array>
 
 struct Vertex {
-    glm::vec2 pos;
-    glm::vec3 color;
+    glm::vec3 pos;
+    glm::vec4 color;
+    glm::vec2 light;
 
 	static vk::VertexInputBindingDescription getBindingDescription() {
 		vk::VertexInputBindingDescription bindingDescription;
@@ -18,31 +20,61 @@ struct Vertex {
     }
 
 	
-	static std::array<vk::VertexInputAttributeDescription, 2> getAttributeDescriptions() {
-		std::array<vk::VertexInputAttributeDescription, 2> attributeDescriptions{};
+	static std::array<vk::VertexInputAttributeDescription, 3> getAttributeDescriptions() {
+		std::array<vk::VertexInputAttributeDescription, 3> attributeDescriptions{};
 
 		attributeDescriptions[0].binding = 0;
 		attributeDescriptions[0].location = 0;
-		attributeDescriptions[0].format = vk::Format::eR32G32Sfloat;
+		attributeDescriptions[0].format = vk::Format::eR32G32B32Sfloat;
 		attributeDescriptions[0].offset = offsetof(Vertex, pos);
 
 		attributeDescriptions[1].binding = 0;
 		attributeDescriptions[1].location = 1;
-		attributeDescriptions[1].format = vk::Format::eR32G32B32Sfloat;
+		attributeDescriptions[1].format = vk::Format::eR32G32B32A32Sfloat;
 		attributeDescriptions[1].offset = offsetof(Vertex, color);
 
+		attributeDescriptions[2].binding = 0;
+		attributeDescriptions[2].location = 2;
+		attributeDescriptions[2].format = vk::Format::eR32G32Sfloat;
+		attributeDescriptions[2].offset = offsetof(Vertex, light);
+
 		return attributeDescriptions;
 	}
 
 };
 
-const std::vector<Vertex> vertices = {
-    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
-    {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
-    {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
-    {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}}
-};
+// Per-instance data for entity models, read through a second vertex
+// binding that advances once per instance. Velocity lets the vertex
+// shader carry an entity forward between simulation ticks.
+struct InstanceData {
+	glm::vec3 position;
+	float yaw;
+	glm::vec3 velocity;
+	float scale;
 
-const std::vector<uint16_t> indices = {
-    0, 1, 2, 2, 3, 0
+	static vk::VertexInputBindingDescription getBindingDescription() {
+		vk::VertexInputBindingDescription bindingDescription;
+
+		bindingDescription.binding = 1;
+		bindingDescription.stride = sizeof(InstanceData);
+		bindingDescription.inputRate = vk::VertexInputRate::eInstance;
+
+		return bindingDescription;
+	}
+
+	static std::array<vk::VertexInputAttributeDescription, 2> getAttributeDescriptions() {
+		std::array<vk::VertexInputAttributeDescription, 2> attributeDescriptions{};
+
+		attributeDescriptions[0].binding = 1;
+		attributeDescriptions[0].location = 3;
+		attributeDescriptions[0].format = vk::Format::eR32G32B32A32Sfloat;
+		attributeDescriptions[0].offset = offsetof(InstanceData, position);
+
+		attributeDescriptions[1].binding = 1;
+		attributeDescriptions[1].location = 4;
+		attributeDescriptions[1].format = vk::Format::eR32G32B32A32Sfloat;
+		attributeDescriptions[1].offset = offsetof(InstanceData, velocity);
+
+		return attributeDescriptions;
+	}
 };
@@ -0,0 +1,284 @@
+#include <rendering/mesher.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+
+struct Face {
+	int dx, dy, dz;
+	float shade;
+	int corners[4][3];
+};
+
+// Corners are counter-clockwise seen from outside the block.
+static const Face FACES[6] = {
+	{-1, 0, 0, 0.8f, {{0, 0, 0}, {0, 0, 1}, {0, 1, 1}, {0, 1, 0}}},
+	{1, 0, 0, 0.8f, {{1, 0, 0}, {1, 1, 0}, {1, 1, 1}, {1, 0, 1}}},
+	{0, -1, 0, 0.5f, {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}}},
+	{0, 1, 0, 1.0f, {{0, 1, 0}, {0, 1, 1}, {1, 1, 1}, {1, 1, 0}}},
+	{0, 0, -1, 0.7f, {{0, 0, 0}, {0, 1, 0}, {1, 1, 0}, {1, 0, 0}}},
+	{0, 0, 1, 0.7f, {{0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}}}
+};
+
+const int MESH_INPUT_VOLUME = MESH_INPUT_SIZE * MESH_INPUT_SIZE * MESH_INPUT_SIZE;
+
+glm::vec4 blockColor(BlockId id) {
+	uint32_t color = blockColorRGBA(id);
+	return glm::vec4(color >> 24, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF) / 255.0f;
+}
+
+void gatherSection(const World& world, SectionPos pos, MeshInput& input) {
+	input.pos = pos;
+
+	const Chunk *center = world.getChunk({pos.x, pos.z});
+	input.empty = !center || center->sections[pos.y].isEmpty();
+	if (input.empty) return;
+
+	const Chunk *chunks[3][3];
+	const ChunkLight *lights[3][3];
+	for (int dx = -1; dx <= 1; dx++) {
+		for (int dz = -1; dz <= 1; dz++) {
+			chunks[dx + 1][dz + 1] = world.getChunk({pos.x + dx, pos.z + dz});
+			lights[dx + 1][dz + 1] = world.getLight({pos.x + dx, pos.z + dz});
+		}
+	}
+
+	for (int y = -1; y <= SECTION_SIZE; y++) {
+		int wy = pos.y * SECTION_SIZE + y;
+		bool inside = wy >= 0 && wy < CHUNK_HEIGHT;
+
+		for (int z = -1; z <= SECTION_SIZE; z++) {
+			int cz = z < 0 ? 0 : (z >= SECTION_SIZE ? 2 : 1);
+
+			for (int x = -1; x <= SECTION_SIZE; x++) {
+				int cx = x < 0 ? 0 : (x >= SECTION_SIZE ? 2 : 1);
+				const Chunk *chunk = chunks[cx][cz];
+				const ChunkLight *light = lights[cx][cz];
+
+				// Open sky wherever nothing is loaded, so borders of the
+				// loaded area are not drawn dark.
+				BlockId id = AIR;
+				uint8_t level = wy < 0 ? 0 : MAX_LIGHT << 4;
+				if (inside && chunk) {
+					int i = Section::index(x & (SECTION_SIZE - 1), wy & (SECTION_SIZE - 1), z & (SECTION_SIZE - 1));
+					id = chunk->sections[wy >> 4].get(i);
+					const SectionLight& section = light->sections[wy >> 4];
+					level = static_cast<uint8_t>(section.get(LightChannel::Block, i) | (section.get(LightChannel::Sky, i) << 4));
+				}
+				input.blocks[MeshInput::index(x, y, z)] = id;
+				input.light[MeshInput::index(x, y, z)] = level;
+			}
+		}
+	}
+}
+
+// Flood fills the non-opaque blocks of the section and records which
+// faces each connected region touches.
+static FaceConnectivity computeConnectivity(const MeshInput& input) {
+	std::array<bool, SECTION_VOLUME> visited;
+	int open = 0;
+	for (int i = 0; i < SECTION_VOLUME; i++) {
+		visited[i] = isOpaque(input.at(i % SECTION_SIZE, i / (SECTION_SIZE * SECTION_SIZE), (i / SECTION_SIZE) % SECTION_SIZE));
+		if (!visited[i]) open++;
+	}
+
+	if (open == 0) return 0;
+	if (open == SECTION_VOLUME) return ALL_FACES_CONNECTED;
+
+	FaceConnectivity connectivity = 0;
+	std::vector<int> stack;
+
+	for (int start = 0; start < SECTION_VOLUME; start++) {
+		if (visited[start]) continue;
+
+		visited[start] = true;
+		stack.push_back(start);
+		int faces = 0;
+
+		while (!stack.empty()) {
+			int i = stack.back();
+			stack.pop_back();
+
+			int x = i % SECTION_SIZE;
+			int y = i / (SECTION_SIZE * SECTION_SIZE);
+			int z = (i / SECTION_SIZE) % SECTION_SIZE;
+
+			if (x == 0) faces |= 1 << 0;
+			if (x == SECTION_SIZE - 1) faces |= 1 << 1;
+			if (y == 0) faces |= 1 << 2;
+			if (y == SECTION_SIZE - 1) faces |= 1 << 3;
+			if (z == 0) faces |= 1 << 4;
+			if (z == SECTION_SIZE - 1) faces |= 1 << 5;
+
+			for (const Face& face : FACES) {
+				int nx = x + face.dx;
+				int ny = y + face.dy;
+				int nz = z + face.dz;
+				if (nx < 0 || ny < 0 || nz < 0 || nx >= SECTION_SIZE || ny >= SECTION_SIZE || nz >= SECTION_SIZE) continue;
+
+				int n = Section::index(nx, ny, nz);
+				if (visited[n]) continue;
+
+				visited[n] = true;
+				stack.push_back(n);
+			}
+		}
+
+		for (int a = 0; a < 6; a++) {
+			for (int b = a + 1; b < 6; b++) {
+				if ((faces >> a & 1) && (faces >> b & 1)) connectivity |= 1 << facePair(a, b);
+			}
+		}
+	}
+
+	return connectivity;
+}
+
+// Finds the thickest slab of fully opaque layers, which the occlusion
+// culler uses as a cheap stand-in for the section's solid volume.
+static void findOccluder(const MeshInput& input, SectionMesh& mesh) {
+	int runStart = 0;
+	for (int y = 0; y <= SECTION_SIZE; y++) {
+		bool full = y < SECTION_SIZE;
+		for (int z = 0; full && z < SECTION_SIZE; z++) {
+			for (int x = 0; full && x < SECTION_SIZE; x++) {
+				full = isOpaque(input.at(x, y, z));
+			}
+		}
+		if (full) continue;
+
+		if (y - runStart > mesh.occluderTop - mesh.occluderBottom) {
+			mesh.occluderBottom = static_cast<uint8_t>(runStart);
+			mesh.occluderTop = static_cast<uint8_t>(y);
+		}
+		runStart = y + 1;
+	}
+}
+
+void meshSection(const MeshInput& input, SectionMesh& mesh, bool opaque) {
+	mesh.vertices.clear();
+	mesh.translucent.clear();
+	mesh.connectivity = ALL_FACES_CONNECTED;
+	mesh.occluderBottom = 0;
+	mesh.occluderTop = 0;
+	if (input.empty) return;
+
+	mesh.connectivity = computeConnectivity(input);
+	findOccluder(input, mesh);
+
+	for (int y = 0; y < SECTION_SIZE; y++) {
+		for (int z = 0; z < SECTION_SIZE; z++) {
+			for (int x = 0; x < SECTION_SIZE; x++) {
+				// Blocks in no render layer are skipped like air, which is
+				// also what the compute mesher and countOpaqueQuads do.
+				BlockId id = input.at(x, y, z);
+				RenderLayer layer = renderLayer(id);
+				if (layer == RenderLayer::None || (!opaque && layer != RenderLayer::Translucent)) continue;
+
+				glm::vec4 color = blockColor(id);
+				std::vector<Vertex>& vertices = layer == RenderLayer::Translucent ? mesh.translucent : mesh.vertices;
+
+				for (const Face& face : FACES) {
+					BlockId neighbour = input.at(x + face.dx, y + face.dy, z + face.dz);
+					if (neighbour == id || isOpaque(neighbour)) continue;
+
+					// Faces take the light of the cell they face.
+					uint8_t level = input.light[MeshInput::index(x + face.dx, y + face.dy, z + face.dz)];
+					glm::vec2 light((level & 0xF) / 15.0f, (level >> 4) / 15.0f);
+
+					for (const auto& corner : face.corners) {
+						glm::vec3 position(x + corner[0], y + corner[1], z + corner[2]);
+						vertices.push_back({position, glm::vec4(glm::vec3(color) * face.shade, color.a), light});
+					}
+				}
+			}
+		}
+	}
+}
+
+// Counts the faces opaque blocks show towards non-opaque neighbours a row
+// at a time: bit x + 1 of a row is set where that cell is opaque, and
+// each direction is the row masked by its shifted or adjacent neighbour.
+static uint32_t countOpaqueQuads(const MeshInput& input) {
+	std::array<uint32_t, MESH_INPUT_SIZE * MESH_INPUT_SIZE> rows{};
+	for (int y = -1; y <= SECTION_SIZE; y++) {
+		for (int z = -1; z <= SECTION_SIZE; z++) {
+			uint32_t& row = rows[(y + 1) * MESH_INPUT_SIZE + (z + 1)];
+			for (int x = -1; x <= SECTION_SIZE; x++) {
+				if (isOpaque(input.at(x, y, z))) row |= 1u << (x + 1);
+			}
+		}
+	}
+
+	const uint32_t inside = ((1u << SECTION_SIZE) - 1) << 1;
+	auto at = [&](int y, int z) { return rows[(y + 1) * MESH_INPUT_SIZE + (z + 1)]; };
+
+	uint32_t quads = 0;
+	for (int y = 0; y < SECTION_SIZE; y++) {
+		for (int z = 0; z < SECTION_SIZE; z++) {
+			uint32_t full = at(y, z);
+			uint32_t row = full & inside;
+			quads += __builtin_popcount(row & ~(full << 1));
+			quads += __builtin_popcount(row & ~(full >> 1));
+			quads += __builtin_popcount(row & ~at(y - 1, z));
+			quads += __builtin_popcount(row & ~at(y + 1, z));
+			quads += __builtin_popcount(row & ~at(y, z - 1));
+			quads += __builtin_popcount(row & ~at(y, z + 1));
+		}
+	}
+	return quads;
+}
+
+bool packSection(const MeshInput& input, PackedSection& packed) {
+	packed.palette.clear();
+
+	std::array<uint8_t, MESH_INPUT_VOLUME> local;
+	for (int i = 0; i < MESH_INPUT_VOLUME; i++) {
+		BlockId id = input.blocks[i];
+		auto it = std::find(packed.palette.begin(), packed.palette.end(), id);
+		if (it == packed.palette.end()) {
+			// Indices are a byte wide; with mods a section and its border
+			// can hold more kinds of block than that.
+			if (packed.palette.size() == 256) return false;
+			packed.palette.push_back(id);
+			it = std::prev(packed.palette.end());
+		}
+		local[i] = static_cast<uint8_t>(it - packed.palette.begin());
+	}
+
+	packed.bits = 1;
+	while ((1u << packed.bits) < packed.palette.size()) packed.bits *= 2;
+
+	uint32_t perWord = 32 / packed.bits;
+	packed.indices.assign((MESH_INPUT_VOLUME + perWord - 1) / perWord, 0);
+	for (int i = 0; i < MESH_INPUT_VOLUME; i++) {
+		packed.indices[i / perWord] |= static_cast<uint32_t>(local[i]) << ((i % perWord) * packed.bits);
+	}
+
+	packed.light.assign((MESH_INPUT_VOLUME + 3) / 4, 0);
+	for (int i = 0; i < MESH_INPUT_VOLUME; i++) {
+		packed.light[i / 4] |= static_cast<uint32_t>(input.light[i]) << ((i % 4) * 8);
+	}
+
+	packed.quadCount = countOpaqueQuads(input);
+	return true;
+}
+
+void meshDirtySections(World& world, JobSystem& jobs, MeshBatch& batch, MeshBackend backend) {
+	batch.positions = world.takeDirtySections();
+	batch.meshes.resize(batch.positions.size());
+	batch.loaded.resize(batch.positions.size());
+
+	jobs.parallelFor(batch.positions.size(), [&](size_t i) {
+		MeshInput input;
+		gatherSection(world, batch.positions[i], input);
+
+		SectionMesh& mesh = batch.meshes[i];
+		mesh.packed.reset();
+		if (backend != MeshBackend::Cpu && !input.empty) {
+			mesh.packed.emplace();
+			if (!packSection(input, *mesh.packed)) mesh.packed.reset();
+		}
+		// Sections the compute mesher cannot take are meshed here whole.
+		meshSection(input, mesh, backend != MeshBackend::Gpu || !mesh.packed);
+		batch.loaded[i] = world.getChunk({batch.positions[i].x, batch.positions[i].z}) != nullptr;
+	});
+}
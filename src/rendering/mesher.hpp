@@ -0,0 +1,107 @@
+#pragma once
+
+#include <rendering/mesh.hpp>
+#include <world/world.hpp>
+#include <core/jobs.hpp>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+const int MESH_INPUT_SIZE = SECTION_SIZE + 2;
+
+// Each boundary between two cells, border included, emits at most one
+// face, which keeps a section's vertex count within 16-bit indices.
+const uint32_t MAX_SECTION_QUADS = 3 * (SECTION_SIZE + 1) * SECTION_SIZE * SECTION_SIZE;
+
+// Set of section face pairs that are connected through non-opaque blocks,
+// with faces numbered -X, +X, -Y, +Y, -Z, +Z so the opposite face is
+// face ^ 1.
+using FaceConnectivity = uint16_t;
+
+const FaceConnectivity ALL_FACES_CONNECTED = 0x7FFF;
+
+inline int facePair(int a, int b) {
+	int lo = a < b ? a : b;
+	int hi = a < b ? b : a;
+	return lo * (11 - lo) / 2 + (hi - lo - 1);
+}
+
+inline bool connects(FaceConnectivity connectivity, int a, int b) {
+	return a == b || ((connectivity >> facePair(a, b)) & 1);
+}
+
+// A section plus a one-block border copied out of the world, so meshing
+// itself never touches the world and can run on any thread. Light keeps
+// the block level in the low nibble and the sky level in the high one.
+struct MeshInput {
+	SectionPos pos;
+	bool empty;
+	std::array<BlockId, MESH_INPUT_SIZE * MESH_INPUT_SIZE * MESH_INPUT_SIZE> blocks;
+	std::array<uint8_t, MESH_INPUT_SIZE * MESH_INPUT_SIZE * MESH_INPUT_SIZE> light;
+
+	static int index(int x, int y, int z) {
+		return ((y + 1) * MESH_INPUT_SIZE + (z + 1)) * MESH_INPUT_SIZE + (x + 1);
+	}
+
+	BlockId at(int x, int y, int z) const {
+		return blocks[index(x, y, z)];
+	}
+};
+
+// A section and its border as a palette plus indices of the smallest
+// power-of-two width that holds it, for the compute mesher. Indices
+// never straddle a 32-bit word and light is packed four cells to a word.
+// quadCount is the exact number of opaque faces, so the renderer can
+// size the vertex block before the GPU has produced anything.
+struct PackedSection {
+	std::vector<uint32_t> palette;
+	uint32_t bits = 1;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> light;
+	uint32_t quadCount = 0;
+};
+
+// Which mesher builds opaque faces. With Gpu the CPU still meshes
+// translucent faces, which have to be sorted on the CPU anyway, and
+// derives connectivity and occluders; GpuValidated additionally builds
+// the opaque faces on the CPU so the renderer can compare the two.
+enum class MeshBackend {
+	Cpu,
+	Gpu,
+	GpuValidated
+};
+
+// Faces are emitted as four vertices each, positioned relative to the
+// section's minimum corner. Opaque faces are drawn with
+// the renderer's shared quad index buffer; translucent ones are kept
+// apart so they can be sorted back to front.
+struct SectionMesh {
+	std::vector<Vertex> vertices;
+	std::vector<Vertex> translucent;
+	// Set when the opaque faces are left to the compute mesher.
+	std::optional<PackedSection> packed;
+	FaceConnectivity connectivity = ALL_FACES_CONNECTED;
+	// Longest run of completely opaque layers, as section-local y bounds.
+	uint8_t occluderBottom = 0;
+	uint8_t occluderTop = 0;
+
+	uint32_t quadCount() const { return packed ? packed->quadCount : static_cast<uint32_t>(vertices.size() / 4); }
+	bool empty() const { return quadCount() == 0 && translucent.empty(); }
+};
+
+// Sections remeshed on the simulation thread, handed to the renderer as
+// one unit. Loaded records whether each section's column still exists.
+struct MeshBatch {
+	std::vector<SectionPos> positions;
+	std::vector<SectionMesh> meshes;
+	std::vector<uint8_t> loaded;
+};
+
+glm::vec4 blockColor(BlockId id);
+void gatherSection(const World& world, SectionPos pos, MeshInput& input);
+void meshSection(const MeshInput& input, SectionMesh& mesh, bool opaque = true);
+// False when the section holds too many kinds of block to pack.
+bool packSection(const MeshInput& input, PackedSection& packed);
+// Takes the world's dirty sections and meshes them in parallel.
+void meshDirtySections(World& world, JobSystem& jobs, MeshBatch& batch, MeshBackend backend = MeshBackend::Cpu);
@@ -0,0 +1,247 @@
+#include <rendering/occlusion.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define OCCLUSION_SSE 1
+#endif
+
+const int BANDS = 8;
+const int BAND_ROWS = HIZ_HEIGHT / BANDS;
+const size_t CULL_BATCH = 1024;
+
+// Boxes reaching this close to the eye plane are left out or treated as
+// visible instead of being clipped.
+const float MIN_W = 1e-3f;
+
+// Box corners are numbered with x in bit 0, y in bit 1 and z in bit 2;
+// faces wind counter-clockwise seen from outside.
+static const int BOX_FACES[6][4] = {
+	{0, 4, 6, 2}, {1, 3, 7, 5},
+	{0, 1, 5, 4}, {2, 6, 7, 3},
+	{0, 2, 3, 1}, {4, 5, 7, 6}
+};
+
+static glm::vec3 corner(glm::vec3 min, glm::vec3 max, int c) {
+	return glm::vec3(c & 1 ? max.x : min.x, c & 2 ? max.y : min.y, c & 4 ? max.z : min.z);
+}
+
+OcclusionCuller::OcclusionCuller() : viewProjection(1.0f) {
+	for (int level = 0; level < HIZ_LEVELS; level++) {
+		levels[level].assign(static_cast<size_t>(HIZ_WIDTH >> level) * (HIZ_HEIGHT >> level), 1.0f);
+	}
+	// At most three front faces of two triangles per box.
+	triangles.reserve(MAX_OCCLUDERS * 6);
+}
+
+void OcclusionCuller::render(const glm::mat4& viewProjection, const Occluder *occluders, size_t count, JobSystem& jobs) {
+	this->viewProjection = viewProjection;
+	triangles.clear();
+
+	for (size_t i = 0; i < count; i++) {
+		const Occluder& occluder = occluders[i];
+		glm::vec2 screen[8];
+		float depth = 0.0f;
+		bool clipped = false;
+
+		for (int c = 0; c < 8; c++) {
+			glm::vec4 clip = viewProjection * glm::vec4(corner(occluder.min, occluder.max, c), 1.0f);
+			if (clip.w < MIN_W) {
+				clipped = true;
+				break;
+			}
+
+			screen[c] = glm::vec2((clip.x / clip.w * 0.5f + 0.5f) * HIZ_WIDTH, (0.5f - clip.y / clip.w * 0.5f) * HIZ_HEIGHT);
+			depth = std::max(depth, clip.z / clip.w);
+		}
+
+		if (clipped || depth >= 1.0f) continue;
+
+		// Every face is drawn at the depth of the box's farthest corner,
+		// which can only make the occluder look further away than it is.
+		// Screen y points down, so front faces come out clockwise.
+		for (const auto& face : BOX_FACES) {
+			glm::vec2 a = screen[face[0]], b = screen[face[1]], c = screen[face[2]];
+			if ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) >= 0.0f) continue;
+
+			float top = std::min({a.y, b.y, c.y, screen[face[3]].y});
+			float bottom = std::max({a.y, b.y, c.y, screen[face[3]].y});
+			triangles.push_back({{a, b, c}, depth, top, bottom});
+			triangles.push_back({{a, c, screen[face[3]]}, depth, top, bottom});
+		}
+	}
+
+	std::fill(levels[0].begin(), levels[0].end(), 1.0f);
+
+	jobs.parallelFor(BANDS, [&](size_t band) {
+		int rowBegin = static_cast<int>(band) * BAND_ROWS;
+		for (const Triangle& triangle : triangles) {
+			if (triangle.bottom < rowBegin || triangle.top >= rowBegin + BAND_ROWS) continue;
+			rasterize(triangle, rowBegin, rowBegin + BAND_ROWS);
+		}
+	});
+
+	buildPyramid();
+}
+
+void OcclusionCuller::rasterize(const Triangle& triangle, int rowBegin, int rowEnd) {
+	glm::vec2 v0 = triangle.v[0];
+	glm::vec2 v1 = triangle.v[1];
+	glm::vec2 v2 = triangle.v[2];
+
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if (std::fabs(area) < 1e-6f) return;
+	if (area < 0.0f) std::swap(v1, v2);
+
+	int minY = std::max(rowBegin, static_cast<int>(std::floor(std::min({v0.y, v1.y, v2.y}))));
+	int maxY = std::min(rowEnd - 1, static_cast<int>(std::ceil(std::max({v0.y, v1.y, v2.y}))));
+	int minX = std::max(0, static_cast<int>(std::floor(std::min({v0.x, v1.x, v2.x}))));
+	int maxX = std::min(HIZ_WIDTH - 1, static_cast<int>(std::ceil(std::max({v0.x, v1.x, v2.x}))));
+	if (minY > maxY || minX > maxX) return;
+
+	// Edge functions are evaluated at pixel centres, which keeps the two
+	// triangles of a face and neighbouring boxes free of gaps.
+	float a[3], b[3], c[3];
+	const glm::vec2 *edges[3][2] = {{&v0, &v1}, {&v1, &v2}, {&v2, &v0}};
+	for (int e = 0; e < 3; e++) {
+		const glm::vec2& from = *edges[e][0];
+		const glm::vec2& to = *edges[e][1];
+		a[e] = from.y - to.y;
+		b[e] = to.x - from.x;
+		c[e] = -(a[e] * from.x + b[e] * from.y);
+	}
+
+	float *depth = levels[0].data();
+	minX &= ~3;
+
+	for (int y = minY; y <= maxY; y++) {
+		float cy = static_cast<float>(y) + 0.5f;
+		float *row = depth + y * HIZ_WIDTH;
+
+#ifdef OCCLUSION_SSE
+		__m128 rowE[3], stepA[3];
+		for (int e = 0; e < 3; e++) {
+			rowE[e] = _mm_set1_ps(b[e] * cy + c[e]);
+			stepA[e] = _mm_set1_ps(a[e]);
+		}
+		__m128 zero = _mm_setzero_ps();
+		__m128 triangleDepth = _mm_set1_ps(triangle.depth);
+
+		for (int x = minX; x <= maxX; x += 4) {
+			__m128 xs = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(stepA[0], xs), rowE[0]);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(stepA[1], xs), rowE[1]);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(stepA[2], xs), rowE[2]);
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+			if (_mm_movemask_ps(inside) == 0) continue;
+
+			__m128 old = _mm_loadu_ps(row + x);
+			__m128 nearer = _mm_min_ps(old, triangleDepth);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+		}
+#else
+		for (int x = minX; x <= maxX; x++) {
+			float cx = static_cast<float>(x) + 0.5f;
+			bool inside = true;
+			for (int e = 0; e < 3; e++) {
+				if (a[e] * cx + b[e] * cy + c[e] < 0.0f) inside = false;
+			}
+			if (inside) row[x] = std::min(row[x], triangle.depth);
+		}
+#endif
+	}
+}
+
+void OcclusionCuller::buildPyramid() {
+	for (int level = 1; level < HIZ_LEVELS; level++) {
+		const std::vector<float>& src = levels[level - 1];
+		std::vector<float>& dst = levels[level];
+		int srcWidth = HIZ_WIDTH >> (level - 1);
+		int width = HIZ_WIDTH >> level;
+		int height = HIZ_HEIGHT >> level;
+
+		for (int y = 0; y < height; y++) {
+			const float *top = &src[(y * 2) * srcWidth];
+			const float *bottom = top + srcWidth;
+			for (int x = 0; x < width; x++) {
+				dst[y * width + x] = std::max(std::max(top[x * 2], top[x * 2 + 1]), std::max(bottom[x * 2], bottom[x * 2 + 1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::visible(glm::vec3 min, glm::vec3 max) const {
+	float minX = HIZ_WIDTH, maxX = 0.0f;
+	float minY = HIZ_HEIGHT, maxY = 0.0f;
+	float nearest = 1.0f;
+
+	// The eight corners as the transformed minimum corner plus the
+	// transformed edge vectors.
+	glm::vec4 base = viewProjection * glm::vec4(min, 1.0f);
+	glm::vec4 dx = viewProjection[0] * (max.x - min.x);
+	glm::vec4 dy = viewProjection[1] * (max.y - min.y);
+	glm::vec4 dz = viewProjection[2] * (max.z - min.z);
+
+	for (int c = 0; c < 8; c++) {
+		glm::vec4 clip = base;
+		if (c & 1) clip = clip + dx;
+		if (c & 2) clip = clip + dy;
+		if (c & 4) clip = clip + dz;
+		if (clip.w < MIN_W) return true;
+
+		float inverse = 1.0f / clip.w;
+		float x = (clip.x * inverse * 0.5f + 0.5f) * HIZ_WIDTH;
+		float y = (0.5f - clip.y * inverse * 0.5f) * HIZ_HEIGHT;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z * inverse);
+	}
+
+	if (nearest <= 0.0f) return true;
+	if (maxX < 0.0f || maxY < 0.0f || minX >= HIZ_WIDTH || minY >= HIZ_HEIGHT) return true;
+
+	// Grown by a texel on each side: an occluder edge can cover a pixel
+	// centre while leaving part of that pixel open.
+	int x0 = std::clamp(static_cast<int>(minX) - 1, 0, HIZ_WIDTH - 1);
+	int x1 = std::clamp(static_cast<int>(maxX) + 1, 0, HIZ_WIDTH - 1);
+	int y0 = std::clamp(static_cast<int>(minY) - 1, 0, HIZ_HEIGHT - 1);
+	int y1 = std::clamp(static_cast<int>(maxY) + 1, 0, HIZ_HEIGHT - 1);
+
+	int level = 0;
+	while (level < HIZ_LEVELS - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+		level++;
+	}
+
+	const std::vector<float>& depth = levels[level];
+	int width = HIZ_WIDTH >> level;
+	float farthest = 0.0f;
+	for (int y = y0 >> level; y <= y1 >> level; y++) {
+		for (int x = x0 >> level; x <= x1 >> level; x++) {
+			farthest = std::max(farthest, depth[y * width + x]);
+		}
+	}
+
+	return nearest <= farthest;
+}
+
+void OcclusionCuller::cull(std::vector<SectionPos>& sections, JobSystem& jobs, LinearArena& scratch) const {
+	FrameVector<uint8_t> keep(sections.size(), 0, FrameAllocator<uint8_t>(scratch));
+
+	size_t batches = (sections.size() + CULL_BATCH - 1) / CULL_BATCH;
+	jobs.parallelFor(batches, [&](size_t batch) {
+		size_t end = std::min(sections.size(), (batch + 1) * CULL_BATCH);
+		for (size_t i = batch * CULL_BATCH; i < end; i++) {
+			glm::vec3 min(sections[i].x * SECTION_SIZE, sections[i].y * SECTION_SIZE, sections[i].z * SECTION_SIZE);
+			keep[i] = visible(min, min + glm::vec3(SECTION_SIZE));
+		}
+	});
+
+	size_t out = 0;
+	for (size_t i = 0; i < sections.size(); i++) {
+		if (keep[i]) sections[out++] = sections[i];
+	}
+	sections.resize(out);
+}
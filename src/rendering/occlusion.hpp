@@ -0,0 +1,51 @@
+#pragma once
+
+#include <core/jobs.hpp>
+#include <core/frame_arena.hpp>
+#include <world/chunk.hpp>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+const int HIZ_WIDTH = 256;
+const int HIZ_HEIGHT = 128;
+const int HIZ_LEVELS = 8;
+const size_t MAX_OCCLUDERS = 768;
+
+// A solid box, in world space, that is guaranteed to block sight.
+struct Occluder {
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// Software occlusion culling against a low resolution depth buffer.
+//
+// render() rasterizes the occluder boxes at their farthest depth into a
+// 256x128 buffer, split into horizontal bands that are filled in
+// parallel, and builds a max-depth mip pyramid from it. A box is then
+// occluded when its nearest point lies behind every texel around its
+// screen rectangle, read from the smallest mip level where that spans at
+// most 2x2 texels.
+class OcclusionCuller {
+public:
+	OcclusionCuller();
+
+	void render(const glm::mat4& viewProjection, const Occluder *occluders, size_t count, JobSystem& jobs);
+	bool visible(glm::vec3 min, glm::vec3 max) const;
+	void cull(std::vector<SectionPos>& sections, JobSystem& jobs, LinearArena& scratch) const;
+private:
+	struct Triangle {
+		glm::vec2 v[3];
+		float depth;
+		// Rows spanned by the whole face, for skipping other bands.
+		float top;
+		float bottom;
+	};
+
+	glm::mat4 viewProjection;
+	std::vector<Triangle> triangles;
+	std::array<std::vector<float>, HIZ_LEVELS> levels;
+
+	void rasterize(const Triangle& triangle, int rowBegin, int rowEnd);
+	void buildPyramid();
+};
@@ -0,0 +1,522 @@
+#include <rendering/render_graph.hpp>
+#include <algorithm>
+#include <cassert>
+
+const vk::AccessFlags WRITE_ACCESS = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eTransferWrite;
+
+static bool isDepthFormat(vk::Format format) {
+	switch (format) {
+		case vk::Format::eD16Unorm:
+		case vk::Format::eD32Sfloat:
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static bool hasStencil(vk::Format format) {
+	return format == vk::Format::eD16UnormS8Uint || format == vk::Format::eD24UnormS8Uint || format == vk::Format::eD32SfloatS8Uint;
+}
+
+static bool isWrite(GraphAccess access) {
+	return access == GraphAccess::ColorWrite || access == GraphAccess::DepthWrite || access == GraphAccess::TransferWrite;
+}
+
+void RenderGraph::init(vk::Device device, vk::PhysicalDevice physicalDevice) {
+	this->device = device;
+	this->physicalDevice = physicalDevice;
+}
+
+GraphImage RenderGraph::importImage(const std::string& name, vk::Format format, vk::Extent2D extent, const std::vector<vk::Image>& images, const std::vector<vk::ImageView>& views, vk::ImageLayout finalLayout) {
+	Resource resource;
+	resource.name = name;
+	resource.format = format;
+	resource.extent = extent;
+	resource.imported = true;
+	resource.finalLayout = finalLayout;
+	resource.images = images;
+	resource.views = views;
+	resources.push_back(resource);
+	return static_cast<GraphImage>(resources.size() - 1);
+}
+
+GraphImage RenderGraph::createImage(const std::string& name, vk::Format format, vk::Extent2D extent) {
+	Resource resource;
+	resource.name = name;
+	resource.format = format;
+	resource.extent = extent;
+	resource.imported = false;
+	resources.push_back(resource);
+	return static_cast<GraphImage>(resources.size() - 1);
+}
+
+void RenderGraph::markOutput(GraphImage image) {
+	resources[image].output = true;
+}
+
+GraphPass RenderGraph::addPass(const std::string& name, bool raster, std::function<void(vk::CommandBuffer)> execute) {
+	Pass pass;
+	pass.name = name;
+	pass.raster = raster;
+	pass.execute = std::move(execute);
+	passes.push_back(std::move(pass));
+	return static_cast<GraphPass>(passes.size() - 1);
+}
+
+void RenderGraph::use(GraphPass pass, GraphImage image, GraphAccess access, std::optional<vk::ClearValue> clear) {
+	passes[pass].uses.push_back({image, access, clear});
+}
+
+void RenderGraph::writeColor(GraphPass pass, GraphImage image, std::optional<vk::ClearColorValue> clear) {
+	std::optional<vk::ClearValue> value;
+	if (clear) value = vk::ClearValue(*clear);
+	use(pass, image, GraphAccess::ColorWrite, value);
+}
+
+void RenderGraph::writeDepth(GraphPass pass, GraphImage image, std::optional<float> clear) {
+	std::optional<vk::ClearValue> value;
+	if (clear) value = vk::ClearValue(vk::ClearDepthStencilValue(*clear, 0));
+	use(pass, image, GraphAccess::DepthWrite, value);
+}
+
+void RenderGraph::readDepth(GraphPass pass, GraphImage image) {
+	use(pass, image, GraphAccess::DepthRead, std::nullopt);
+}
+
+void RenderGraph::readTransfer(GraphPass pass, GraphImage image) {
+	use(pass, image, GraphAccess::TransferRead, std::nullopt);
+}
+
+void RenderGraph::writeTransfer(GraphPass pass, GraphImage image) {
+	use(pass, image, GraphAccess::TransferWrite, std::nullopt);
+}
+
+void RenderGraph::setRenderArea(GraphPass pass, vk::Extent2D area) {
+	passes[pass].area = area;
+}
+
+void RenderGraph::compile() {
+	for (Resource& resource : resources) {
+		bool depth = isDepthFormat(resource.format);
+		resource.aspect = depth ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+		if (hasStencil(resource.format)) resource.aspect |= vk::ImageAspectFlagBits::eStencil;
+	}
+
+	cull();
+	buildSteps();
+	allocateImages();
+	planBarriers();
+	createRenderPasses();
+
+	size_t most = finalBarriers.size();
+	for (const Step& step : steps) most = std::max(most, step.barriers.size());
+	scratch.resize(most);
+}
+
+// Walks the passes backwards from the outputs: a pass is kept when it
+// writes an image something later needs, and then everything it touches
+// is needed too.
+void RenderGraph::cull() {
+	for (Resource& resource : resources) resource.needed = resource.output;
+
+	for (size_t i = passes.size(); i-- > 0;) {
+		Pass& pass = passes[i];
+		pass.kept = std::any_of(pass.uses.begin(), pass.uses.end(), [&](const Use& use) {
+			return isWrite(use.access) && resources[use.image].needed;
+		});
+		if (!pass.kept) continue;
+
+		for (const Use& use : pass.uses) resources[use.image].needed = true;
+	}
+}
+
+void RenderGraph::buildSteps() {
+	for (GraphPass p = 0; p < passes.size(); p++) {
+		Pass& pass = passes[p];
+		if (!pass.kept) continue;
+
+		std::vector<GraphImage> colors;
+		std::optional<GraphImage> depth;
+		if (pass.raster) {
+			for (const Use& use : pass.uses) {
+				if (use.access == GraphAccess::ColorWrite) colors.push_back(use.image);
+				if (use.access == GraphAccess::DepthWrite || use.access == GraphAccess::DepthRead) depth = use.image;
+			}
+		}
+
+		bool merge = pass.raster && !steps.empty() && steps.back().raster && steps.back().colors == colors && steps.back().depth == depth;
+		if (!merge) {
+			Step step;
+			step.raster = pass.raster;
+			step.colors = colors;
+			step.depth = depth;
+			steps.push_back(step);
+		}
+
+		int index = static_cast<int>(steps.size() - 1);
+		Step& step = steps.back();
+		step.passes.push_back(p);
+		pass.step = index;
+
+		for (const Use& use : pass.uses) {
+			Resource& resource = resources[use.image];
+			if (resource.first < 0) resource.first = index;
+			resource.last = index;
+			if (std::find(step.images.begin(), step.images.end(), use.image) == step.images.end()) step.images.push_back(use.image);
+
+			switch (use.access) {
+				case GraphAccess::ColorWrite: resource.usage |= vk::ImageUsageFlagBits::eColorAttachment; break;
+				case GraphAccess::DepthWrite:
+				case GraphAccess::DepthRead: resource.usage |= vk::ImageUsageFlagBits::eDepthStencilAttachment; break;
+				case GraphAccess::TransferRead: resource.usage |= vk::ImageUsageFlagBits::eTransferSrc; break;
+				case GraphAccess::TransferWrite: resource.usage |= vk::ImageUsageFlagBits::eTransferDst; break;
+			}
+		}
+
+		if (step.raster) {
+			GraphImage attachment = step.colors.empty() ? *step.depth : step.colors[0];
+			step.extent = resources[attachment].extent;
+		}
+	}
+}
+
+// Transient images go largest first into memory slots; an image joins a
+// slot when its lifetime, in steps, overlaps none of the slot's images
+// and the slot's memory is big enough and of a usable type.
+void RenderGraph::allocateImages() {
+	std::vector<GraphImage> transient;
+	std::vector<vk::MemoryRequirements> requirements(resources.size());
+
+	for (GraphImage i = 0; i < resources.size(); i++) {
+		Resource& resource = resources[i];
+		if (resource.imported || resource.first < 0) continue;
+
+		vk::ImageCreateInfo imageInfo;
+		imageInfo.imageType = vk::ImageType::e2D;
+		imageInfo.extent = vk::Extent3D(resource.extent.width, resource.extent.height, 1);
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = resource.format;
+		imageInfo.tiling = vk::ImageTiling::eOptimal;
+		imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+		imageInfo.usage = resource.usage;
+		imageInfo.samples = vk::SampleCountFlagBits::e1;
+		imageInfo.sharingMode = vk::SharingMode::eExclusive;
+
+		resource.images = {device.createImage(imageInfo)};
+		requirements[i] = device.getImageMemoryRequirements(resource.images[0]);
+		transient.push_back(i);
+	}
+
+	std::sort(transient.begin(), transient.end(), [&](GraphImage a, GraphImage b) {
+		return requirements[a].size > requirements[b].size;
+	});
+
+	for (GraphImage i : transient) {
+		Resource& resource = resources[i];
+		const vk::MemoryRequirements& required = requirements[i];
+
+		auto fits = [&](const Slot& slot) {
+			if (!(slot.memoryTypeBits & required.memoryTypeBits) || slot.size < required.size) return false;
+			return std::none_of(slot.images.begin(), slot.images.end(), [&](GraphImage other) {
+				return resources[other].first <= resource.last && resource.first <= resources[other].last;
+			});
+		};
+
+		auto slot = std::find_if(slots.begin(), slots.end(), fits);
+		if (slot == slots.end()) {
+			slots.push_back({required.memoryTypeBits, required.size, {}, nullptr});
+			slot = std::prev(slots.end());
+		}
+
+		slot->memoryTypeBits &= required.memoryTypeBits;
+		slot->images.push_back(i);
+		resource.slot = static_cast<int>(slot - slots.begin());
+	}
+
+	for (Slot& slot : slots) {
+		vk::MemoryAllocateInfo allocInfo;
+		allocInfo.allocationSize = slot.size;
+		allocInfo.memoryTypeIndex = findMemoryType(slot.memoryTypeBits);
+		slot.memory = device.allocateMemory(allocInfo);
+		memorySize += slot.size;
+
+		for (GraphImage i : slot.images) {
+			Resource& resource = resources[i];
+			device.bindImageMemory(resource.images[0], slot.memory, 0);
+
+			vk::ImageAspectFlags viewAspect = resource.aspect & ~vk::ImageAspectFlags(vk::ImageAspectFlagBits::eStencil);
+			vk::ImageViewCreateInfo viewInfo(vk::ImageViewCreateFlags(), resource.images[0], vk::ImageViewType::e2D, resource.format, vk::ComponentMapping(), vk::ImageSubresourceRange(viewAspect, 0, 1, 0, 1));
+			resource.views = {device.createImageView(viewInfo)};
+		}
+	}
+}
+
+RenderGraph::State RenderGraph::stateFor(const Step& step, GraphImage image) const {
+	State state;
+	bool depthWrite = false;
+
+	for (GraphPass p : step.passes) {
+		for (const Use& use : passes[p].uses) {
+			if (use.image != image) continue;
+
+			switch (use.access) {
+				case GraphAccess::ColorWrite:
+					state.layout = vk::ImageLayout::eColorAttachmentOptimal;
+					state.stages |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+					state.access |= vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+					break;
+				case GraphAccess::DepthWrite:
+					depthWrite = true;
+					[[fallthrough]];
+				case GraphAccess::DepthRead:
+					state.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+					state.stages |= vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+					state.access |= vk::AccessFlagBits::eDepthStencilAttachmentRead;
+					break;
+				case GraphAccess::TransferRead:
+					assert(state.layout == vk::ImageLayout::eUndefined || state.layout == vk::ImageLayout::eTransferSrcOptimal);
+					state.layout = vk::ImageLayout::eTransferSrcOptimal;
+					state.stages |= vk::PipelineStageFlagBits::eTransfer;
+					state.access |= vk::AccessFlagBits::eTransferRead;
+					break;
+				case GraphAccess::TransferWrite:
+					assert(state.layout == vk::ImageLayout::eUndefined || state.layout == vk::ImageLayout::eTransferDstOptimal);
+					state.layout = vk::ImageLayout::eTransferDstOptimal;
+					state.stages |= vk::PipelineStageFlagBits::eTransfer;
+					state.access |= vk::AccessFlagBits::eTransferWrite;
+					break;
+			}
+		}
+	}
+
+	if (depthWrite) state.access |= vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+	return state;
+}
+
+void RenderGraph::addBarrier(std::vector<Barrier>& barriers, GraphImage image, const State& from, const State& to) {
+	vk::ImageMemoryBarrier barrier;
+	barrier.srcAccessMask = from.access & WRITE_ACCESS;
+	barrier.dstAccessMask = to.access;
+	barrier.oldLayout = from.layout;
+	barrier.newLayout = to.layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.subresourceRange = vk::ImageSubresourceRange(resources[image].aspect, 0, 1, 0, 1);
+	barriers.push_back({image, barrier});
+}
+
+// Contents never carry over between frames, so each image starts the
+// frame undefined. A transient image still has to wait for the last use
+// of every image sharing its memory, from this frame or the previous
+// one; an imported image's first barrier starts at the stage of its
+// first use, which is where the acquire semaphore is waited on.
+void RenderGraph::planBarriers() {
+	for (const Step& step : steps) {
+		for (GraphImage image : step.images) resources[image].lastUse = stateFor(step, image);
+	}
+
+	std::vector<State> states(resources.size());
+	for (GraphImage i = 0; i < resources.size(); i++) {
+		const Resource& resource = resources[i];
+		if (resource.slot < 0) continue;
+
+		for (GraphImage other : slots[resource.slot].images) {
+			states[i].stages |= resources[other].lastUse.stages;
+			states[i].access |= resources[other].lastUse.access & WRITE_ACCESS;
+		}
+	}
+
+	for (Step& step : steps) {
+		for (GraphImage image : step.images) {
+			State to = stateFor(step, image);
+			State& from = states[image];
+
+			bool hazard = from.layout != to.layout || (from.access & WRITE_ACCESS) || (to.access & WRITE_ACCESS);
+			if (!hazard) {
+				from.stages |= to.stages;
+				from.access |= to.access;
+				continue;
+			}
+
+			addBarrier(step.barriers, image, from, to);
+			step.srcStages |= from.stages ? from.stages : to.stages;
+			step.dstStages |= to.stages;
+			from = to;
+		}
+	}
+
+	for (GraphImage i = 0; i < resources.size(); i++) {
+		const Resource& resource = resources[i];
+		if (!resource.imported || resource.first < 0) continue;
+
+		State to;
+		to.layout = resource.finalLayout;
+		to.stages = vk::PipelineStageFlagBits::eBottomOfPipe;
+		addBarrier(finalBarriers, i, states[i], to);
+		finalStages |= states[i].stages;
+	}
+}
+
+// Barriers already move every attachment into its layout, so render
+// passes keep layouts unchanged and only choose load and store ops: an
+// attachment is cleared if asked, loaded if an earlier step wrote it and
+// stored only if a later step or the output needs it.
+void RenderGraph::createRenderPasses() {
+	for (int s = 0; s < static_cast<int>(steps.size()); s++) {
+		Step& step = steps[s];
+		if (!step.raster) continue;
+
+		std::vector<GraphImage> attachments = step.colors;
+		if (step.depth) attachments.push_back(*step.depth);
+
+		std::vector<vk::AttachmentDescription> descriptions;
+		for (GraphImage image : attachments) {
+			const Resource& resource = resources[image];
+			State state = stateFor(step, image);
+
+			std::optional<vk::ClearValue> clear;
+			for (GraphPass p : step.passes) {
+				auto use = std::find_if(passes[p].uses.begin(), passes[p].uses.end(), [&](const Use& u) { return u.image == image; });
+				if (use != passes[p].uses.end()) {
+					clear = use->clear;
+					break;
+				}
+			}
+
+			vk::AttachmentDescription description;
+			description.format = resource.format;
+			description.samples = vk::SampleCountFlagBits::e1;
+			description.loadOp = clear ? vk::AttachmentLoadOp::eClear : (resource.first < s ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eDontCare);
+			description.storeOp = resource.last > s || resource.output ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+			description.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+			description.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+			description.initialLayout = state.layout;
+			description.finalLayout = state.layout;
+			descriptions.push_back(description);
+			step.clearValues.push_back(clear.value_or(vk::ClearValue()));
+		}
+
+		std::vector<vk::AttachmentReference> colorRefs;
+		for (uint32_t i = 0; i < step.colors.size(); i++) colorRefs.emplace_back(i, vk::ImageLayout::eColorAttachmentOptimal);
+		vk::AttachmentReference depthRef(static_cast<uint32_t>(step.colors.size()), vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+		vk::SubpassDescription subpass;
+		subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+		subpass.pColorAttachments = colorRefs.data();
+		subpass.pDepthStencilAttachment = step.depth ? &depthRef : nullptr;
+
+		vk::RenderPassCreateInfo renderPassInfo;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+		renderPassInfo.pAttachments = descriptions.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		step.renderPass = device.createRenderPass(renderPassInfo);
+
+		size_t variants = 1;
+		for (GraphImage image : attachments) variants = std::max(variants, resources[image].views.size());
+
+		for (size_t v = 0; v < variants; v++) {
+			std::vector<vk::ImageView> views;
+			for (GraphImage image : attachments) views.push_back(resources[image].views[v % resources[image].views.size()]);
+
+			vk::FramebufferCreateInfo framebufferInfo;
+			framebufferInfo.renderPass = step.renderPass;
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+			framebufferInfo.pAttachments = views.data();
+			framebufferInfo.width = step.extent.width;
+			framebufferInfo.height = step.extent.height;
+			framebufferInfo.layers = 1;
+			step.framebuffers.push_back(device.createFramebuffer(framebufferInfo));
+		}
+	}
+}
+
+void RenderGraph::recordBarriers(vk::CommandBuffer buffer, const std::vector<Barrier>& barriers, vk::PipelineStageFlags src, vk::PipelineStageFlags dst) {
+	if (barriers.empty()) return;
+
+	for (size_t i = 0; i < barriers.size(); i++) {
+		scratch[i] = barriers[i].barrier;
+		scratch[i].image = image(barriers[i].image);
+	}
+
+	buffer.pipelineBarrier(src, dst, vk::DependencyFlags(), {}, {}, vk::ArrayProxy<const vk::ImageMemoryBarrier>(static_cast<uint32_t>(barriers.size()), scratch.data()));
+}
+
+void RenderGraph::execute(vk::CommandBuffer buffer, uint32_t variant) {
+	this->variant = variant;
+
+	for (const Step& step : steps) {
+		recordBarriers(buffer, step.barriers, step.srcStages, step.dstStages);
+
+		if (!step.raster) {
+			for (GraphPass p : step.passes) passes[p].execute(buffer);
+			continue;
+		}
+
+		vk::Extent2D area = passes[step.passes[0]].area;
+		if (area.width == 0 || area.height == 0) area = step.extent;
+
+		vk::RenderPassBeginInfo renderPassInfo;
+		renderPassInfo.renderPass = step.renderPass;
+		renderPassInfo.framebuffer = step.framebuffers[variant % step.framebuffers.size()];
+		renderPassInfo.renderArea.offset = vk::Offset2D(0, 0);
+		renderPassInfo.renderArea.extent = area;
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(step.clearValues.size());
+		renderPassInfo.pClearValues = step.clearValues.data();
+
+		buffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+		for (GraphPass p : step.passes) passes[p].execute(buffer);
+		buffer.endRenderPass();
+	}
+
+	recordBarriers(buffer, finalBarriers, finalStages, vk::PipelineStageFlagBits::eBottomOfPipe);
+}
+
+void RenderGraph::reset() {
+	for (Step& step : steps) {
+		for (vk::Framebuffer framebuffer : step.framebuffers) device.destroyFramebuffer(framebuffer);
+		device.destroyRenderPass(step.renderPass);
+	}
+
+	for (Resource& resource : resources) {
+		if (resource.imported) continue;
+		for (vk::ImageView view : resource.views) device.destroyImageView(view);
+		for (vk::Image image : resource.images) device.destroyImage(image);
+	}
+
+	for (Slot& slot : slots) device.freeMemory(slot.memory);
+
+	resources.clear();
+	passes.clear();
+	steps.clear();
+	slots.clear();
+	finalBarriers.clear();
+	finalStages = vk::PipelineStageFlags();
+	memorySize = 0;
+}
+
+vk::Image RenderGraph::image(GraphImage image) const {
+	const std::vector<vk::Image>& images = resources[image].images;
+	return images[variant % images.size()];
+}
+
+vk::RenderPass RenderGraph::renderPass(GraphPass pass) const {
+	return steps[passes[pass].step].renderPass;
+}
+
+uint32_t RenderGraph::findMemoryType(uint32_t typeFilter) const {
+	vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
+
+	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+		if (typeFilter & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal)) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error("failed to find suitable memory type!");
+}
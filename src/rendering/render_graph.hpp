@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+using GraphImage = uint32_t;
+using GraphPass = uint32_t;
+
+enum class GraphAccess {
+	ColorWrite,
+	DepthWrite,
+	DepthRead,
+	TransferRead,
+	TransferWrite
+};
+
+// Describes one frame as passes that declare which images they use and
+// how. compile() turns the declarations into Vulkan objects once:
+//  - passes that contribute nothing to an output are dropped,
+//  - consecutive raster passes on the same attachments share one render
+//    pass instance,
+//  - load and store ops follow from whether earlier passes wrote an
+//    image and later ones read it,
+//  - transient images whose lifetimes do not overlap share memory,
+//  - the layout transitions and barriers between passes are worked out
+//    and batched, one pipelineBarrier per step at most.
+// execute() then only replays that plan, so recording a frame does not
+// allocate. Declarations are rebuilt with reset() whenever the swapchain
+// or the set of passes changes.
+class RenderGraph {
+public:
+	void init(vk::Device device, vk::PhysicalDevice physicalDevice);
+
+	// Images owned elsewhere, such as the swapchain's. images[i] and
+	// views[i] are picked by execute()'s variant. Contents are not kept
+	// between frames; the image ends each frame in finalLayout.
+	GraphImage importImage(const std::string& name, vk::Format format, vk::Extent2D extent, const std::vector<vk::Image>& images, const std::vector<vk::ImageView>& views, vk::ImageLayout finalLayout);
+	// Images that only live within a frame, created by compile().
+	GraphImage createImage(const std::string& name, vk::Format format, vk::Extent2D extent);
+	void markOutput(GraphImage image);
+
+	GraphPass addPass(const std::string& name, bool raster, std::function<void(vk::CommandBuffer)> execute);
+	void writeColor(GraphPass pass, GraphImage image, std::optional<vk::ClearColorValue> clear = std::nullopt);
+	void writeDepth(GraphPass pass, GraphImage image, std::optional<float> clear = std::nullopt);
+	void readDepth(GraphPass pass, GraphImage image);
+	void readTransfer(GraphPass pass, GraphImage image);
+	void writeTransfer(GraphPass pass, GraphImage image);
+	// Part of the attachments a raster pass draws to, from the top-left
+	// corner; the whole image when unset.
+	void setRenderArea(GraphPass pass, vk::Extent2D area);
+
+	void compile();
+	void execute(vk::CommandBuffer buffer, uint32_t variant);
+	void reset();
+
+	// The image for the variant being executed, for use inside passes.
+	vk::Image image(GraphImage image) const;
+	// Render pass a raster pass was compiled into, for creating pipelines.
+	vk::RenderPass renderPass(GraphPass pass) const;
+	vk::DeviceSize transientMemory() const { return memorySize; }
+private:
+	struct Use {
+		GraphImage image;
+		GraphAccess access;
+		std::optional<vk::ClearValue> clear;
+	};
+
+	struct Pass {
+		std::string name;
+		bool raster;
+		std::function<void(vk::CommandBuffer)> execute;
+		std::vector<Use> uses;
+		vk::Extent2D area;
+		bool kept = false;
+		int step = -1;
+	};
+
+	struct State {
+		vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+		vk::PipelineStageFlags stages;
+		vk::AccessFlags access;
+	};
+
+	struct Resource {
+		std::string name;
+		vk::Format format;
+		vk::Extent2D extent;
+		vk::ImageAspectFlags aspect;
+		bool imported;
+		bool output = false;
+		vk::ImageLayout finalLayout;
+		std::vector<vk::Image> images;
+		std::vector<vk::ImageView> views;
+
+		bool needed = false;
+		vk::ImageUsageFlags usage;
+		int first = -1;
+		int last = -1;
+		int slot = -1;
+		State lastUse;
+	};
+
+	struct Barrier {
+		GraphImage image;
+		vk::ImageMemoryBarrier barrier;
+	};
+
+	// Kept passes executed together: one render pass instance for raster
+	// steps, plain commands otherwise.
+	struct Step {
+		std::vector<GraphPass> passes;
+		bool raster;
+		std::vector<GraphImage> colors;
+		std::optional<GraphImage> depth;
+		std::vector<GraphImage> images;
+		vk::Extent2D extent;
+		vk::RenderPass renderPass;
+		std::vector<vk::Framebuffer> framebuffers;
+		std::vector<vk::ClearValue> clearValues;
+		std::vector<Barrier> barriers;
+		vk::PipelineStageFlags srcStages;
+		vk::PipelineStageFlags dstStages;
+	};
+
+	struct Slot {
+		uint32_t memoryTypeBits;
+		vk::DeviceSize size;
+		std::vector<GraphImage> images;
+		vk::DeviceMemory memory;
+	};
+
+	vk::Device device;
+	vk::PhysicalDevice physicalDevice;
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	std::vector<Step> steps;
+	std::vector<Slot> slots;
+	std::vector<Barrier> finalBarriers;
+	vk::PipelineStageFlags finalStages;
+	std::vector<vk::ImageMemoryBarrier> scratch;
+	vk::DeviceSize memorySize = 0;
+	uint32_t variant = 0;
+
+	void use(GraphPass pass, GraphImage image, GraphAccess access, std::optional<vk::ClearValue> clear);
+	void cull();
+	void buildSteps();
+	void allocateImages();
+	void planBarriers();
+	void createRenderPasses();
+	State stateFor(const Step& step, GraphImage image) const;
+	void addBarrier(std::vector<Barrier>& barriers, GraphImage image, const State& from, const State& to);
+	void recordBarriers(vk::CommandBuffer buffer, const std::vector<Barrier>& barriers, vk::PipelineStageFlags src, vk::PipelineStageFlags dst);
+	uint32_t findMemoryType(uint32_t typeFilter) const;
+};
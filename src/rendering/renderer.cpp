@@ -2,12 +2,16 @@
 #include <rendering/window.hpp>
 #include <rendering/mesh.hpp>
 #include <rendering/camera.hpp>
+#include <rendering/translucency.hpp>
 #include <assets/assets.hpp>
 #include <assets/shaders.hpp>
+#include <core/allocations.hpp>
 #include <iostream>
 #include <set>
 #include <limits>
 #include <algorithm>
+#include <cassert>
+#include <cmath>
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
@@ -15,21 +19,37 @@
 
 #include <chrono>
 
-Renderer::Renderer(Window& window) {
+static uint32_t roundUp(uint32_t value, uint32_t granule) {
+	return (value + granule - 1) / granule * granule;
+}
+
+static glm::vec3 sectionOrigin(SectionPos pos) {
+	return glm::vec3(pos.x, pos.y, pos.z) * static_cast<float>(SECTION_SIZE);
+}
+
+static float distanceSquared(SectionPos pos, glm::vec3 eye) {
+	glm::vec3 d = glm::vec3(pos.x + 0.5f, pos.y + 0.5f, pos.z + 0.5f) * static_cast<float>(SECTION_SIZE) - eye;
+	return d.x * d.x + d.y * d.y + d.z * d.z;
+}
+
+Renderer::Renderer(Window& window, JobSystem& jobs) : jobs(jobs) {
 	createInstance();
 	surface = window.createSurface(instance);
 	pickPhysicalDevice();
 	createDevice();
 	createSwapChain(window);
 	createImageViews();
-	createRenderPass();
+	depthFormat = findDepthFormat();
+	graph.init(device, physicalDevice);
+	buildRenderGraph();
 	createDescriptorSetLayout();
 	createGraphicsPipeline();
-	createFramebuffers();
 	createCommandPool();
-	createVertexBuffer();
-	createIndexBuffer();
-	createUniformBuffers();
+	timeline.create(device);
+	createStagingRing(STAGING_RING_SIZE);
+	createTimestampQueries();
+	createMeshBuffers();
+	createFrameRings();
 	createDescriptorPool();
 	createDescriptorSets();
 	createCommandBuffers();
@@ -37,33 +57,43 @@ Renderer::Renderer(Window& window) {
 }
 
 Renderer::~Renderer() {
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		device.destroyBuffer(uniformBuffers[i]);
-		device.freeMemory(uniformBuffersMemory[i]);
-    }
+	device.waitIdle();
+	collectRetired();
+	destroyBuffer(staging.buffer, staging.memory);
+	timeline.destroy();
+
+	for (FrameRing& ring : frameRings) destroyFrameRing(ring);
+	for (InstanceRing& ring : instanceRings) destroyInstanceRing(ring);
 
 	device.destroyDescriptorPool(descriptorPool);
 	device.destroyDescriptorSetLayout(descriptorSetLayout);
-	device.destroyBuffer(indexBuffer);
-	device.freeMemory(indexBufferMemory);
-	device.destroyBuffer(vertexBuffer);
-	device.freeMemory(vertexBufferMemory);
+
+	destroyArena(meshArena);
+	destroyArena(translucentIndices);
+	destroyBuffer(quadIndexBuffer, quadIndexMemory);
+	destroyBuffer(entityModelBuffer, entityModelMemory);
+
+	checkValidations();
+	if (gpuMesher.ready()) {
+		gpuMesher.destroy();
+		destroyArena(drawCommands);
+		destroyBuffer(blockTableBuffer, blockTableMemory);
+	}
 
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		device.destroySemaphore(renderFinishedSemaphores[i]);
 		device.destroySemaphore(imageAvailableSemaphores[i]);
-		device.destroyFence(inFlightFences[i]);
 	}
 
 	device.destroyCommandPool(commandPool);
+	device.destroyQueryPool(timestampPool);
 
-	for (auto framebuffer : swapChainFramebuffers) {
-		device.destroyFramebuffer(framebuffer);
-    }
+	graph.reset();
 
 	device.destroyPipeline(graphicsPipeline);
+	device.destroyPipeline(translucentPipeline);
+	device.destroyPipeline(entityPipeline);
 	device.destroyPipelineLayout(pipelineLayout);
-	device.destroyRenderPass(renderPass);
 
 	for (auto view : swapChainImageViews) {
 		device.destroyImageView(view);
@@ -109,7 +139,9 @@ void Renderer::createInstance() {
 	}
 
 	try {
-		vk::InstanceCreateInfo instanceCreateInfo({}, nullptr, validationLayers, extensions);
+		// Timeline semaphores are core from 1.2.
+		vk::ApplicationInfo appInfo(nullptr, 0, nullptr, 0, VK_API_VERSION_1_2);
+		vk::InstanceCreateInfo instanceCreateInfo({}, &appInfo, validationLayers, extensions);
 		instance = vk::createInstance(instanceCreateInfo);
 	} catch (vk::SystemError & err) {
 		std::cout << "vk::SystemError: " << err.what() << std::endl;
@@ -136,10 +168,16 @@ void Renderer::pickPhysicalDevice() {
 			requiredExtensions.erase(ext.extensionName);
 		}
 
-		if (requiredExtensions.empty()) {
+		auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceTimelineSemaphoreFeatures>();
+		bool timelineSupported = props.apiVersion >= VK_API_VERSION_1_2 && features.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().timelineSemaphore;
+
+		if (requiredExtensions.empty() && timelineSupported) {
 			if (findQueueFamilies(device).isComplete() && querySwapChainSupport(device).isAdequate()) {
 				std::cout << "Using " << props.deviceName << std::endl;
 				physicalDevice = device;
+				memoryBudgetSupported = std::any_of(availableExtensions.begin(), availableExtensions.end(), [](const vk::ExtensionProperties& ext) {
+					return std::string(ext.extensionName.data()) == MemoryBudget::extensionName();
+				});
 				found = true;
 				break;
 			}
@@ -186,7 +224,17 @@ void Renderer::createDevice() {
 		createInfos.push_back(createInfo);
 	}
 
-	device = physicalDevice.createDevice(vk::DeviceCreateInfo(vk::DeviceCreateFlags(), createInfos, {}, deviceExtensions));
+	// The memory budget extension is optional; without it budgets are
+	// estimated from the heap sizes.
+	std::vector<const char *> enabledExtensions = deviceExtensions;
+	if (memoryBudgetSupported) enabledExtensions.push_back(MemoryBudget::extensionName());
+
+	vk::PhysicalDeviceTimelineSemaphoreFeatures timelineFeatures(VK_TRUE);
+	vk::DeviceCreateInfo createInfo(vk::DeviceCreateFlags(), createInfos, {}, enabledExtensions);
+	createInfo.pNext = &timelineFeatures;
+
+	device = physicalDevice.createDevice(createInfo);
+	budget.init(physicalDevice, memoryBudgetSupported);
 
 	graphicsQueue = device.getQueue(indices.graphicsFamily.value(), 0);
 	presentQueue = device.getQueue(indices.presentFamily.value(), 0);
@@ -253,7 +301,17 @@ void Renderer::createSwapChain(Window& window) {
 	QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 	uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
-	vk::SwapchainCreateInfoKHR createInfo(vk::SwapchainCreateFlagsKHR(), surface, imageCount, surfaceFormat.format, surfaceFormat.colorSpace, extent, 1, vk::ImageUsageFlagBits::eColorAttachment);
+	// The scene can only be scaled when it can be blitted into the
+	// swapchain images.
+	vk::FormatFeatureFlags features = physicalDevice.getFormatProperties(swapChainImageFormat).optimalTilingFeatures;
+	blitSupported = (swapChainSupport.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst) &&
+		(features & vk::FormatFeatureFlagBits::eBlitSrc) && (features & vk::FormatFeatureFlagBits::eBlitDst);
+
+	vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eColorAttachment;
+	if (blitSupported) usage |= vk::ImageUsageFlagBits::eTransferDst;
+	if (!blitSupported) dynamicResolution = false;
+
+	vk::SwapchainCreateInfoKHR createInfo(vk::SwapchainCreateFlagsKHR(), surface, imageCount, surfaceFormat.format, surfaceFormat.colorSpace, extent, 1, usage);
 
 	if (indices.graphicsFamily != indices.presentFamily) {
 		createInfo.imageSharingMode = vk::SharingMode::eConcurrent;
@@ -310,6 +368,7 @@ void Renderer::createImageViews() {
 void Renderer::createGraphicsPipeline() {
 	vk::ShaderModule vertex = createShaderModule(Identifier("core", "vertex"), ShaderType::Vertex, device);
 	vk::ShaderModule fragment = createShaderModule(Identifier("core", "fragment"), ShaderType::Fragment, device);
+	vk::ShaderModule entityVertex = createShaderModule(Identifier("core", "entity"), ShaderType::Vertex, device);
 
 	vk::PipelineShaderStageCreateInfo vertShaderStageInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eVertex, vertex, "main");
 	vk::PipelineShaderStageCreateInfo fragShaderStageInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eFragment, fragment, "main");
@@ -360,6 +419,13 @@ void Renderer::createGraphicsPipeline() {
 	multisampling.alphaToCoverageEnable = false;
 	multisampling.alphaToOneEnable = false;
 
+	vk::PipelineDepthStencilStateCreateInfo depthStencil;
+	depthStencil.depthTestEnable = true;
+	depthStencil.depthWriteEnable = true;
+	depthStencil.depthCompareOp = vk::CompareOp::eLess;
+	depthStencil.depthBoundsTestEnable = false;
+	depthStencil.stencilTestEnable = false;
+
 	vk::PipelineColorBlendAttachmentState colorBlendAttachment;
 	colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
 	colorBlendAttachment.blendEnable = false;
@@ -382,8 +448,12 @@ void Renderer::createGraphicsPipeline() {
 
 	vk::PipelineLayoutCreateInfo pipelineLayoutInfo(vk::PipelineLayoutCreateFlags(), {}, {});
 
+	vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t));
+
 	pipelineLayoutInfo.setLayoutCount = 1;
 	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
 	try {
 		pipelineLayout = device.createPipelineLayout(pipelineLayoutInfo);
@@ -406,12 +476,14 @@ void Renderer::createGraphicsPipeline() {
 	pipelineInfo.pViewportState = &viewportState;
 	pipelineInfo.pRasterizationState = &rasterizer;
 	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pDepthStencilState = nullptr;
+	pipelineInfo.pDepthStencilState = &depthStencil;
 	pipelineInfo.pColorBlendState = &colorBlending;
 	pipelineInfo.pDynamicState = &dynamicState;
 
 	pipelineInfo.layout = pipelineLayout;
-	pipelineInfo.renderPass = renderPass;
+	// Render passes the graph builds later for the same formats stay
+	// compatible with this one, so rebuilding it keeps the pipelines.
+	pipelineInfo.renderPass = graph.renderPass(opaquePass);
 	pipelineInfo.subpass = 0;
 
 	pipelineInfo.basePipelineHandle = nullptr;
@@ -431,45 +503,31 @@ void Renderer::createGraphicsPipeline() {
 		exit(-1);
 	}
 
-	device.destroyShaderModule(vertex);
-	device.destroyShaderModule(fragment);
-}
-
-void Renderer::createRenderPass() {
-	vk::AttachmentDescription colorAttachment;
-	colorAttachment.format = swapChainImageFormat;
-    colorAttachment.samples = vk::SampleCountFlagBits::e1;
-	colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
-	colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
-	colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
-	colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-	colorAttachment.initialLayout = vk::ImageLayout::eUndefined;
-	colorAttachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
-
-	vk::AttachmentReference colorAttachmentRef;
-	colorAttachmentRef.attachment = 0;
-	colorAttachmentRef.layout = vk::ImageLayout::eColorAttachmentOptimal;
-
-	vk::SubpassDescription subpass;
-	subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
-	subpass.colorAttachmentCount = 1;
-	subpass.pColorAttachments = &colorAttachmentRef;
-
-	vk::RenderPassCreateInfo renderPassInfo(vk::RenderPassCreateFlags(), {colorAttachment}, {subpass});
-
-	vk::SubpassDependency dependency;
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;
-	dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-	dependency.srcAccessMask = vk::AccessFlags();
-	dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-	dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+	// Entities are opaque too, but read their model per vertex and their
+	// placement per instance.
+	std::array<vk::VertexInputBindingDescription, 2> entityBindings = {Vertex::getBindingDescription(), InstanceData::getBindingDescription()};
+	auto instanceAttributes = InstanceData::getAttributeDescriptions();
+	std::vector<vk::VertexInputAttributeDescription> entityAttributes(attributeDescriptions.begin(), attributeDescriptions.end());
+	entityAttributes.insert(entityAttributes.end(), instanceAttributes.begin(), instanceAttributes.end());
+
+	vk::PipelineVertexInputStateCreateInfo entityVertexInput;
+	entityVertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(entityBindings.size());
+	entityVertexInput.pVertexBindingDescriptions = entityBindings.data();
+	entityVertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(entityAttributes.size());
+	entityVertexInput.pVertexAttributeDescriptions = entityAttributes.data();
+
+	vk::PipelineShaderStageCreateInfo entityStages[] = {
+		vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eVertex, entityVertex, "main"),
+		fragShaderStageInfo
+	};
 
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
+	vk::GraphicsPipelineCreateInfo entityInfo = pipelineInfo;
+	entityInfo.pStages = entityStages;
+	entityInfo.pVertexInputState = &entityVertexInput;
 
 	try {
-		renderPass = device.createRenderPass(renderPassInfo);
+		vk::Result result;
+		std::tie(result, entityPipeline) = device.createGraphicsPipeline(nullptr, entityInfo);
 	} catch (vk::SystemError & err) {
 		std::cout << "vk::SystemError: " << err.what() << std::endl;
 		exit(-1);
@@ -480,38 +538,34 @@ void Renderer::createRenderPass() {
 		std::cout << "unknown error" << std::endl;
 		exit(-1);
 	}
-}
-
-void Renderer::createFramebuffers() {
-	swapChainFramebuffers.resize(swapChainImageViews.size());
-
-	for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-		vk::ImageView attachments[] = {
-			swapChainImageViews[i]
-		};
 
-		vk::FramebufferCreateInfo framebufferInfo;
-		framebufferInfo.renderPass = renderPass;
-		framebufferInfo.attachmentCount = 1;
-		framebufferInfo.pAttachments = attachments;
-		framebufferInfo.width = swapChainExtent.width;
-		framebufferInfo.height = swapChainExtent.height;
-		framebufferInfo.layers = 1;
-
-		try {
-			swapChainFramebuffers[i] = device.createFramebuffer(framebufferInfo);
-		} catch (vk::SystemError & err) {
-			std::cout << "vk::SystemError: " << err.what() << std::endl;
-			exit(-1);
-		} catch (std::exception & err) {
-			std::cout << "std::exception: " << err.what() << std::endl;
-			exit(-1);
-		} catch (...) {
-			std::cout << "unknown error" << std::endl;
-			exit(-1);
-		}
+	// Translucent faces blend over what is behind them, so they test
+	// against depth without writing it and are seen from both sides.
+	rasterizer.cullMode = vk::CullModeFlagBits::eNone;
+	depthStencil.depthWriteEnable = false;
+	colorBlendAttachment.blendEnable = true;
+	colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+	colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+	colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+	colorBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
 
+	try {
+		vk::Result result;
+		std::tie(result, translucentPipeline) = device.createGraphicsPipeline(nullptr, pipelineInfo);
+	} catch (vk::SystemError & err) {
+		std::cout << "vk::SystemError: " << err.what() << std::endl;
+		exit(-1);
+	} catch (std::exception & err) {
+		std::cout << "std::exception: " << err.what() << std::endl;
+		exit(-1);
+	} catch (...) {
+		std::cout << "unknown error" << std::endl;
+		exit(-1);
 	}
+
+	device.destroyShaderModule(vertex);
+	device.destroyShaderModule(fragment);
+	device.destroyShaderModule(entityVertex);
 }
 
 void Renderer::createCommandPool() {
@@ -578,40 +632,35 @@ void Renderer::recordCommandBuffer(vk::CommandBuffer buffer, uint32_t imageIndex
 	}
 
 
-	vk::ClearValue clearColor(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
-	vk::RenderPassBeginInfo renderPassInfo;
-	renderPassInfo.renderPass = renderPass;
-	renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
-	renderPassInfo.renderArea.offset = vk::Offset2D(0, 0);
-	renderPassInfo.renderArea.extent = swapChainExtent;
-	renderPassInfo.clearValueCount = 1;
-	renderPassInfo.pClearValues = &clearColor;
-
-	buffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
-	buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipeline);
+	uint32_t query = currentFrame * 2;
+	if (timestampPool) {
+		buffer.resetQueryPool(timestampPool, query, 2);
+		buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, timestampPool, query);
+	}
 
-	vk::Viewport viewport;
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(swapChainExtent.width);
-	viewport.height = static_cast<float>(swapChainExtent.height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-	buffer.setViewport(0, 1, &viewport);
-	
-	vk::Rect2D scissor;
-	scissor.offset = vk::Offset2D(0, 0);
-	scissor.extent = swapChainExtent;
-	buffer.setScissor(0, 1, &scissor);
+	// Every visible section gets one entry in the frame ring, shared by
+	// its opaque and translucent draws; the draws select it by index.
+	DrawData *drawData = reinterpret_cast<DrawData *>(frameRings[currentFrame].mapped + drawDataOffset);
+	for (uint32_t i = 0; i < visibleSections.size(); i++) {
+		drawData[i].origin = glm::vec4(sectionOrigin(visibleSections[i]), 0.0f);
+	}
 
-	vk::Buffer vertexBuffers[] = {vertexBuffer};
-	vk::DeviceSize offsets[] = {0};
+	if (entities && !entities->instances.empty()) {
+		memcpy(instanceRings[currentFrame].mapped, entities->instances.data(), sizeof(InstanceData) * entities->instances.size());
+	}
 
-	buffer.bindVertexBuffers(0, 1, vertexBuffers, offsets);
-	buffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint16);
-	buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, {descriptorSets[currentFrame]}, {});
-	buffer.drawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-	buffer.endRenderPass();
+	// Scaled frames draw into the top-left corner of the full-size scene
+	// target, so changing the scale never reallocates anything.
+	vk::Extent2D extent = renderExtent();
+	graph.setRenderArea(opaquePass, extent);
+	graph.setRenderArea(entityPass, extent);
+	graph.setRenderArea(translucentPass, extent);
+	graph.execute(buffer, imageIndex);
+
+	if (timestampPool) {
+		buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, timestampPool, query + 1);
+		timestampsWritten[currentFrame] = true;
+	}
 
 	try {
 		buffer.end();
@@ -627,20 +676,169 @@ void Renderer::recordCommandBuffer(vk::CommandBuffer buffer, uint32_t imageIndex
 	}
 }
 
+void Renderer::buildRenderGraph() {
+	graph.reset();
+
+	swapChainTarget = graph.importImage("swapchain", swapChainImageFormat, swapChainExtent, swapChainImages, swapChainImageViews, vk::ImageLayout::ePresentSrcKHR);
+	graph.markOutput(swapChainTarget);
+
+	GraphImage depth = graph.createImage("depth", depthFormat, swapChainExtent);
+	sceneTarget = dynamicResolution ? graph.createImage("scene", swapChainImageFormat, swapChainExtent) : swapChainTarget;
+
+	opaquePass = graph.addPass("opaque", true, [this](vk::CommandBuffer buffer) { drawOpaque(buffer); });
+	graph.writeColor(opaquePass, sceneTarget, vk::ClearColorValue(std::array<float, 4>{0.55f, 0.7f, 0.9f, 1.0f}));
+	graph.writeDepth(opaquePass, depth, 1.0f);
+
+	// Neither clears, so all three share the opaque pass's render pass.
+	entityPass = graph.addPass("entities", true, [this](vk::CommandBuffer buffer) { drawEntities(buffer); });
+	graph.writeColor(entityPass, sceneTarget);
+	graph.writeDepth(entityPass, depth);
+
+	translucentPass = graph.addPass("translucent", true, [this](vk::CommandBuffer buffer) { drawTranslucent(buffer); });
+	graph.writeColor(translucentPass, sceneTarget);
+	graph.readDepth(translucentPass, depth);
+
+	if (dynamicResolution) {
+		GraphPass upscale = graph.addPass("upscale", false, [this](vk::CommandBuffer buffer) { blitScene(buffer); });
+		graph.readTransfer(upscale, sceneTarget);
+		graph.writeTransfer(upscale, swapChainTarget);
+	}
+
+	try {
+		graph.compile();
+	} catch (vk::SystemError & err) {
+		std::cout << "vk::SystemError: " << err.what() << std::endl;
+		exit(-1);
+	} catch (std::exception & err) {
+		std::cout << "std::exception: " << err.what() << std::endl;
+		exit(-1);
+	} catch (...) {
+		std::cout << "unknown error" << std::endl;
+		exit(-1);
+	}
+
+	budget.setExternal(MemoryCategory::RenderTargets, graph.transientMemory());
+}
+
+void Renderer::bindSceneState(vk::CommandBuffer buffer) {
+	vk::Extent2D extent = renderExtent();
+
+	vk::Viewport viewport;
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(extent.width);
+	viewport.height = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	buffer.setViewport(0, 1, &viewport);
+	
+	vk::Rect2D scissor;
+	scissor.offset = vk::Offset2D(0, 0);
+	scissor.extent = extent;
+	buffer.setScissor(0, 1, &scissor);
+
+	buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, {descriptorSets[currentFrame]}, {});
+
+	vk::DeviceSize offset = 0;
+	buffer.bindVertexBuffers(0, 1, &meshArena.buffer, &offset);
+}
+
+void Renderer::drawOpaque(vk::CommandBuffer buffer) {
+	buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipeline);
+	bindSceneState(buffer);
+	buffer.bindIndexBuffer(quadIndexBuffer, 0, vk::IndexType::eUint16);
+
+	for (uint32_t i = 0; i < visibleSections.size(); i++) {
+		auto it = sectionDraws.find(visibleSections[i]);
+		if (it == sectionDraws.end()) continue;
+
+		const SectionDraw& section = it->second;
+		buffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t), &i);
+		if (section.gpu) {
+			buffer.drawIndexedIndirect(drawCommands.buffer, drawCommands.slotSize * section.command, 1, sizeof(vk::DrawIndexedIndirectCommand));
+		} else {
+			buffer.drawIndexed(section.quadCount * 6, 1, 0, static_cast<int32_t>(section.offset), 0);
+		}
+	}
+}
+
+// One instanced draw per model; the instances of a model are contiguous
+// in the ring.
+void Renderer::drawEntities(vk::CommandBuffer buffer) {
+	if (!entities || entities->instances.empty()) return;
+
+	buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, entityPipeline);
+	bindSceneState(buffer);
+
+	std::array<vk::Buffer, 2> vertexBuffers = {entityModelBuffer, instanceRings[currentFrame].buffer};
+	std::array<vk::DeviceSize, 2> offsets = {0, 0};
+	buffer.bindVertexBuffers(0, 2, vertexBuffers.data(), offsets.data());
+	buffer.bindIndexBuffer(quadIndexBuffer, 0, vk::IndexType::eUint16);
+	buffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(float), &entityTime);
+
+	for (uint32_t model = 0; model < ENTITY_MODEL_COUNT; model++) {
+		if (entities->counts[model] == 0) continue;
+		buffer.drawIndexed(ENTITY_MODEL_VERTICES / 4 * 6, entities->counts[model], 0, static_cast<int32_t>(model * ENTITY_MODEL_VERTICES), entities->offsets[model]);
+	}
+}
+
+void Renderer::drawTranslucent(vk::CommandBuffer buffer) {
+	// Translucent sections go last, farthest first; their faces are
+	// already ordered within each section.
+	struct TranslucentItem {
+		float distance;
+		const TranslucentDraw *draw;
+		uint32_t drawIndex;
+	};
+
+	FrameVector<TranslucentItem> translucent{FrameAllocator<TranslucentItem>(frameArenas[currentFrame])};
+	translucent.reserve(translucentDraws.size());
+	for (uint32_t i = 0; i < visibleSections.size(); i++) {
+		auto it = translucentDraws.find(visibleSections[i]);
+		if (it != translucentDraws.end()) translucent.push_back({distanceSquared(visibleSections[i], camera.position), &it->second, i});
+	}
+
+	if (translucent.empty()) return;
+
+	std::sort(translucent.begin(), translucent.end(), [](const TranslucentItem& a, const TranslucentItem& b) {
+		return a.distance > b.distance;
+	});
+
+	// The passes share a render pass, but a later one may start a new
+	// instance, so the state is set again.
+	buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, translucentPipeline);
+	bindSceneState(buffer);
+	buffer.bindIndexBuffer(translucentIndices.buffer, 0, vk::IndexType::eUint16);
+
+	for (const auto& [distance, draw, drawIndex] : translucent) {
+		buffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t), &drawIndex);
+		buffer.drawIndexed(static_cast<uint32_t>(draw->centers.size() * 6), 1, draw->indexOffset, static_cast<int32_t>(draw->vertexOffset), 0);
+	}
+}
+
+// The graph has already moved the scene to transfer source and the
+// swapchain image to transfer destination.
+void Renderer::blitScene(vk::CommandBuffer buffer) {
+	vk::Extent2D extent = renderExtent();
+
+	vk::ImageBlit blit;
+	blit.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+	blit.srcOffsets[1] = vk::Offset3D(static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1);
+	blit.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+	blit.dstOffsets[1] = vk::Offset3D(static_cast<int32_t>(swapChainExtent.width), static_cast<int32_t>(swapChainExtent.height), 1);
+	buffer.blitImage(graph.image(sceneTarget), vk::ImageLayout::eTransferSrcOptimal, graph.image(swapChainTarget), vk::ImageLayout::eTransferDstOptimal, {blit}, vk::Filter::eLinear);
+}
+
 void Renderer::createSyncObjects() {
 	imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
 
 	vk::SemaphoreCreateInfo semaphoreInfo;
-	vk::FenceCreateInfo fenceInfo;
-	fenceInfo.flags = vk::FenceCreateFlagBits::eSignaled;
 
 	try {
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 			imageAvailableSemaphores[i] = device.createSemaphore(semaphoreInfo);
 			renderFinishedSemaphores[i] = device.createSemaphore(semaphoreInfo);
-			inFlightFences[i] = device.createFence(fenceInfo);
 		}
 	} catch (vk::SystemError & err) {
 		std::cout << "vk::SystemError: " << err.what() << std::endl;
@@ -654,8 +852,14 @@ void Renderer::createSyncObjects() {
 	}
 }
 
+// Debug builds check that a warmed-up frame makes no heap allocations on
+// this thread; per-frame temporaries belong in frameArenas instead.
 void Renderer::tick(Window& window) {
-	device.waitForFences(inFlightFences[currentFrame], true, UINT64_MAX);
+	uint64_t allocations = threadAllocations();
+	budget.refresh();
+	timeline.wait(frameValues[currentFrame]);
+	frameArenas[currentFrame].reset();
+	readFrameTime();
 	uint32_t imageIndex;
 
 	vk::ResultValue<uint32_t> result = device.acquireNextImageKHR(swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame]);
@@ -672,27 +876,24 @@ void Renderer::tick(Window& window) {
 			throw std::runtime_error("failed to acquire swap chain image!");
 	}
 
-	device.resetFences(inFlightFences[currentFrame]);
+	cullSections();
+
+	reserveFrameRing(currentFrame, static_cast<uint32_t>(visibleSections.size()));
+	if (entities) reserveInstanceRing(currentFrame, static_cast<uint32_t>(entities->instances.size()));
+	updateUniformBuffer(currentFrame);
 
 	commandBuffers[currentFrame].reset(vk::CommandBufferResetFlags());
 	recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
 
-	updateUniformBuffer(currentFrame);
-
-	vk::Semaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
 	vk::Semaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-	vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
-	vk::SubmitInfo submitInfo;
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
+	TimelineSubmit submit;
+	submit.commandBuffer = commandBuffers[currentFrame];
+	submit.waitBinary = imageAvailableSemaphores[currentFrame];
+	submit.binaryStage = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eTransfer;
+	submit.signalBinary = renderFinishedSemaphores[currentFrame];
 
 	try {
-		graphicsQueue.submit({submitInfo}, inFlightFences[currentFrame]);
+		frameValues[currentFrame] = timeline.submit(graphicsQueue, submit);
 	} catch (vk::SystemError & err) {
 		std::cout << "vk::SystemError: " << err.what() << std::endl;
 		exit(-1);
@@ -713,29 +914,33 @@ void Renderer::tick(Window& window) {
 	presentInfo.pImageIndices = &imageIndex;
 	presentInfo.pResults = nullptr;
 
+	bool outdated = false;
 	switch(presentQueue.presentKHR(presentInfo)) {
 		case vk::Result::eSuccess:
 			break;
 		case vk::Result::eSuboptimalKHR:
 		case vk::Result::eErrorOutOfDateKHR:
-			recreateSwapChain(window);
+			outdated = true;
 			break;
 		default:
 			throw std::runtime_error("failed to present swap chain image2!");
 	}
 
-	if (window.framebufferResized) {
+	// Recreating the swapchain allocates, so those frames are not checked.
+	if (outdated || window.framebufferResized) {
 		recreateSwapChain(window);
 		window.framebufferResized = false;
+	} else if (frameCount >= ALLOCATION_WARMUP_FRAMES) {
+		assert(threadAllocations() == allocations && "tick allocated after warm-up");
 	}
+	(void) allocations;
 
+	frameCount++;
 	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
 void Renderer::cleanupSwapChain() {
-	for (auto framebuffer : swapChainFramebuffers) {
-		device.destroyFramebuffer(framebuffer);
-    }
+	graph.reset();
 
 	for (auto view : swapChainImageViews) {
 		device.destroyImageView(view);
@@ -750,62 +955,112 @@ void Renderer::recreateSwapChain(Window& window) {
 	cleanupSwapChain();
     createSwapChain(window);
     createImageViews();
-    createFramebuffers();
+    buildRenderGraph();
 }
 
 void Renderer::end() {
 	device.waitIdle();
 }
 
-void Renderer::createVertexBuffer() {
-	vk::DeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+vk::Format Renderer::findDepthFormat() {
+	for (vk::Format format : {vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint}) {
+		vk::FormatProperties props = physicalDevice.getFormatProperties(format);
+		if (props.optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment) {
+			return format;
+		}
+	}
+
+	throw std::runtime_error("failed to find a supported depth format!");
+}
+
+// Two timestamps per frame in flight bracket its command buffer. Without
+// timestamp support on the graphics queue the controller falls back to
+// wall-clock frame time.
+void Renderer::createTimestampQueries() {
+	vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+	if (!properties.limits.timestampComputeAndGraphics) return;
 
-	vk::DeviceMemory stagingBufferMemory;
-	vk::Buffer stagingBuffer = createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBufferMemory);
+	uint32_t family = findQueueFamilies(physicalDevice).graphicsFamily.value();
+	uint32_t validBits = physicalDevice.getQueueFamilyProperties()[family].timestampValidBits;
+	if (validBits == 0) return;
 
-	uint8_t * pData = static_cast<uint8_t *>(device.mapMemory(stagingBufferMemory, 0, bufferSize));
-    memcpy(pData, vertices.data(), bufferSize);
-    device.unmapMemory(stagingBufferMemory);
+	timestampPeriod = properties.limits.timestampPeriod;
+	timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
 
-	vertexBuffer = createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, vertexBufferMemory);
+	vk::QueryPoolCreateInfo poolInfo;
+	poolInfo.queryType = vk::QueryType::eTimestamp;
+	poolInfo.queryCount = MAX_FRAMES_IN_FLIGHT * 2;
 
-	copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
+	try {
+		timestampPool = device.createQueryPool(poolInfo);
+	} catch (vk::SystemError & err) {
+		std::cout << "vk::SystemError: " << err.what() << std::endl;
+		exit(-1);
+	}
+}
 
-	device.destroyBuffer(stagingBuffer);
-	device.freeMemory(stagingBufferMemory);
+void Renderer::setEntities(const EntityInstances *instances, float elapsed) {
+	entities = instances;
+	entityTime = elapsed;
 }
 
-uint32_t Renderer::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) {
-	vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
+void Renderer::setDynamicResolution(bool enabled) {
+	if (enabled && !blitSupported) {
+		std::cout << "Dynamic resolution is not supported by this swapchain" << std::endl;
+		enabled = false;
+	}
+
+	if (enabled == dynamicResolution) return;
 
-	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-		if (typeFilter & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & properties)) {
-			return i;
-		}
+	dynamicResolution = enabled;
+	resolution.reset();
+
+	// The scene target and upscale pass only exist while scaling is on.
+	if (device && swapChain) {
+		device.waitIdle();
+		buildRenderGraph();
 	}
+}
+
+vk::Extent2D Renderer::renderExtent() const {
+	if (!dynamicResolution) return swapChainExtent;
 
-	throw std::runtime_error("failed to find suitable memory type!");
+	float scale = resolution.scale();
+	return vk::Extent2D(
+		std::max(1u, static_cast<uint32_t>(swapChainExtent.width * scale)),
+		std::max(1u, static_cast<uint32_t>(swapChainExtent.height * scale))
+	);
 }
 
-void Renderer::createIndexBuffer() {
-	vk::DeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+// Called once the current frame's last submission has completed, so
+// its previous timestamps are available without waiting.
+void Renderer::readFrameTime() {
+	auto now = std::chrono::steady_clock::now();
+	float wallMs = std::chrono::duration<float, std::milli>(now - lastFrame).count();
+	lastFrame = now;
 
-	vk::DeviceMemory stagingBufferMemory;
-	vk::Buffer stagingBuffer = createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBufferMemory);
+	if (!dynamicResolution) return;
 
-	uint8_t * pData = static_cast<uint8_t *>(device.mapMemory(stagingBufferMemory, 0, bufferSize));
-    memcpy(pData, indices.data(), bufferSize);
-    device.unmapMemory(stagingBufferMemory);
+	if (!timestampPool) {
+		resolution.addSample(wallMs);
+		return;
+	}
 
-	indexBuffer = createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, indexBufferMemory);
+	if (!timestampsWritten[currentFrame]) return;
 
-	copyBuffer(stagingBuffer, indexBuffer, bufferSize);
+	uint64_t timestamps[2];
+	vk::Result result = device.getQueryPoolResults(timestampPool, currentFrame * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+	if (result != vk::Result::eSuccess) return;
 
-	device.destroyBuffer(stagingBuffer);
-	device.freeMemory(stagingBufferMemory);
+	// Only the valid bits count, so a counter that wrapped in between
+	// still subtracts right.
+	resolution.addSample(static_cast<float>((timestamps[1] - timestamps[0]) & timestampMask) * timestampPeriod / 1e6f);
 }
 
-vk::Buffer Renderer::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags flags, vk::MemoryPropertyFlags properties, vk::DeviceMemory& bufferMemory) {
+// Device-local memory is preferred as asked; when its heap is over
+// budget, or the driver runs out of it anyway, the buffer goes to
+// host-visible memory, which the GPU can still read, only slower.
+vk::Buffer Renderer::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags flags, vk::MemoryPropertyFlags properties, MemoryCategory category, vk::DeviceMemory& bufferMemory) {
 	vk::BufferCreateInfo bufferInfo;
     bufferInfo.size = size;
     bufferInfo.usage = flags;
@@ -827,12 +1082,27 @@ vk::Buffer Renderer::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags flag
 	}
 
 	vk::MemoryRequirements memRequirements = device.getBufferMemoryRequirements(buffer);
+	vk::MemoryPropertyFlags fallback = properties;
+	if (properties & vk::MemoryPropertyFlagBits::eDeviceLocal) {
+		fallback = (properties & ~vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eDeviceLocal)) | vk::MemoryPropertyFlagBits::eHostVisible;
+	}
+
 	vk::MemoryAllocateInfo allocInfo;
 	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
 	try {
-		bufferMemory = device.allocateMemory(allocInfo);
+		std::optional<uint32_t> type = budget.chooseType(memRequirements.memoryTypeBits, properties, fallback, memRequirements.size);
+		if (!type) throw std::runtime_error("failed to find suitable memory type!");
+		allocInfo.memoryTypeIndex = *type;
+
+		try {
+			bufferMemory = device.allocateMemory(allocInfo);
+		} catch (vk::OutOfDeviceMemoryError &) {
+			std::optional<uint32_t> host = budget.chooseType(memRequirements.memoryTypeBits, fallback, fallback, memRequirements.size);
+			if (fallback == properties || !host || *host == *type) throw;
+			allocInfo.memoryTypeIndex = *host;
+			bufferMemory = device.allocateMemory(allocInfo);
+		}
 	} catch (vk::SystemError & err) {
 		std::cout << "vk::SystemError: " << err.what() << std::endl;
 		exit(-1);
@@ -845,11 +1115,18 @@ vk::Buffer Renderer::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags flag
 	}
 
 	device.bindBufferMemory(buffer, bufferMemory, 0);
+	budget.allocated(bufferMemory, memRequirements.size, allocInfo.memoryTypeIndex, category, !budget.hasProperties(allocInfo.memoryTypeIndex, properties));
 
 	return buffer;
 }
 
-void Renderer::copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size) {
+void Renderer::destroyBuffer(vk::Buffer buffer, vk::DeviceMemory memory) {
+	device.destroyBuffer(buffer);
+	budget.freed(memory);
+	device.freeMemory(memory);
+}
+
+vk::CommandBuffer Renderer::beginSingleTimeCommands() {
 	vk::CommandBufferAllocateInfo allocInfo;
     allocInfo.level = vk::CommandBufferLevel::ePrimary;
     allocInfo.commandPool = commandPool;
@@ -863,21 +1140,796 @@ void Renderer::copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::Device
 
 	commandBuffer.begin(beginInfo);
 
+	return commandBuffer;
+}
+
+// Submits without waiting. Staging memory allocated since the previous
+// submission and the command buffer itself are released once the
+// returned timeline value is reached; later submissions on the queue are
+// ordered after this one by the barriers the caller records.
+uint64_t Renderer::endSingleTimeCommands(vk::CommandBuffer commandBuffer) {
+	commandBuffer.end();
+
+	TimelineSubmit submit;
+	submit.commandBuffer = commandBuffer;
+	uint64_t value = timeline.submit(graphicsQueue, submit);
+
+	staging.allocator.tag(value);
+	retired.push_back({value, nullptr, nullptr, commandBuffer});
+	return value;
+}
+
+void Renderer::createStagingRing(vk::DeviceSize size) {
+	// The compute mesher reads its packed input straight from here.
+	staging.buffer = createBuffer(size, vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging, staging.memory);
+	staging.mapped = static_cast<uint8_t *>(device.mapMemory(staging.memory, 0, size));
+	staging.allocator = RingAllocator(size);
+}
+
+// Waits for the oldest uploads when the ring is full. An upload larger
+// than the whole ring replaces it with a bigger one once nothing is left
+// in flight; each submission takes at most one block, so no untagged
+// data is lost with the old buffer.
+uint8_t *Renderer::allocateStaging(vk::DeviceSize size, vk::DeviceSize& offset) {
+	staging.allocator.release(timeline.completed());
+
+	std::optional<uint64_t> block;
+	while (!(block = staging.allocator.allocate(size, STAGING_ALIGNMENT))) {
+		uint64_t oldest = staging.allocator.oldest();
+		if (oldest != 0) {
+			timeline.wait(oldest);
+			staging.allocator.release(oldest);
+			continue;
+		}
+
+		assert(staging.allocator.used() == 0);
+		vk::DeviceSize capacity = staging.allocator.capacity();
+		while (capacity < size) capacity *= 2;
+
+		retireBuffer(staging.buffer, staging.memory);
+		createStagingRing(capacity);
+	}
+
+	offset = *block;
+	return staging.mapped + offset;
+}
+
+// The buffer may still be read by anything submitted so far.
+void Renderer::retireBuffer(vk::Buffer buffer, vk::DeviceMemory memory) {
+	retired.push_back({timeline.submitted(), buffer, memory, nullptr});
+}
+
+void Renderer::collectRetired() {
+	uint64_t completed = timeline.completed();
+
+	size_t kept = 0;
+	for (RetiredResource& resource : retired) {
+		if (resource.value > completed) {
+			retired[kept++] = resource;
+			continue;
+		}
+
+		if (resource.buffer) destroyBuffer(resource.buffer, resource.memory);
+		if (resource.commandBuffer) device.freeCommandBuffers(commandPool, {resource.commandBuffer});
+	}
+	retired.resize(kept);
+}
+
+// Nothing waits for the copy; the barriers order it after earlier
+// uploads and before later draws on the same queue.
+void Renderer::copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size) {
+	vk::CommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	vk::MemoryBarrier before;
+	before.srcAccessMask = vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite;
+	before.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), before, {}, {});
+
 	vk::BufferCopy copyRegion;
 	copyRegion.srcOffset = 0;
 	copyRegion.dstOffset = 0;
 	copyRegion.size = size;
 	commandBuffer.copyBuffer(srcBuffer, dstBuffer, 1, &copyRegion);
 
-	commandBuffer.end();
+	vk::MemoryBarrier after;
+	after.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	after.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), after, {}, {});
+
+	endSingleTimeCommands(commandBuffer);
+}
+
+// Called once per frame, with an empty batch when the simulation had no
+// new meshes, so compaction and translucent re-sorting still progress.
+void Renderer::updateMeshes(const MeshBatch& batch) {
+	collectRetired();
+	checkValidations();
+
+	for (size_t i = 0; i < batch.positions.size(); i++) {
+		SectionPos pos = batch.positions[i];
+		const SectionMesh& mesh = batch.meshes[i];
+		evicted.erase(pos);
+		restoring.erase(pos);
+
+		if (batch.loaded[i]) {
+			visibility.set(pos, mesh.connectivity);
+		} else {
+			visibility.removeColumn({pos.x, pos.z});
+		}
+
+		if (mesh.occluderTop > mesh.occluderBottom) {
+			glm::vec3 origin(pos.x * SECTION_SIZE, pos.y * SECTION_SIZE, pos.z * SECTION_SIZE);
+			occluders[pos] = {origin + glm::vec3(0.0f, mesh.occluderBottom, 0.0f), origin + glm::vec3(SECTION_SIZE, mesh.occluderTop, SECTION_SIZE)};
+		} else {
+			occluders.erase(pos);
+		}
+	}
+
+	balanceMemory(batch);
+	uploadSections(batch.positions, batch.meshes);
+	sortTranslucent();
+}
+
+void Renderer::takeRestored(std::vector<SectionPos>& positions) {
+	positions.insert(positions.end(), restored.begin(), restored.end());
+	restored.clear();
+}
+
+// Strict, so the nearest evicted section itself stays out.
+bool Renderer::withinEvictionDistance(SectionPos pos) const {
+	return distanceSquared(pos, camera.position) < evictionDistance * evictionDistance;
+}
+
+// Frees a section's blocks in the mesh arenas and remembers how many
+// vertex slots it held, so it can be brought back once there is room.
+uint32_t Renderer::evictSection(SectionPos pos) {
+	uint32_t slots = 0;
+
+	auto it = sectionDraws.find(pos);
+	if (it != sectionDraws.end()) {
+		slots += it->second.capacity;
+		freeArena(meshArena, it->second.offset);
+		if (it->second.gpu) freeArena(drawCommands, it->second.command);
+		sectionDraws.erase(it);
+	}
+
+	auto translucent = translucentDraws.find(pos);
+	if (translucent != translucentDraws.end()) {
+		slots += translucent->second.vertexCapacity;
+		freeArena(meshArena, translucent->second.vertexOffset);
+		freeArena(translucentIndices, translucent->second.indexOffset);
+		translucentDraws.erase(translucent);
+	}
+
+	if (slots > 0) evicted[pos] = slots;
+	return slots;
+}
+
+// Resident sections, farthest from the camera first.
+std::vector<std::pair<float, SectionPos>> Renderer::residentByDistance() const {
+	std::vector<std::pair<float, SectionPos>> resident;
+	for (const auto& [pos, section] : sectionDraws) resident.emplace_back(std::sqrt(distanceSquared(pos, camera.position)), pos);
+	for (const auto& [pos, draw] : translucentDraws) {
+		if (!sectionDraws.count(pos)) resident.emplace_back(std::sqrt(distanceSquared(pos, camera.position)), pos);
+	}
+	std::sort(resident.begin(), resident.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+	return resident;
+}
+
+// Uploads are skipped from the nearest evicted section out.
+void Renderer::updateEvictionDistance() {
+	evictionDistance = std::numeric_limits<float>::infinity();
+	for (const auto& [pos, size] : evicted) evictionDistance = std::min(evictionDistance, std::sqrt(distanceSquared(pos, camera.position)));
+}
+
+// When the mesh arena would have to grow past the device-local budget,
+// or while that heap is past MEMORY_PRESSURE, the farthest sections are
+// evicted to make room and later uploads from the nearest of them out
+// are skipped. Evicted sections are ranked against resident ones from
+// the current camera position whenever it has moved a section or there
+// is room: the nearest come back while they fit below MEMORY_RELIEF,
+// and the farthest resident ones make way for evicted ones at least a
+// section nearer. Those coming back are handed out through
+// takeRestored() to be meshed again.
+void Renderer::balanceMemory(const MeshBatch& batch) {
+	uint32_t needed = 0;
+	for (size_t i = 0; i < batch.positions.size(); i++) {
+		if (!withinEvictionDistance(batch.positions[i])) continue;
+		const SectionMesh& mesh = batch.meshes[i];
+		needed += roundUp(mesh.quadCount() * 4, MESH_ARENA_GRANULE) + roundUp(static_cast<uint32_t>(mesh.translucent.size()), MESH_ARENA_GRANULE);
+	}
+
+	uint32_t capacity = meshArena.allocator.capacity();
+	uint32_t free = capacity - meshArena.allocator.used();
+	// Growing keeps the old buffer alive until the copy completes.
+	vk::DeviceSize grown = meshArena.slotSize * std::max(capacity * 2, capacity + needed);
+	bool canGrow = budget.deviceLocalPressure() < MEMORY_PRESSURE && budget.fits(budget.deviceLocalHeap(), grown);
+
+	if (needed > free && !canGrow) {
+		uint32_t target = std::max(needed - free, static_cast<uint32_t>(capacity * EVICTION_FRACTION));
+		uint32_t freed = 0;
+		for (const auto& [distance, pos] : residentByDistance()) {
+			if (freed >= target) break;
+			freed += evictSection(pos);
+		}
+		updateEvictionDistance();
+		balancedAt = camera.position;
+		balancedRoom = 0;
+		return;
+	}
+
+	if (evicted.empty()) return;
+
+	// Sections already handed out count as back, so they are not handed
+	// out twice before their meshes arrive.
+	uint32_t pending = 0;
+	for (const auto& [pos, size] : restoring) pending += size;
+
+	uint32_t room = std::numeric_limits<uint32_t>::max();
+	if (!canGrow || budget.deviceLocalPressure() >= MEMORY_RELIEF) {
+		uint32_t limit = static_cast<uint32_t>(capacity * MEMORY_RELIEF);
+		uint32_t used = meshArena.allocator.used() + needed + pending;
+		room = limit > used ? limit - used : 0;
+	}
+
+	// Nothing changes the ranking until the camera moves or room frees up.
+	glm::vec3 moved = camera.position - balancedAt;
+	if (room <= balancedRoom && moved.x * moved.x + moved.y * moved.y + moved.z * moved.z < SECTION_SIZE * SECTION_SIZE) return;
+	balancedAt = camera.position;
+
+	std::vector<std::pair<float, SectionPos>> candidates;
+	for (const auto& [pos, size] : evicted) candidates.emplace_back(std::sqrt(distanceSquared(pos, camera.position)), pos);
+	std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::vector<std::pair<float, SectionPos>> resident;
+	size_t farthest = 0;
+	for (const auto& [distance, pos] : candidates) {
+		uint32_t size = evicted.at(pos);
+		if (size > room && resident.empty()) resident = residentByDistance();
+		while (size > room && farthest < resident.size() && resident[farthest].first > distance + SECTION_SIZE) {
+			room += evictSection(resident[farthest++].second);
+		}
+		if (size > room) break;
+
+		room -= size;
+		restoring[pos] = size;
+		restored.push_back(pos);
+		evicted.erase(pos);
+	}
+	balancedRoom = room;
+	updateEvictionDistance();
+}
+
+// Connectivity culling first; the sections it keeps then supply the
+// occluders for the depth test, nearest first.
+void Renderer::cullSections() {
+	float aspect = swapChainExtent.width / (float) swapChainExtent.height;
+	glm::mat4 viewProjection = camera.projection(aspect) * camera.view();
+	LinearArena& scratch = frameArenas[currentFrame];
+	visibility.collect(camera.position, Frustum(viewProjection), visibleSections, scratch);
+
+	FrameVector<std::pair<float, const Occluder *>> candidates{FrameAllocator<std::pair<float, const Occluder *>>(scratch)};
+	candidates.reserve(visibleSections.size());
+	for (SectionPos pos : visibleSections) {
+		auto it = occluders.find(pos);
+		if (it == occluders.end()) continue;
+
+		glm::vec3 center = (it->second.min + it->second.max) * 0.5f;
+		glm::vec3 offset = center - camera.position;
+		candidates.push_back({glm::dot(offset, offset), &it->second});
+	}
+
+	if (candidates.size() > MAX_OCCLUDERS) {
+		std::nth_element(candidates.begin(), candidates.begin() + MAX_OCCLUDERS, candidates.end(), [](const auto& a, const auto& b) {
+			return a.first < b.first;
+		});
+		candidates.resize(MAX_OCCLUDERS);
+	}
+
+	FrameVector<Occluder> selected{FrameAllocator<Occluder>(scratch)};
+	selected.reserve(candidates.size());
+	for (const auto& candidate : candidates) selected.push_back(*candidate.second);
+
+	occlusion.render(viewProjection, selected.data(), selected.size(), jobs);
+	occlusion.cull(visibleSections, jobs, scratch);
+}
+
+void Renderer::createMeshBuffers() {
+	createArena(meshArena, MESH_ARENA_VERTICES, sizeof(Vertex), vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+	createArena(translucentIndices, TRANSLUCENT_ARENA_INDICES, sizeof(uint16_t), vk::BufferUsageFlagBits::eIndexBuffer);
+
+	// Every opaque section draws its quads with this one buffer: quad q
+	// uses vertices 4q to 4q + 3 relative to the draw's vertexOffset.
+	std::vector<uint16_t> indices(MAX_SECTION_QUADS * 6);
+	for (uint32_t quad = 0; quad < MAX_SECTION_QUADS; quad++) {
+		uint16_t base = static_cast<uint16_t>(quad * 4);
+		uint16_t pattern[6] = {base, static_cast<uint16_t>(base + 1), static_cast<uint16_t>(base + 2), static_cast<uint16_t>(base + 2), static_cast<uint16_t>(base + 3), base};
+		std::copy(pattern, pattern + 6, indices.begin() + quad * 6);
+	}
+
+	vk::DeviceSize size = sizeof(uint16_t) * indices.size();
+	vk::DeviceSize offset;
+	memcpy(allocateStaging(size, offset), indices.data(), size);
+
+	quadIndexBuffer = createBuffer(size, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Meshes, quadIndexMemory);
+
+	std::vector<Vertex> models = buildEntityModels();
+	vk::DeviceSize modelSize = sizeof(Vertex) * models.size();
+	vk::DeviceSize modelOffset;
+	memcpy(allocateStaging(modelSize, modelOffset), models.data(), modelSize);
+
+	entityModelBuffer = createBuffer(modelSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Meshes, entityModelMemory);
+
+	vk::CommandBuffer commandBuffer = beginSingleTimeCommands();
+	commandBuffer.copyBuffer(staging.buffer, quadIndexBuffer, vk::BufferCopy(offset, 0, size));
+	commandBuffer.copyBuffer(staging.buffer, entityModelBuffer, vk::BufferCopy(modelOffset, 0, modelSize));
+	endSingleTimeCommands(commandBuffer);
+}
+
+void Renderer::createArena(GpuArena& arena, uint32_t capacity, vk::DeviceSize slotSize, vk::BufferUsageFlags usage) {
+	arena.slotSize = slotSize;
+	arena.usage = usage | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+	arena.allocator = ArenaAllocator(capacity);
+	arena.buffer = createBuffer(slotSize * capacity, arena.usage, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Meshes, arena.memory);
+}
+
+void Renderer::destroyArena(GpuArena& arena) {
+	destroyBuffer(arena.buffer, arena.memory);
+}
+
+// Grows the arena by at least doubling it when no free block fits. The
+// old buffer is copied over whole and retired, since frames in flight and
+// the copy itself may still read it.
+void Renderer::allocateArena(GpuArena& arena, uint32_t size, uint32_t& offset) {
+	std::optional<uint32_t> block = arena.allocator.allocate(size);
+
+	if (!block) {
+		uint32_t oldCapacity = arena.allocator.capacity();
+		uint32_t capacity = std::max(oldCapacity * 2, oldCapacity + size);
+
+		vk::DeviceMemory memory;
+		vk::Buffer buffer = createBuffer(arena.slotSize * capacity, arena.usage, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Meshes, memory);
+		copyBuffer(arena.buffer, buffer, arena.slotSize * oldCapacity);
+
+		retireBuffer(arena.buffer, arena.memory);
+		arena.buffer = buffer;
+		arena.memory = memory;
+
+		arena.allocator.grow(capacity);
+		block = arena.allocator.allocate(size);
+	}
+
+	offset = *block;
+	arena.owners[offset] = &offset;
+}
+
+void Renderer::freeArena(GpuArena& arena, uint32_t offset) {
+	arena.allocator.free(offset);
+	arena.owners.erase(offset);
+}
+
+// Plans a bounded compaction step once the free space is fragmented and
+// points the moved blocks' owners at their new offsets. The returned
+// copies must run before anything else is written to the arena.
+std::vector<vk::BufferCopy> Renderer::compactArena(GpuArena& arena) {
+	std::vector<vk::BufferCopy> regions;
+	if (arena.allocator.fragmentation() <= ARENA_COMPACT_THRESHOLD) return regions;
+
+	for (const ArenaMove& move : arena.allocator.compact(ARENA_COMPACT_BUDGET)) {
+		uint32_t *owner = arena.owners.at(move.from);
+		arena.owners.erase(move.from);
+		arena.owners[move.to] = owner;
+		*owner = move.to;
+		regions.emplace_back(arena.slotSize * move.from, arena.slotSize * move.to, arena.slotSize * move.size);
+	}
+
+	return regions;
+}
+
+// Sorts every listed section for the same eye position in parallel,
+// writing each one's indices to the matching output.
+static void sortSections(JobSystem& jobs, glm::vec3 eye, const std::vector<const TranslucentDraw *>& draws, const std::vector<uint16_t *>& outputs) {
+	std::vector<size_t> starts(draws.size() + 1, 0);
+	for (size_t i = 0; i < draws.size(); i++) starts[i + 1] = starts[i] + draws[i]->centers.size();
+
+	std::vector<uint32_t> keys(starts.back());
+	std::vector<uint32_t> scratch(starts.back());
+
+	jobs.parallelFor(draws.size(), [&](size_t i) {
+		const std::vector<glm::vec3>& centers = draws[i]->centers;
+		sortTranslucentQuads(centers.data(), static_cast<uint32_t>(centers.size()), eye, keys.data() + starts[i], scratch.data() + starts[i], outputs[i]);
+	});
+}
+
+void Renderer::uploadSections(const std::vector<SectionPos>& positions, const std::vector<SectionMesh>& meshes) {
+	// Compaction is planned before this upload allocates, so blocks it
+	// frees can be handed out again below: its copies are recorded first.
+	std::vector<vk::BufferCopy> vertexMoves = compactArena(meshArena);
+	std::vector<vk::BufferCopy> indexMoves = compactArena(translucentIndices);
+
+	vk::DeviceSize stagingSize = 0;
+	uint32_t gpuSections = 0;
+	uint32_t gpuWords = 0;
+	vk::DeviceSize readbackSize = 0;
+
+	for (size_t i = 0; i < positions.size(); i++) {
+		SectionPos pos = positions[i];
+		const SectionMesh& mesh = meshes[i];
+
+		uint32_t count = mesh.quadCount() * 4;
+		uint32_t translucentCount = static_cast<uint32_t>(mesh.translucent.size());
+		if (!withinEvictionDistance(pos)) {
+			evictSection(pos);
+			if (count + translucentCount > 0) {
+				evicted[pos] = roundUp(count, MESH_ARENA_GRANULE) + roundUp(translucentCount, MESH_ARENA_GRANULE);
+			} else {
+				evicted.erase(pos);
+			}
+			continue;
+		}
+
+		auto it = sectionDraws.find(pos);
+
+		if (count == 0) {
+			if (it != sectionDraws.end()) {
+				freeArena(meshArena, it->second.offset);
+				if (it->second.gpu) freeArena(drawCommands, it->second.command);
+				sectionDraws.erase(it);
+			}
+		} else {
+			SectionDraw& section = sectionDraws[pos];
+			if (section.capacity < count) {
+				if (section.capacity > 0) freeArena(meshArena, section.offset);
+				section.capacity = roundUp(count, MESH_ARENA_GRANULE);
+				allocateArena(meshArena, section.capacity, section.offset);
+			}
+
+			section.quadCount = mesh.quadCount();
+
+			bool gpu = mesh.packed.has_value();
+			if (gpu && !section.gpu) {
+				createGpuMesher();
+				allocateArena(drawCommands, 1, section.command);
+			} else if (!gpu && section.gpu) {
+				freeArena(drawCommands, section.command);
+			}
+			section.gpu = gpu;
+
+			if (gpu) {
+				gpuSections++;
+				gpuWords += sizeof(GpuSectionHeader) / sizeof(uint32_t) + GpuMesher::packedWords(*mesh.packed);
+				stagingSize += sizeof(vk::DrawIndexedIndirectCommand);
+				section.commandVertexOffset = section.offset;
+				if (!mesh.vertices.empty()) readbackSize += sizeof(vk::DrawIndexedIndirectCommand) + sizeof(Vertex) * count;
+			} else {
+				stagingSize += sizeof(Vertex) * count;
+			}
+		}
+
+		auto translucent = translucentDraws.find(pos);
+
+		if (translucentCount == 0) {
+			if (translucent != translucentDraws.end()) {
+				freeArena(meshArena, translucent->second.vertexOffset);
+				freeArena(translucentIndices, translucent->second.indexOffset);
+				translucentDraws.erase(translucent);
+			}
+		} else {
+			TranslucentDraw& draw = translucentDraws[pos];
+			uint32_t indexCount = translucentCount / 4 * 6;
+
+			if (draw.vertexCapacity < translucentCount) {
+				if (draw.vertexCapacity > 0) freeArena(meshArena, draw.vertexOffset);
+				draw.vertexCapacity = roundUp(translucentCount, MESH_ARENA_GRANULE);
+				allocateArena(meshArena, draw.vertexCapacity, draw.vertexOffset);
+			}
+
+			if (draw.indexCapacity < indexCount) {
+				if (draw.indexCapacity > 0) freeArena(translucentIndices, draw.indexOffset);
+				draw.indexCapacity = roundUp(indexCount, TRANSLUCENT_INDEX_GRANULE);
+				allocateArena(translucentIndices, draw.indexCapacity, draw.indexOffset);
+			}
+
+			// Centres are kept in world space to sort against the eye.
+			glm::vec3 origin = sectionOrigin(pos);
+			draw.centers.resize(translucentCount / 4);
+			for (size_t quad = 0; quad < draw.centers.size(); quad++) {
+				const Vertex *corners = &mesh.translucent[quad * 4];
+				draw.centers[quad] = origin + (corners[0].pos + corners[2].pos) * 0.5f;
+			}
 
-	vk::SubmitInfo submitInfo;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
-	graphicsQueue.submit(submitInfo, nullptr);
-	graphicsQueue.waitIdle();
+			stagingSize += sizeof(Vertex) * translucentCount + sizeof(uint16_t) * indexCount;
+		}
+	}
+
+	// Compaction may have moved vertex blocks the GPU meshed earlier;
+	// their draw commands still point at the old place.
+	std::vector<SectionDraw *> moved;
+	if (!vertexMoves.empty()) {
+		for (auto& [pos, section] : sectionDraws) {
+			if (section.gpu && section.commandVertexOffset != section.offset) moved.push_back(&section);
+		}
+		stagingSize += sizeof(int32_t) * moved.size();
+	}
+
+	stagingSize += sizeof(uint32_t) * gpuWords;
+	if (stagingSize == 0 && vertexMoves.empty() && indexMoves.empty()) return;
+
+	vk::CommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	// The arenas are patched in place, so the copies must not start while
+	// frames submitted earlier are still reading the old contents, nor
+	// before earlier uploads and meshing, which nothing waits for, have
+	// landed.
+	vk::MemoryBarrier previous;
+	previous.srcAccessMask = vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite;
+	previous.dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), previous, {}, {});
+
+	if (!vertexMoves.empty() || !indexMoves.empty()) {
+		if (!vertexMoves.empty()) commandBuffer.copyBuffer(meshArena.buffer, meshArena.buffer, vertexMoves);
+		if (!indexMoves.empty()) commandBuffer.copyBuffer(translucentIndices.buffer, translucentIndices.buffer, indexMoves);
+
+		vk::MemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), barrier, {}, {});
+	}
+
+	vk::DeviceSize stagingOffset = 0;
+	MeshValidation validation{};
+	std::vector<std::pair<const SectionDraw *, vk::DeviceSize>> readbacks;
+
+	if (stagingSize > 0) {
+		uint8_t * pData = allocateStaging(stagingSize, stagingOffset);
+
+		// The compute mesher's input comes first: every header, then the
+		// sections' palettes, indices and light.
+		uint32_t *words = reinterpret_cast<uint32_t *>(pData);
+		GpuSectionHeader *headers = reinterpret_cast<GpuSectionHeader *>(pData);
+		uint32_t nextWord = gpuSections * static_cast<uint32_t>(sizeof(GpuSectionHeader) / sizeof(uint32_t));
+		uint32_t header = 0;
+
+		if (readbackSize > 0) {
+			validation.buffer = createBuffer(readbackSize, vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging, validation.memory);
+		}
+
+		std::vector<vk::BufferCopy> vertexRegions;
+		std::vector<vk::BufferCopy> indexRegions;
+		std::vector<vk::BufferCopy> commandRegions;
+		std::vector<const TranslucentDraw *> sorted;
+		std::vector<uint16_t *> sortedIndices;
+		vk::DeviceSize offset = sizeof(uint32_t) * gpuWords;
+		vk::DeviceSize readbackOffset = 0;
+
+		for (size_t i = 0; i < positions.size(); i++) {
+			const SectionMesh& mesh = meshes[i];
+			if (!withinEvictionDistance(positions[i])) continue;
+
+			if (mesh.packed && mesh.quadCount() > 0) {
+				const SectionDraw& section = sectionDraws.at(positions[i]);
+				GpuSectionHeader& sectionHeader = headers[header++];
+				nextWord = GpuMesher::writePacked(words, nextWord, *mesh.packed, sectionHeader);
+				sectionHeader.vertexOffset = section.offset;
+				sectionHeader.command = section.command;
+				sectionHeader.quadCount = section.quadCount;
+				sectionHeader.pad = 0;
+
+				vk::DrawIndexedIndirectCommand command(0, 1, 0, static_cast<int32_t>(section.offset), 0);
+				memcpy(pData + offset, &command, sizeof(command));
+				commandRegions.emplace_back(stagingOffset + offset, drawCommands.slotSize * section.command, sizeof(command));
+				offset += sizeof(command);
+
+				if (!mesh.vertices.empty()) {
+					validation.checks.push_back({positions[i], readbackOffset, section.quadCount, mesh.vertices});
+					readbacks.emplace_back(&section, readbackOffset);
+					readbackOffset += sizeof(vk::DrawIndexedIndirectCommand) + sizeof(Vertex) * section.quadCount * 4;
+				}
+			} else if (!mesh.vertices.empty()) {
+				const SectionDraw& section = sectionDraws.at(positions[i]);
+				vk::DeviceSize size = sizeof(Vertex) * mesh.vertices.size();
+				memcpy(pData + offset, mesh.vertices.data(), size);
+				vertexRegions.emplace_back(stagingOffset + offset, meshArena.slotSize * section.offset, size);
+				offset += size;
+			}
+
+			if (!mesh.translucent.empty()) {
+				const TranslucentDraw& draw = translucentDraws.at(positions[i]);
+				vk::DeviceSize size = sizeof(Vertex) * mesh.translucent.size();
+				memcpy(pData + offset, mesh.translucent.data(), size);
+				vertexRegions.emplace_back(stagingOffset + offset, meshArena.slotSize * draw.vertexOffset, size);
+				offset += size;
+
+				vk::DeviceSize indexSize = sizeof(uint16_t) * 6 * draw.centers.size();
+				sorted.push_back(&draw);
+				sortedIndices.push_back(reinterpret_cast<uint16_t *>(pData + offset));
+				indexRegions.emplace_back(stagingOffset + offset, translucentIndices.slotSize * draw.indexOffset, indexSize);
+				offset += indexSize;
+			}
+		}
+
+		for (SectionDraw *section : moved) {
+			int32_t vertexOffset = static_cast<int32_t>(section->offset);
+			memcpy(pData + offset, &vertexOffset, sizeof(vertexOffset));
+			commandRegions.emplace_back(stagingOffset + offset, drawCommands.slotSize * section->command + offsetof(VkDrawIndexedIndirectCommand, vertexOffset), sizeof(vertexOffset));
+			section->commandVertexOffset = section->offset;
+			offset += sizeof(vertexOffset);
+		}
+
+		sortSections(jobs, camera.position, sorted, sortedIndices);
+
+		if (!vertexRegions.empty()) commandBuffer.copyBuffer(staging.buffer, meshArena.buffer, vertexRegions);
+		if (!indexRegions.empty()) commandBuffer.copyBuffer(staging.buffer, translucentIndices.buffer, indexRegions);
+		if (!commandRegions.empty()) commandBuffer.copyBuffer(staging.buffer, drawCommands.buffer, commandRegions);
+	}
+
+	if (gpuSections > 0) {
+		vk::MemoryBarrier toCompute;
+		toCompute.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		toCompute.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), toCompute, {}, {});
+
+		// Arena growth or a new staging ring replaces a bound buffer; the
+		// descriptor set can only be rewritten once no dispatch uses it.
+		if (!gpuMesher.bound(staging.buffer, blockTableBuffer, meshArena.buffer, drawCommands.buffer)) {
+			timeline.wait(meshDispatchValue);
+			gpuMesher.bind(staging.buffer, blockTableBuffer, meshArena.buffer, drawCommands.buffer);
+		}
+		gpuMesher.dispatch(commandBuffer, static_cast<uint32_t>(stagingOffset / sizeof(uint32_t)), gpuSections);
+	}
+
+	vk::MemoryBarrier barrier;
+	barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite;
+	barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eTransferRead;
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), barrier, {}, {});
+
+	for (const auto& [section, readbackOffset] : readbacks) {
+		vk::DeviceSize commandSize = sizeof(vk::DrawIndexedIndirectCommand);
+		commandBuffer.copyBuffer(drawCommands.buffer, validation.buffer, vk::BufferCopy(drawCommands.slotSize * section->command, readbackOffset, commandSize));
+		commandBuffer.copyBuffer(meshArena.buffer, validation.buffer, vk::BufferCopy(meshArena.slotSize * section->offset, readbackOffset + commandSize, sizeof(Vertex) * section->quadCount * 4));
+	}
+
+	if (!readbacks.empty()) {
+		vk::MemoryBarrier toHost;
+		toHost.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		toHost.dstAccessMask = vk::AccessFlagBits::eHostRead;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, vk::DependencyFlags(), toHost, {}, {});
+	}
+
+	uint64_t value = endSingleTimeCommands(commandBuffer);
+	if (gpuSections > 0) meshDispatchValue = value;
+	if (validation.buffer) {
+		validation.value = value;
+		validations.push_back(std::move(validation));
+	}
+}
+
+// Built the first time a batch arrives with packed sections, so runs
+// that mesh on the CPU never compile the compute shader.
+void Renderer::createGpuMesher() {
+	if (gpuMesher.ready()) return;
+
+	try {
+		gpuMesher.create(device);
+	} catch (vk::SystemError & err) {
+		std::cout << "vk::SystemError: " << err.what() << std::endl;
+		exit(-1);
+	} catch (std::exception & err) {
+		std::cout << "std::exception: " << err.what() << std::endl;
+		exit(-1);
+	} catch (...) {
+		std::cout << "unknown error" << std::endl;
+		exit(-1);
+	}
+
+	createArena(drawCommands, DRAW_COMMAND_SLOTS, sizeof(vk::DrawIndexedIndirectCommand), vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+
+	std::vector<GpuBlockInfo> table = GpuMesher::blockTable();
+	vk::DeviceSize size = sizeof(GpuBlockInfo) * table.size();
+	vk::DeviceSize offset;
+	memcpy(allocateStaging(size, offset), table.data(), size);
+
+	blockTableBuffer = createBuffer(size, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Other, blockTableMemory);
 
-	device.freeCommandBuffers(commandPool, {commandBuffer});
+	vk::CommandBuffer commandBuffer = beginSingleTimeCommands();
+	commandBuffer.copyBuffer(staging.buffer, blockTableBuffer, vk::BufferCopy(offset, 0, size));
+	endSingleTimeCommands(commandBuffer);
+}
+
+// Compares the GPU's opaque faces with the CPU mesher's once the upload
+// that produced them has completed, and reports every mismatch.
+void Renderer::checkValidations() {
+	size_t kept = 0;
+	for (size_t i = 0; i < validations.size(); i++) {
+		MeshValidation& validation = validations[i];
+		if (!timeline.isComplete(validation.value)) {
+			if (kept != i) validations[kept] = std::move(validation);
+			kept++;
+			continue;
+		}
+
+		const uint8_t *mapped = static_cast<const uint8_t *>(device.mapMemory(validation.memory, 0, VK_WHOLE_SIZE));
+		for (const MeshCheck& check : validation.checks) {
+			vk::DrawIndexedIndirectCommand command;
+			memcpy(&command, mapped + check.offset, sizeof(command));
+			const Vertex *vertices = reinterpret_cast<const Vertex *>(mapped + check.offset + sizeof(command));
+
+			std::string error;
+			if (check.expected.size() != check.quadCount * 4) {
+				error = "CPU mesher made " + std::to_string(check.expected.size() / 4) + " quads, face count was " + std::to_string(check.quadCount);
+			} else {
+				error = GpuMesher::compare(check.expected, vertices, command.indexCount);
+			}
+			if (error.empty()) {
+				validatedSections++;
+			} else {
+				std::cout << "GPU mesher mismatch in section " << check.pos.x << ", " << check.pos.y << ", " << check.pos.z << ": " << error << std::endl;
+			}
+		}
+		device.unmapMemory(validation.memory);
+
+		destroyBuffer(validation.buffer, validation.memory);
+	}
+	validations.resize(kept);
+}
+
+// Translucent faces only change order when the eye moves to another
+// block. Each frame after that re-sorts a bounded number of quads,
+// nearest sections first, and uploads just their index blocks.
+void Renderer::sortTranslucent() {
+	glm::ivec3 cell(glm::floor(camera.position));
+	if (!sortCell || *sortCell != cell) {
+		sortCell = cell;
+		sortQueue.clear();
+		for (const auto& [pos, draw] : translucentDraws) sortQueue.push_back(pos);
+
+		glm::vec3 eye = camera.position;
+		std::sort(sortQueue.begin(), sortQueue.end(), [&](SectionPos a, SectionPos b) {
+			return distanceSquared(a, eye) > distanceSquared(b, eye);
+		});
+	}
+
+	std::vector<const TranslucentDraw *> draws;
+	size_t quads = 0;
+	while (!sortQueue.empty() && quads < TRANSLUCENT_SORT_BUDGET) {
+		auto it = translucentDraws.find(sortQueue.back());
+		sortQueue.pop_back();
+		if (it == translucentDraws.end()) continue;
+
+		draws.push_back(&it->second);
+		quads += it->second.centers.size();
+	}
+
+	if (draws.empty()) return;
+
+	vk::DeviceSize stagingSize = sizeof(uint16_t) * 6 * quads;
+	vk::DeviceSize stagingOffset;
+	uint8_t * pData = allocateStaging(stagingSize, stagingOffset);
+
+	std::vector<uint16_t *> outputs;
+	std::vector<vk::BufferCopy> regions;
+	vk::DeviceSize offset = 0;
+	for (const TranslucentDraw *draw : draws) {
+		vk::DeviceSize size = sizeof(uint16_t) * 6 * draw->centers.size();
+		outputs.push_back(reinterpret_cast<uint16_t *>(pData + offset));
+		regions.emplace_back(stagingOffset + offset, translucentIndices.slotSize * draw->indexOffset, size);
+		offset += size;
+	}
+
+	sortSections(jobs, camera.position, draws, outputs);
+
+	vk::CommandBuffer commandBuffer = beginSingleTimeCommands();
+	vk::MemoryBarrier previous;
+	previous.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	previous.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), previous, {}, {});
+	commandBuffer.copyBuffer(staging.buffer, translucentIndices.buffer, regions);
+
+	vk::MemoryBarrier barrier;
+	barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	barrier.dstAccessMask = vk::AccessFlagBits::eIndexRead;
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, vk::DependencyFlags(), barrier, {}, {});
+	endSingleTimeCommands(commandBuffer);
 }
 
 void Renderer::createDescriptorSetLayout() {
@@ -887,10 +1939,19 @@ void Renderer::createDescriptorSetLayout() {
     uboLayoutBinding.descriptorCount = 1;
 	uboLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eVertex;
 	uboLayoutBinding.pImmutableSamplers = nullptr;
+
+	vk::DescriptorSetLayoutBinding drawLayoutBinding;
+	drawLayoutBinding.binding = 1;
+	drawLayoutBinding.descriptorType = vk::DescriptorType::eStorageBuffer;
+	drawLayoutBinding.descriptorCount = 1;
+	drawLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eVertex;
+	drawLayoutBinding.pImmutableSamplers = nullptr;
+
+	vk::DescriptorSetLayoutBinding bindings[] = {uboLayoutBinding, drawLayoutBinding};
 	
 	vk::DescriptorSetLayoutCreateInfo layoutInfo;
-	layoutInfo.bindingCount = 1;
-	layoutInfo.pBindings = &uboLayoutBinding;
+	layoutInfo.bindingCount = 2;
+	layoutInfo.pBindings = bindings;
 
 	try {
 		descriptorSetLayout = device.createDescriptorSetLayout(layoutInfo);
@@ -906,44 +1967,90 @@ void Renderer::createDescriptorSetLayout() {
 	}
 }
 
-void Renderer::createUniformBuffers() {
-	vk::DeviceSize bufferSize = sizeof(UniformBufferObject);
-    uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-    uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-    uniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+void Renderer::createFrameRings() {
+	vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+	uint32_t alignment = static_cast<uint32_t>(properties.limits.minStorageBufferOffsetAlignment);
+	drawDataOffset = roundUp(static_cast<uint32_t>(sizeof(UniformBufferObject)), std::max(alignment, 1u));
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        uniformBuffers[i] = createBuffer(bufferSize, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, uniformBuffersMemory[i]);
-		uniformBuffersMapped[i] = static_cast<uint8_t *>(device.mapMemory(uniformBuffersMemory[i], 0, bufferSize));
-    }
+	for (FrameRing& ring : frameRings) createFrameRing(ring, FRAME_RING_DRAWS);
+	for (InstanceRing& ring : instanceRings) createInstanceRing(ring, INSTANCE_RING_INSTANCES);
 }
 
-void Renderer::updateUniformBuffer(uint32_t currentImage) {
-	static auto startTime = std::chrono::high_resolution_clock::now();
+void Renderer::createFrameRing(FrameRing& ring, uint32_t draws) {
+	vk::DeviceSize size = drawDataOffset + sizeof(DrawData) * draws;
+	ring.buffer = createBuffer(size, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniforms, ring.memory);
+	ring.mapped = static_cast<uint8_t *>(device.mapMemory(ring.memory, 0, size));
+	ring.draws = draws;
+}
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+void Renderer::destroyFrameRing(FrameRing& ring) {
+	device.unmapMemory(ring.memory);
+	destroyBuffer(ring.buffer, ring.memory);
+	ring.mapped = nullptr;
+}
 
-	UniformBufferObject ubo{};
-ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+// Called once the frame's last submission has completed, so neither the
+// old buffer nor the descriptor set pointing at it can still be in use.
+void Renderer::reserveFrameRing(uint32_t frame, uint32_t draws) {
+	FrameRing& ring = frameRings[frame];
+	if (draws <= ring.draws) return;
+
+	uint32_t capacity = ring.draws;
+	while (capacity < draws) capacity *= 2;
+
+	destroyFrameRing(ring);
+	createFrameRing(ring, capacity);
+	writeDescriptorSet(frame);
+}
+
+void Renderer::createInstanceRing(InstanceRing& ring, uint32_t capacity) {
+	vk::DeviceSize size = sizeof(InstanceData) * capacity;
+	ring.buffer = createBuffer(size, vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniforms, ring.memory);
+	ring.mapped = static_cast<InstanceData *>(device.mapMemory(ring.memory, 0, size));
+	ring.capacity = capacity;
+}
+
+void Renderer::destroyInstanceRing(InstanceRing& ring) {
+	device.unmapMemory(ring.memory);
+	destroyBuffer(ring.buffer, ring.memory);
+	ring.mapped = nullptr;
+}
 
-	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+// Like reserveFrameRing, only called once the frame's last submission
+// has completed.
+void Renderer::reserveInstanceRing(uint32_t frame, uint32_t instances) {
+	InstanceRing& ring = instanceRings[frame];
+	if (instances <= ring.capacity) return;
+
+	uint32_t capacity = ring.capacity;
+	while (capacity < instances) capacity *= 2;
+
+	destroyInstanceRing(ring);
+	createInstanceRing(ring, capacity);
+}
 
-	ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float) swapChainExtent.height, 0.1f, 10.0f);
+// The camera is set from the interpolated simulation state before each
+// frame; nothing here depends on wall-clock time.
+void Renderer::updateUniformBuffer(uint32_t currentImage) {
+	UniformBufferObject ubo{};
+	ubo.view = camera.view();
+	ubo.proj = camera.projection(swapChainExtent.width / (float) swapChainExtent.height);
 
 	ubo.proj[1][1] *= -1;
 
-	memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+	memcpy(frameRings[currentImage].mapped, &ubo, sizeof(ubo));
 }
 
 void Renderer::createDescriptorPool() {
-	vk::DescriptorPoolSize poolSize;
-	poolSize.type = vk::DescriptorType::eUniformBuffer;
-	poolSize.descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+	vk::DescriptorPoolSize poolSizes[2];
+	poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
+	poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+	poolSizes[1].type = vk::DescriptorType::eStorageBuffer;
+	poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 
 	vk::DescriptorPoolCreateInfo poolInfo;
-	poolInfo.poolSizeCount = 1;
-	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
 	poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 
 	try {
@@ -982,22 +2089,35 @@ void Renderer::createDescriptorSets() {
 		exit(-1);
 	}
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		vk::DescriptorBufferInfo bufferInfo;
-		bufferInfo.buffer = uniformBuffers[i];
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(UniformBufferObject);
-
-		vk::WriteDescriptorSet descriptorWrite;
-		descriptorWrite.dstSet = descriptorSets[i];
-		descriptorWrite.dstBinding = 0;
-		descriptorWrite.dstArrayElement = 0;
-		descriptorWrite.descriptorType = vk::DescriptorType::eUniformBuffer;
-		descriptorWrite.descriptorCount = 1;
-		descriptorWrite.pBufferInfo = &bufferInfo;
-		descriptorWrite.pImageInfo = nullptr;
-		descriptorWrite.pTexelBufferView = nullptr;
-		
-		device.updateDescriptorSets({descriptorWrite}, {});
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) writeDescriptorSet(i);
+}
+
+// Both bindings point into the frame's ring, so this only runs again
+// when a ring is replaced by a larger one.
+void Renderer::writeDescriptorSet(uint32_t frame) {
+	vk::DescriptorBufferInfo bufferInfo;
+	bufferInfo.buffer = frameRings[frame].buffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = sizeof(UniformBufferObject);
+
+	vk::DescriptorBufferInfo drawInfo;
+	drawInfo.buffer = frameRings[frame].buffer;
+	drawInfo.offset = drawDataOffset;
+	drawInfo.range = VK_WHOLE_SIZE;
+
+	vk::WriteDescriptorSet descriptorWrites[2];
+	for (int i = 0; i < 2; i++) {
+		descriptorWrites[i].dstSet = descriptorSets[frame];
+		descriptorWrites[i].dstBinding = i;
+		descriptorWrites[i].dstArrayElement = 0;
+		descriptorWrites[i].descriptorCount = 1;
+		descriptorWrites[i].pImageInfo = nullptr;
+		descriptorWrites[i].pTexelBufferView = nullptr;
 	}
+	descriptorWrites[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+	descriptorWrites[0].pBufferInfo = &bufferInfo;
+	descriptorWrites[1].descriptorType = vk::DescriptorType::eStorageBuffer;
+	descriptorWrites[1].pBufferInfo = &drawInfo;
+
+	device.updateDescriptorSets({descriptorWrites[0], descriptorWrites[1]}, {});
 }
@@ -1,11 +1,32 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <limits>
 #include <optional>
+#include <unordered_map>
 #include <vulkan/vulkan.hpp>
 #include <GLFW/glfw3.h>
 #include <rendering/window.hpp>
+#include <rendering/camera.hpp>
+#include <rendering/mesher.hpp>
+#include <rendering/visibility.hpp>
+#include <rendering/occlusion.hpp>
+#include <rendering/arena.hpp>
+#include <rendering/resolution.hpp>
+#include <rendering/timeline.hpp>
+#include <rendering/render_graph.hpp>
+#include <rendering/gpu_mesher.hpp>
+#include <rendering/instances.hpp>
+#include <rendering/memory_budget.hpp>
+#include <core/jobs.hpp>
+#include <core/frame_arena.hpp>
+#include <world/world.hpp>
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
+// Frames a debug build lets tick() allocate before asserting that it no
+// longer touches the heap; caches and arenas settle in these.
+const uint64_t ALLOCATION_WARMUP_FRAMES = 120;
 
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
@@ -26,15 +47,169 @@ struct SwapChainSupportDetails {
 	}
 };
 
+// Vertices of every section mesh share one device-local arena buffer;
+// draws index it through vertexOffset with the shared quad index buffer.
+// Allocations are rounded up to whole granules so small edits can be
+// patched in place instead of reallocating.
+const uint32_t MESH_ARENA_VERTICES = 1 << 21;
+const uint32_t MESH_ARENA_GRANULE = 64;
+const uint32_t TRANSLUCENT_ARENA_INDICES = 1 << 20;
+const uint32_t TRANSLUCENT_INDEX_GRANULE = 96;
+const float ARENA_COMPACT_THRESHOLD = 0.5f;
+const uint32_t ARENA_COMPACT_BUDGET = 1 << 16;
+// Quads re-sorted per frame once the camera has moved to another block;
+// the nearest sections are sorted first.
+const uint32_t TRANSLUCENT_SORT_BUDGET = 1 << 16;
+// Per-draw entries each frame ring starts with; it doubles when a frame
+// needs more.
+const uint32_t FRAME_RING_DRAWS = 4096;
+// Host-visible staging memory shared by every upload; it grows when a
+// single upload does not fit.
+const vk::DeviceSize STAGING_RING_SIZE = 16 << 20;
+const vk::DeviceSize STAGING_ALIGNMENT = 16;
+// Indirect draw commands for sections meshed on the GPU, one slot each.
+const uint32_t DRAW_COMMAND_SLOTS = 4096;
+// Entity instances each frame's instance ring starts with; it doubles
+// like the frame ring.
+const uint32_t INSTANCE_RING_INSTANCES = 1024;
+// When the mesh arena would have to grow past the memory budget, at
+// least this share of its capacity is freed by evicting the farthest
+// sections instead.
+const float EVICTION_FRACTION = 0.125f;
+
+// A device-local buffer carved up by an ArenaAllocator. Owners maps each
+// live block to the field holding its offset, so compaction can patch it.
+struct GpuArena {
+	vk::Buffer buffer;
+	vk::DeviceMemory memory;
+	vk::DeviceSize slotSize;
+	vk::BufferUsageFlags usage;
+	ArenaAllocator allocator;
+	std::unordered_map<uint32_t, uint32_t *> owners;
+};
+
+// Per-draw data the vertex shader reads from the frame ring, picked by
+// the drawIndex push constant. Section meshes are built around their
+// own corner; origin.w is unused.
+struct DrawData {
+	glm::vec4 origin;
+};
+
+// Persistently mapped host-visible buffer for data the GPU reads during
+// a single frame: the camera uniform first, then one DrawData per
+// visible section from drawDataOffset on. The frames in flight take
+// turns, each writing its own ring only once its timeline value is reached.
+struct FrameRing {
+	vk::Buffer buffer;
+	vk::DeviceMemory memory;
+	uint8_t *mapped = nullptr;
+	uint32_t draws = 0;
+};
+
+// Persistently mapped per-frame copy of the entity instances, read as
+// the instance-rate vertex binding.
+struct InstanceRing {
+	vk::Buffer buffer;
+	vk::DeviceMemory memory;
+	InstanceData *mapped = nullptr;
+	uint32_t capacity = 0;
+};
+
+// Upload source memory, reused as the timeline passes each upload.
+struct StagingRing {
+	vk::Buffer buffer;
+	vk::DeviceMemory memory;
+	uint8_t *mapped = nullptr;
+	RingAllocator allocator;
+};
+
+// A buffer or one-off command buffer that submitted work may still use,
+// destroyed once the timeline reaches value.
+struct RetiredResource {
+	uint64_t value;
+	vk::Buffer buffer;
+	vk::DeviceMemory memory;
+	vk::CommandBuffer commandBuffer;
+};
+
+// Sections meshed on the GPU are drawn from their slot in the draw
+// command arena, whose index count the compute mesher fills in.
+// commandVertexOffset is the vertex offset last written to that command,
+// which compaction can leave behind.
+struct SectionDraw {
+	uint32_t offset;
+	uint32_t capacity;
+	uint32_t quadCount;
+	bool gpu;
+	uint32_t command;
+	uint32_t commandVertexOffset;
+};
+
+// The CPU mesher's opaque faces for a section the GPU also meshed, and
+// where the GPU's command and quadCount quads were copied in the readback.
+struct MeshCheck {
+	SectionPos pos;
+	vk::DeviceSize offset;
+	uint32_t quadCount;
+	std::vector<Vertex> expected;
+};
+
+// Host-visible copy of one upload's GPU meshes, compared once the
+// timeline reaches value.
+struct MeshValidation {
+	uint64_t value;
+	vk::Buffer buffer;
+	vk::DeviceMemory memory;
+	std::vector<MeshCheck> checks;
+};
+
+// Translucent faces have their own vertex block and a per-section index
+// block holding the current back-to-front order. Quad centres stay on the
+// CPU so the order can be rebuilt when the camera moves.
+struct TranslucentDraw {
+	uint32_t vertexOffset;
+	uint32_t vertexCapacity;
+	uint32_t indexOffset;
+	uint32_t indexCapacity;
+	std::vector<glm::vec3> centers;
+};
+
 class Renderer {
 public:
-	Renderer(Window& window);
+	Renderer(Window& window, JobSystem& jobs);
 	~Renderer();
 
-	vk::Buffer createBuffer(vk::DeviceSize size, vk::BufferUsageFlags flags, vk::MemoryPropertyFlags properties, vk::DeviceMemory& bufferMemory);
+	Camera camera;
+
+	// Device-local requests fall back to host-visible memory when the
+	// device-local heap is over budget or out of memory.
+	vk::Buffer createBuffer(vk::DeviceSize size, vk::BufferUsageFlags flags, vk::MemoryPropertyFlags properties, MemoryCategory category, vk::DeviceMemory& bufferMemory);
+	void destroyBuffer(vk::Buffer buffer, vk::DeviceMemory memory);
+	// Records and submits the copy without waiting for it; end() waits
+	// for everything submitted.
+	void copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size);
+	// Releases buffers and command buffers whose submissions completed.
+	void collectRetired();
 
+	// Renders the scene offscreen at a scale chosen to hold the frame
+	// budget and blits it up to the swapchain. Ignored when the device
+	// cannot blit between the two.
+	void setDynamicResolution(bool enabled);
+	void updateMeshes(const MeshBatch& batch);
+	// Entities drawn by the following ticks, moved on by elapsed seconds
+	// of their velocity. instances must stay alive until replaced.
+	void setEntities(const EntityInstances *instances, float elapsed);
 	void tick(Window& window);
 	void end();
+	// Device memory held by buffers and the render graph's transient
+	// images, and the most it has been.
+	vk::DeviceSize deviceMemoryUsed() const { return budget.used(); }
+	vk::DeviceSize deviceMemoryPeak() const { return budget.live().peak; }
+	const MemoryCounters& memoryCounters() const { return budget.live(); }
+	size_t evictedSections() const { return evicted.size(); }
+	// Evicted sections that fit in memory again since the last call; they
+	// need meshing again to be drawn.
+	void takeRestored(std::vector<SectionPos>& positions);
 private:
 	vk::Instance instance;
 	vk::PhysicalDevice physicalDevice;
@@ -45,29 +220,88 @@ private:
 	vk::SwapchainKHR swapChain;
 	vk::Format swapChainImageFormat;
 	vk::Extent2D swapChainExtent;
-	vk::RenderPass renderPass;
 	vk::DescriptorSetLayout descriptorSetLayout;
 	vk::DescriptorPool descriptorPool;
 	vk::PipelineLayout pipelineLayout;
 	vk::Pipeline graphicsPipeline;
+	vk::Pipeline translucentPipeline;
+	vk::Pipeline entityPipeline;
 	vk::CommandPool commandPool;
-	vk::Buffer vertexBuffer;
-	vk::DeviceMemory vertexBufferMemory;
-	vk::Buffer indexBuffer;
-	vk::DeviceMemory indexBufferMemory;
+	vk::Format depthFormat;
+
+	// Rebuilt with the swapchain and when dynamic resolution is toggled.
+	RenderGraph graph;
+	GraphPass opaquePass;
+	GraphPass entityPass;
+	GraphPass translucentPass;
+	GraphImage swapChainTarget;
+	GraphImage sceneTarget;
+	bool blitSupported = false;
+	bool dynamicResolution = false;
+	ResolutionController resolution;
+	vk::QueryPool timestampPool;
+	float timestampPeriod = 0.0f;
+	uint64_t timestampMask = 0;
+	std::chrono::steady_clock::time_point lastFrame = std::chrono::steady_clock::now();
+	std::array<bool, MAX_FRAMES_IN_FLIGHT> timestampsWritten = {};
+
+	GpuArena meshArena;
+	GpuArena translucentIndices;
+	vk::Buffer quadIndexBuffer;
+	vk::DeviceMemory quadIndexMemory;
+	std::unordered_map<SectionPos, SectionDraw, SectionPosHash> sectionDraws;
+	std::unordered_map<SectionPos, TranslucentDraw, SectionPosHash> translucentDraws;
+	GpuMesher gpuMesher;
+	GpuArena drawCommands;
+	vk::Buffer blockTableBuffer;
+	vk::DeviceMemory blockTableMemory;
+	// Timeline value of the last upload that dispatched the GPU mesher.
+	uint64_t meshDispatchValue = 0;
+	std::vector<MeshValidation> validations;
+	uint64_t validatedSections = 0;
+	std::optional<glm::ivec3> sortCell;
+	std::vector<SectionPos> sortQueue;
+	vk::Buffer entityModelBuffer;
+	vk::DeviceMemory entityModelMemory;
+	std::array<InstanceRing, MAX_FRAMES_IN_FLIGHT> instanceRings;
+	const EntityInstances *entities = nullptr;
+	float entityTime = 0.0f;
+	JobSystem& jobs;
+	VisibilityGraph visibility;
+	OcclusionCuller occlusion;
+	std::unordered_map<SectionPos, Occluder, SectionPosHash> occluders;
+	std::vector<SectionPos> visibleSections;
+	// Scratch for one frame's temporaries, reset once the frame retires.
+	std::array<LinearArena, MAX_FRAMES_IN_FLIGHT> frameArenas;
+	uint64_t frameCount = 0;
 
 	std::vector<vk::CommandBuffer> commandBuffers;
 	std::vector<vk::Image> swapChainImages;
 	std::vector<vk::ImageView> swapChainImageViews;
-	std::vector<vk::Framebuffer> swapChainFramebuffers;
 
 	std::vector<vk::Semaphore> imageAvailableSemaphores;
 	std::vector<vk::Semaphore> renderFinishedSemaphores;
-	std::vector<vk::Fence> inFlightFences;
+	GpuTimeline timeline;
+	// Timeline value of each frame slot's last submission.
+	std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> frameValues = {};
+	StagingRing staging;
+	std::vector<RetiredResource> retired;
+	MemoryBudget budget;
+	bool memoryBudgetSupported = false;
+	// Sections from evictionDistance out are kept out of the mesh arena;
+	// evicted maps each one to the slots its mesh needs, and restoring
+	// does the same for those handed back but not yet remeshed.
+	float evictionDistance = std::numeric_limits<float>::infinity();
+	std::unordered_map<SectionPos, uint32_t, SectionPosHash> evicted;
+	std::unordered_map<SectionPos, uint32_t, SectionPosHash> restoring;
+	std::vector<SectionPos> restored;
+	// Camera position evicted and resident sections were last ranked at,
+	// and the arena room left after.
+	glm::vec3 balancedAt = glm::vec3(0.0f);
+	uint32_t balancedRoom = 0;
 
-	std::vector<vk::Buffer> uniformBuffers;
-	std::vector<vk::DeviceMemory> uniformBuffersMemory;
-	std::vector<uint8_t *> uniformBuffersMapped;
+	std::array<FrameRing, MAX_FRAMES_IN_FLIGHT> frameRings;
+	vk::DeviceSize drawDataOffset = 0;
 
 	std::vector<vk::DescriptorSet> descriptorSets;
 
@@ -91,12 +325,11 @@ private:
 	void createDescriptorPool();
 	void createDescriptorSets();
 	void createGraphicsPipeline();
-	void createRenderPass();
-	void createFramebuffers();
 	void createCommandPool();
-	void createIndexBuffer();
-	void createVertexBuffer();
-	void createUniformBuffers();
+	void buildRenderGraph();
+	void createTimestampQueries();
+	void createMeshBuffers();
+	void createFrameRings();
 	void createCommandBuffers();
 	void createSyncObjects();
 	void recreateSwapChain(Window& window);
@@ -104,7 +337,40 @@ private:
 
 
 	void recordCommandBuffer(vk::CommandBuffer buffer, uint32_t imageIndex);
-	void copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size);
+	void bindSceneState(vk::CommandBuffer buffer);
+	void drawOpaque(vk::CommandBuffer buffer);
+	void drawEntities(vk::CommandBuffer buffer);
+	void drawTranslucent(vk::CommandBuffer buffer);
+	void blitScene(vk::CommandBuffer buffer);
+	vk::CommandBuffer beginSingleTimeCommands();
+	uint64_t endSingleTimeCommands(vk::CommandBuffer commandBuffer);
+	void cullSections();
+	void createStagingRing(vk::DeviceSize size);
+	uint8_t *allocateStaging(vk::DeviceSize size, vk::DeviceSize& offset);
+	void retireBuffer(vk::Buffer buffer, vk::DeviceMemory memory);
+	vk::Extent2D renderExtent() const;
+	void readFrameTime();
+	void createArena(GpuArena& arena, uint32_t capacity, vk::DeviceSize slotSize, vk::BufferUsageFlags usage);
+	void destroyArena(GpuArena& arena);
+	void allocateArena(GpuArena& arena, uint32_t size, uint32_t& offset);
+	void freeArena(GpuArena& arena, uint32_t offset);
+	std::vector<vk::BufferCopy> compactArena(GpuArena& arena);
+	void uploadSections(const std::vector<SectionPos>& positions, const std::vector<SectionMesh>& meshes);
+	bool withinEvictionDistance(SectionPos pos) const;
+	uint32_t evictSection(SectionPos pos);
+	void balanceMemory(const MeshBatch& batch);
+	std::vector<std::pair<float, SectionPos>> residentByDistance() const;
+	void updateEvictionDistance();
+	void createGpuMesher();
+	void checkValidations();
+	void sortTranslucent();
+	void createFrameRing(FrameRing& ring, uint32_t draws);
+	void destroyFrameRing(FrameRing& ring);
+	void reserveFrameRing(uint32_t frame, uint32_t draws);
+	void createInstanceRing(InstanceRing& ring, uint32_t capacity);
+	void destroyInstanceRing(InstanceRing& ring);
+	void reserveInstanceRing(uint32_t frame, uint32_t instances);
+	void writeDescriptorSet(uint32_t frame);
 	void updateUniformBuffer(uint32_t currentImage);
 
 	QueueFamilyIndices findQueueFamilies(vk::PhysicalDevice device);
@@ -113,5 +379,5 @@ private:
 	vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes);
 	vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities, Window& window);
 
-	uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties);
+	vk::Format findDepthFormat();
 };
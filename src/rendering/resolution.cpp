@@ -0,0 +1,35 @@
+#include <rendering/resolution.hpp>
+#include <algorithm>
+#include <cmath>
+
+// Aim a little under the budget so normal jitter does not cross it.
+const float TARGET_FRACTION = 0.9f;
+const float MAX_SHRINK = 0.8f;
+const float MAX_GROWTH = 1.05f;
+const float MIN_CHANGE = 0.02f;
+
+ResolutionController::ResolutionController(float budgetMs) : budget(budgetMs) {}
+
+bool ResolutionController::addSample(float frameMs) {
+	total += frameMs;
+	if (++samples < RESOLUTION_SAMPLE_FRAMES) return false;
+
+	float average = total / samples;
+	total = 0.0f;
+	samples = 0;
+	if (average <= 0.0f) return false;
+
+	float ratio = std::sqrt(budget * TARGET_FRACTION / average);
+	float next = std::clamp(current * std::clamp(ratio, MAX_SHRINK, MAX_GROWTH), MIN_RENDER_SCALE, 1.0f);
+	if (std::fabs(next - current) < MIN_CHANGE && next != 1.0f && next != MIN_RENDER_SCALE) return false;
+	if (next == current) return false;
+
+	current = next;
+	return true;
+}
+
+void ResolutionController::reset() {
+	current = 1.0f;
+	total = 0.0f;
+	samples = 0;
+}
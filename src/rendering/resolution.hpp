@@ -0,0 +1,25 @@
+#pragma once
+
+const float MIN_RENDER_SCALE = 0.5f;
+const float DEFAULT_FRAME_BUDGET_MS = 1000.0f / 60.0f;
+const int RESOLUTION_SAMPLE_FRAMES = 8;
+
+// Picks the fraction of the swapchain resolution the scene is rendered at
+// so GPU frame time stays under a budget. Frame times are averaged over a
+// few frames before each adjustment so a single slow frame does not make
+// the image pump; since cost follows pixel count, the scale moves by the
+// square root of the time ratio, shrinking quickly and growing slowly.
+class ResolutionController {
+public:
+	ResolutionController(float budgetMs = DEFAULT_FRAME_BUDGET_MS);
+
+	// Returns true when the scale changed.
+	bool addSample(float frameMs);
+	float scale() const { return current; }
+	void reset();
+private:
+	float budget;
+	float current = 1.0f;
+	float total = 0.0f;
+	int samples = 0;
+};
@@ -0,0 +1,80 @@
+#include <rendering/timeline.hpp>
+
+void GpuTimeline::create(vk::Device device) {
+	this->device = device;
+
+	vk::SemaphoreTypeCreateInfo typeInfo(vk::SemaphoreType::eTimeline, 0);
+	vk::SemaphoreCreateInfo semaphoreInfo;
+	semaphoreInfo.pNext = &typeInfo;
+	semaphore = device.createSemaphore(semaphoreInfo);
+}
+
+void GpuTimeline::destroy() {
+	device.destroySemaphore(semaphore);
+}
+
+uint64_t GpuTimeline::submit(vk::Queue queue, const TimelineSubmit& info) {
+	uint64_t value = last + 1;
+
+	vk::Semaphore waits[2];
+	vk::PipelineStageFlags waitStages[2];
+	uint64_t waitValues[2];
+	uint32_t waitCount = 0;
+
+	if (info.waitBinary) {
+		waits[waitCount] = info.waitBinary;
+		waitStages[waitCount] = info.binaryStage;
+		waitValues[waitCount++] = 0;
+	}
+	if (info.waitValue > reached) {
+		waits[waitCount] = semaphore;
+		waitStages[waitCount] = info.waitStage;
+		waitValues[waitCount++] = info.waitValue;
+	}
+
+	vk::Semaphore signals[2] = {semaphore, info.signalBinary};
+	uint64_t signalValues[2] = {value, 0};
+	uint32_t signalCount = info.signalBinary ? 2 : 1;
+
+	vk::TimelineSemaphoreSubmitInfo timelineInfo;
+	timelineInfo.waitSemaphoreValueCount = waitCount;
+	timelineInfo.pWaitSemaphoreValues = waitValues;
+	timelineInfo.signalSemaphoreValueCount = signalCount;
+	timelineInfo.pSignalSemaphoreValues = signalValues;
+
+	vk::SubmitInfo submitInfo;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = waitCount;
+	submitInfo.pWaitSemaphores = waits;
+	submitInfo.pWaitDstStageMask = waitStages;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &info.commandBuffer;
+	submitInfo.signalSemaphoreCount = signalCount;
+	submitInfo.pSignalSemaphores = signals;
+
+	queue.submit(submitInfo, nullptr);
+	last = value;
+	return value;
+}
+
+uint64_t GpuTimeline::completed() {
+	if (reached < last) reached = device.getSemaphoreCounterValue(semaphore);
+	return reached;
+}
+
+bool GpuTimeline::isComplete(uint64_t value) {
+	return value <= reached || value <= completed();
+}
+
+void GpuTimeline::wait(uint64_t value) {
+	if (isComplete(value)) return;
+
+	vk::SemaphoreWaitInfo waitInfo;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &semaphore;
+	waitInfo.pValues = &value;
+	if (device.waitSemaphores(waitInfo, UINT64_MAX) != vk::Result::eSuccess) {
+		throw std::runtime_error("failed to wait for the GPU timeline!");
+	}
+	reached = value;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+
+// What a single submission waits on and signals besides the timeline.
+// Binary semaphores are only for the swapchain, which cannot use timeline
+// ones; a waitValue of 0 means no timeline wait.
+struct TimelineSubmit {
+	vk::CommandBuffer commandBuffer;
+	uint64_t waitValue = 0;
+	vk::PipelineStageFlags waitStage;
+	vk::Semaphore waitBinary;
+	vk::PipelineStageFlags binaryStage;
+	vk::Semaphore signalBinary;
+};
+
+// One timeline semaphore counting every submission on every queue. Each
+// submit signals the next value when its work completes, so anything the
+// work used (staging memory, retired buffers, command buffers, a frame's
+// slot in a ring) can be reused once completed() reaches that value, and
+// work on another queue can wait for it on the GPU instead of the CPU.
+// Only the render thread submits.
+class GpuTimeline {
+public:
+	void create(vk::Device device);
+	void destroy();
+
+	uint64_t submit(vk::Queue queue, const TimelineSubmit& info);
+
+	// Value of the most recent submission; work recorded now will finish
+	// no earlier than it.
+	uint64_t submitted() const { return last; }
+	uint64_t completed();
+	bool isComplete(uint64_t value);
+	void wait(uint64_t value);
+private:
+	vk::Device device;
+	vk::Semaphore semaphore;
+	uint64_t last = 0;
+	uint64_t reached = 0;
+};
@@ -0,0 +1,40 @@
+#include <rendering/translucency.hpp>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+void sortTranslucentQuads(const glm::vec3 *centers, uint32_t count, glm::vec3 eye, uint32_t *keys, uint32_t *scratch, uint16_t *indices) {
+	// Inverted so ascending keys put the farthest quad first.
+	for (uint32_t i = 0; i < count; i++) {
+		glm::vec3 d = centers[i] - eye;
+		float distance = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z) * SORT_KEY_SCALE;
+		uint32_t quantized = static_cast<uint32_t>(std::min(distance, 65535.0f));
+		keys[i] = ((65535 - quantized) << 16) | i;
+	}
+
+	for (int shift = 16; shift < 32; shift += 8) {
+		uint32_t counts[256] = {};
+		for (uint32_t i = 0; i < count; i++) counts[(keys[i] >> shift) & 0xFF]++;
+
+		uint32_t total = 0;
+		for (uint32_t& bucket : counts) {
+			uint32_t size = bucket;
+			bucket = total;
+			total += size;
+		}
+
+		for (uint32_t i = 0; i < count; i++) scratch[counts[(keys[i] >> shift) & 0xFF]++] = keys[i];
+		std::swap(keys, scratch);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint16_t base = static_cast<uint16_t>((keys[i] & 0xFFFF) * 4);
+		uint16_t *out = indices + i * 6;
+		out[0] = base;
+		out[1] = base + 1;
+		out[2] = base + 2;
+		out[3] = base + 2;
+		out[4] = base + 3;
+		out[5] = base;
+	}
+}
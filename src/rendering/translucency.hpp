@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+// Distances are quantized to 1/64 block, so 16-bit keys cover 1024 blocks.
+const float SORT_KEY_SCALE = 64.0f;
+
+// Orders a section's translucent quads back to front from eye and writes
+// six indices per quad into indices. The sort is a two-pass LSD radix
+// sort over 16-bit quantized centroid distances, with the quad number
+// packed into the low half of each key; keys and scratch must hold count
+// entries.
+void sortTranslucentQuads(const glm::vec3 *centers, uint32_t count, glm::vec3 eye, uint32_t *keys, uint32_t *scratch, uint16_t *indices);
@@ -0,0 +1,110 @@
+#include <rendering/visibility.hpp>
+#include <algorithm>
+#include <cmath>
+
+const int VIEW_GRID = MAX_VIEW_DISTANCE * 2 + 1;
+
+static const int DIRECTIONS[6][3] = {
+	{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+};
+
+struct VisitNode {
+	SectionPos pos;
+	// Face the walk entered through, or -1 for the camera's section.
+	int from;
+	// Directions moved in so far.
+	uint8_t directions;
+};
+
+void VisibilityGraph::set(SectionPos pos, FaceConnectivity connectivity) {
+	auto it = columns.find({pos.x, pos.z});
+	if (it == columns.end()) {
+		it = columns.emplace(ChunkPos{pos.x, pos.z}, std::array<FaceConnectivity, SECTIONS_PER_CHUNK>()).first;
+		it->second.fill(ALL_FACES_CONNECTED);
+	}
+	it->second[pos.y] = connectivity;
+}
+
+void VisibilityGraph::removeColumn(ChunkPos pos) {
+	columns.erase(pos);
+}
+
+// With the camera's own column not loaded yet, as right after a teleport,
+// the walk starts from the nearest loaded column at the camera's height
+// instead of drawing nothing.
+bool VisibilityGraph::nearestColumn(SectionPos camera, SectionPos& nearest) const {
+	int best = MAX_VIEW_DISTANCE * MAX_VIEW_DISTANCE * 2 + 1;
+	for (const auto& [pos, column] : columns) {
+		int dx = pos.x - camera.x;
+		int dz = pos.z - camera.z;
+		if (std::abs(dx) > MAX_VIEW_DISTANCE || std::abs(dz) > MAX_VIEW_DISTANCE) continue;
+
+		int distance = dx * dx + dz * dz;
+		if (distance < best || (distance == best && (pos.x < nearest.x || (pos.x == nearest.x && pos.z < nearest.z)))) {
+			best = distance;
+			nearest = {pos.x, camera.y, pos.z};
+		}
+	}
+	return best <= MAX_VIEW_DISTANCE * MAX_VIEW_DISTANCE * 2;
+}
+
+void VisibilityGraph::collect(glm::vec3 camera, const Frustum& frustum, std::vector<SectionPos>& visible, LinearArena& scratch) {
+	visible.clear();
+
+	SectionPos start = {
+		static_cast<int32_t>(std::floor(camera.x)) >> 4,
+		static_cast<int32_t>(std::floor(camera.y)) >> 4,
+		static_cast<int32_t>(std::floor(camera.z)) >> 4
+	};
+	start.y = std::clamp(start.y, 0, SECTIONS_PER_CHUNK - 1);
+
+	visited.assign(VIEW_GRID * VIEW_GRID * SECTIONS_PER_CHUNK, 0);
+	auto visit = [&](SectionPos pos) {
+		int gx = pos.x - start.x + MAX_VIEW_DISTANCE;
+		int gz = pos.z - start.z + MAX_VIEW_DISTANCE;
+		if (gx < 0 || gz < 0 || gx >= VIEW_GRID || gz >= VIEW_GRID) return false;
+
+		uint8_t& seen = visited[(gz * VIEW_GRID + gx) * SECTIONS_PER_CHUNK + pos.y];
+		if (seen) return false;
+		seen = 1;
+		return true;
+	};
+
+	FrameVector<VisitNode> queue{FrameAllocator<VisitNode>(scratch)};
+	queue.reserve(visited.size() / 4);
+	SectionPos seed = start;
+	if (!columns.count({start.x, start.z}) && !nearestColumn(start, seed)) return;
+	queue.push_back({seed, -1, 0});
+	visit(seed);
+
+	// Column lookups are cached since the walk moves vertically a lot.
+	ChunkPos cachedPos = {seed.x, seed.z};
+	auto cachedColumn = columns.find(cachedPos);
+
+	for (size_t head = 0; head < queue.size(); head++) {
+		VisitNode node = queue[head];
+
+		if (node.pos.x != cachedPos.x || node.pos.z != cachedPos.z) {
+			cachedPos = {node.pos.x, node.pos.z};
+			cachedColumn = columns.find(cachedPos);
+		}
+		if (cachedColumn == columns.end()) continue;
+
+		visible.push_back(node.pos);
+		FaceConnectivity connectivity = cachedColumn->second[node.pos.y];
+
+		for (int face = 0; face < 6; face++) {
+			if (node.directions & (1 << (face ^ 1))) continue;
+			if (node.from >= 0 && !connects(connectivity, node.from, face)) continue;
+
+			SectionPos next = {node.pos.x + DIRECTIONS[face][0], node.pos.y + DIRECTIONS[face][1], node.pos.z + DIRECTIONS[face][2]};
+			if (next.y < 0 || next.y >= SECTIONS_PER_CHUNK) continue;
+
+			glm::vec3 min(next.x * SECTION_SIZE, next.y * SECTION_SIZE, next.z * SECTION_SIZE);
+			if (!frustum.intersects(min, min + glm::vec3(SECTION_SIZE))) continue;
+			if (!visit(next)) continue;
+
+			queue.push_back({next, face ^ 1, static_cast<uint8_t>(node.directions | (1 << face))});
+		}
+	}
+}
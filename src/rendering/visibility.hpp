@@ -0,0 +1,32 @@
+#pragma once
+
+#include <rendering/camera.hpp>
+#include <rendering/mesher.hpp>
+#include <core/frame_arena.hpp>
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+// Farthest section column, in chunks from the camera, that the
+// traversal visits.
+const int MAX_VIEW_DISTANCE = 32;
+
+// Face connectivity of every section of the loaded chunk columns, walked
+// outwards from the camera to find the sections that can be seen through
+// open space. A section is only entered through a face connected to the
+// one the walk came in by, and the walk never turns back towards the
+// camera along an axis it has already moved away on, so caves behind
+// solid rock are never reached.
+class VisibilityGraph {
+public:
+	void set(SectionPos pos, FaceConnectivity connectivity);
+	void removeColumn(ChunkPos pos);
+
+	// The walk's queue lives in scratch.
+	void collect(glm::vec3 camera, const Frustum& frustum, std::vector<SectionPos>& visible, LinearArena& scratch);
+private:
+	std::unordered_map<ChunkPos, std::array<FaceConnectivity, SECTIONS_PER_CHUNK>, ChunkPosHash> columns;
+	std::vector<uint8_t> visited;
+
+	bool nearestColumn(SectionPos camera, SectionPos& nearest) const;
+};
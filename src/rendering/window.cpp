@@ -1,18 +1,35 @@
 #include <rendering/window.hpp>
 
-static void framebufferResizeCallback(GLFWwindow* raw, int width, int height) {
+void framebufferResizeCallback(GLFWwindow* raw, int width, int height) {
 	auto window = reinterpret_cast<Window*>(glfwGetWindowUserPointer(raw));
+	window->setSize(width, height);
     window->framebufferResized = true;
 }
 
-Window::Window(std::string title, uint32_t width, uint32_t height) {
+// Events that do not fit are dropped rather than stalling the event loop.
+static void keyCallback(GLFWwindow* raw, int key, int scancode, int action, int mods) {
+	auto window = reinterpret_cast<Window*>(glfwGetWindowUserPointer(raw));
+	window->input.push(InputEvent{InputType::Key, key, action});
+}
+
+Window::Window(std::string title, uint32_t width, uint32_t height, bool visible) {
 	glfwInit();
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
 	raw = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
 	glfwSetWindowUserPointer(raw, this);
 	glfwSetFramebufferSizeCallback(raw, framebufferResizeCallback);
+	glfwSetKeyCallback(raw, keyCallback);
 	framebufferResized = false;
+
+	int framebufferWidth, framebufferHeight;
+	glfwGetFramebufferSize(raw, &framebufferWidth, &framebufferHeight);
+	setSize(framebufferWidth, framebufferHeight);
+}
+
+void Window::setSize(int width, int height) {
+	size = (static_cast<uint64_t>(static_cast<uint32_t>(width)) << 32) | static_cast<uint32_t>(height);
 }
 
 Window::~Window() {
@@ -28,6 +45,10 @@ void Window::tick() {
 	glfwPollEvents();
 }
 
+void Window::waitEvents(double timeout) {
+	glfwWaitEventsTimeout(timeout);
+}
+
 vk::SurfaceKHR Window::createSurface(vk::Instance instance) {
 	VkSurfaceKHR surface;
 	if (glfwCreateWindowSurface(instance, raw, nullptr, &surface) != VK_SUCCESS) {
@@ -37,9 +58,8 @@ vk::SurfaceKHR Window::createSurface(vk::Instance instance) {
 	return surface;
 }
 
+// Cached from the resize callback so the render thread can ask too.
 vk::Extent2D Window::framebufferSize() {
-	int width, height;
-	glfwGetFramebufferSize(raw, &width, &height);
-
-	return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+	uint64_t packed = size.load();
+	return {static_cast<uint32_t>(packed >> 32), static_cast<uint32_t>(packed)};
 }
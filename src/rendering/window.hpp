@@ -2,18 +2,46 @@
 
 #include <vulkan/vulkan.hpp>
 #include <GLFW/glfw3.h>
+#include <core/spsc_queue.hpp>
+#include <atomic>
 
+const size_t INPUT_QUEUE_SIZE = 256;
+
+enum class InputType : uint8_t {
+	Key
+};
+
+struct InputEvent {
+	InputType type;
+	int key;
+	int action;
+};
+
+// GLFW calls must stay on the main thread; everything other threads need
+// is either cached here or forwarded through the input queue.
 class Window {
 public:
-	Window(std::string title, uint32_t width, uint32_t height);
+	// Hidden windows still get a swapchain, for unattended runs.
+	Window(std::string title, uint32_t width, uint32_t height, bool visible = true);
 	~Window();
 
-	bool framebufferResized;
+	std::atomic<bool> framebufferResized;
+	// Filled by GLFW callbacks during tick, drained by the simulation.
+	SpscQueue<InputEvent, INPUT_QUEUE_SIZE> input;
 
 	vk::Extent2D framebufferSize();
 	bool shouldClose();
 	void tick();
+	// Like tick, but sleeps until an event arrives or timeout seconds pass.
+	void waitEvents(double timeout);
 	vk::SurfaceKHR createSurface(vk::Instance instance);
 private:
 	GLFWwindow *raw = nullptr;
+	// Width in the high half, height in the low one, so the render thread
+	// never sees the width of one resize with the height of another.
+	std::atomic<uint64_t> size;
+
+	void setSize(int width, int height);
+
+	friend void framebufferResizeCallback(GLFWwindow *raw, int width, int height);
 };
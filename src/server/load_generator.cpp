@@ -0,0 +1,185 @@
+#include <server/load_generator.hpp>
+#include <net/client.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+// Blocks per second, about a sprinting player.
+const float WALK_SPEED = 8.0f;
+// Most a walker's heading changes per tick, in radians.
+const float WANDER = 0.05f;
+// Edits land within this many blocks of the walker.
+const int EDIT_REACH = 24;
+
+struct SimulatedClient {
+	std::unique_ptr<ChunkClient> client;
+	World world;
+	std::mt19937 random;
+	float x = 0.0f;
+	float z = 0.0f;
+	float heading = 0.0f;
+	std::optional<double> fullView;
+	bool connected = true;
+};
+
+static bool viewComplete(const World& world, ChunkPos center, int radius) {
+	for (int x = -radius; x <= radius; x++) {
+		for (int z = -radius; z <= radius; z++) {
+			if (!world.getChunk({center.x + x, center.z + z})) return false;
+		}
+	}
+	return true;
+}
+
+static void step(SimulatedClient& sim, const LoadOptions& options, double elapsedMilliseconds, float dt) {
+	int blockX = static_cast<int>(std::floor(sim.x));
+	int blockZ = static_cast<int>(std::floor(sim.z));
+	ChunkPos center = chunkOf(blockX, blockZ);
+
+	try {
+		sim.connected = sim.client->update(sim.world, center);
+	} catch (std::exception &) {
+		sim.connected = false;
+	}
+	if (!sim.connected) return;
+
+	// Only the receiver's bookkeeping matters here; nothing is meshed.
+	sim.world.takeDirtySections();
+	sim.world.takeUnlitChunks();
+	sim.world.takeLightEdits();
+	sim.world.takeBlockEdits();
+
+	if (!sim.fullView) {
+		if (viewComplete(sim.world, center, options.viewRadius)) sim.fullView = elapsedMilliseconds;
+		return;
+	}
+
+	std::uniform_real_distribution<float> turn(-WANDER, WANDER);
+	sim.heading += turn(sim.random);
+	sim.x += std::cos(sim.heading) * WALK_SPEED * dt;
+	sim.z += std::sin(sim.heading) * WALK_SPEED * dt;
+
+	std::uniform_int_distribution<int> offset(-EDIT_REACH, EDIT_REACH);
+	std::uniform_int_distribution<int> height(0, CHUNK_HEIGHT - 1);
+	std::uniform_int_distribution<int> block(0, CORE_BLOCK_COUNT - 1);
+	for (size_t i = 0; i < options.editsPerTick; i++) {
+		sim.client->setBlock(blockX + offset(sim.random), height(sim.random), blockZ + offset(sim.random), static_cast<BlockId>(block(sim.random)));
+	}
+}
+
+LoadReport runLoad(const LoadOptions& options, JobSystem& jobs) {
+	LoadReport report;
+	report.options = options;
+
+	// Spread out so clients share some chunks but not all of them.
+	std::vector<std::unique_ptr<SimulatedClient>> clients;
+	for (size_t i = 0; i < options.clients; i++) {
+		auto sim = std::make_unique<SimulatedClient>();
+		sim->random.seed(static_cast<uint32_t>(i));
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		std::uniform_real_distribution<float> spread(-256.0f, 256.0f);
+		sim->heading = angle(sim->random);
+		sim->x = spread(sim->random);
+		sim->z = spread(sim->random);
+		sim->client = std::make_unique<ChunkClient>(options.address, options.viewRadius);
+		clients.push_back(std::move(sim));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.seconds));
+	auto nextTick = start;
+	float dt = static_cast<float>(TICK_LENGTH.count());
+
+	while (std::chrono::steady_clock::now() < end) {
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		jobs.parallelFor(clients.size(), [&](size_t i) {
+			if (clients[i]->connected) step(*clients[i], options, elapsed, dt);
+		});
+
+		nextTick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(TICK_LENGTH);
+		std::this_thread::sleep_until(nextTick);
+	}
+	report.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (const auto& sim : clients) {
+		const ClientStats& stats = sim->client->stats();
+		report.chunks += stats.chunks;
+		report.sections += stats.sections;
+		report.blockChanges += stats.blockChanges;
+		report.unloads += stats.unloads;
+		report.messages += stats.messages;
+		report.bytesReceived += sim->client->connection().bytesReceived();
+		if (!sim->connected) report.disconnected++;
+		if (sim->fullView) report.fullViewMilliseconds.push_back(*sim->fullView);
+	}
+	return report;
+}
+
+void writeLoadReport(const std::filesystem::path& path, const LoadReport& report, const ServerStats *server) {
+	std::vector<double> fullView = report.fullViewMilliseconds;
+	std::sort(fullView.begin(), fullView.end());
+	double fullViewTotal = 0.0;
+	for (double value : fullView) fullViewTotal += value;
+
+	double seconds = std::max(report.elapsedSeconds, 1e-9);
+
+	std::ostringstream json;
+	json << std::setprecision(6);
+	json << "{\n";
+	json << "  \"clients\": " << report.options.clients << ",\n";
+	json << "  \"seconds\": " << report.elapsedSeconds << ",\n";
+	json << "  \"view_radius\": " << static_cast<int>(report.options.viewRadius) << ",\n";
+	json << "  \"edits_per_tick\": " << report.options.editsPerTick << ",\n";
+	json << "  \"chunks\": " << report.chunks << ",\n";
+	json << "  \"sections\": " << report.sections << ",\n";
+	json << "  \"block_changes\": " << report.blockChanges << ",\n";
+	json << "  \"unloads\": " << report.unloads << ",\n";
+	json << "  \"messages\": " << report.messages << ",\n";
+	json << "  \"bytes_received\": " << report.bytesReceived << ",\n";
+	json << "  \"receive_mib_per_second\": " << report.bytesReceived / seconds / (1024.0 * 1024.0) << ",\n";
+	json << "  \"disconnected\": " << report.disconnected << ",\n";
+	json << "  \"full_view_clients\": " << fullView.size() << ",\n";
+	json << "  \"full_view_ms\": {";
+	if (!fullView.empty()) {
+		json << "\"mean\": " << fullViewTotal / fullView.size();
+		json << ", \"p50\": " << fullView[fullView.size() / 2];
+		json << ", \"max\": " << fullView.back();
+	}
+	json << "}";
+	if (server) {
+		json << ",\n  \"server\": {";
+		json << "\"ticks\": " << server->ticks;
+		json << ", \"average_tick_ms\": " << (server->ticks > 0 ? server->totalTickMilliseconds / server->ticks : 0.0);
+		json << ", \"max_tick_ms\": " << server->maxTickMilliseconds;
+		json << ", \"chunks_loaded\": " << server->chunksLoaded;
+		json << ", \"chunks_generated\": " << server->chunksGenerated;
+		json << ", \"chunks_sent\": " << server->chunksSent;
+		json << ", \"block_changes\": " << server->blockChanges;
+		json << ", \"scheduled_updates\": " << server->scheduledUpdates;
+		json << ", \"random_ticks\": " << server->randomTicks;
+		json << ", \"max_region_tick_ms\": " << server->maxRegionTickMilliseconds;
+		json << ", \"bytes_sent\": " << server->bytesSent;
+		json << ", \"hot_chunks\": " << server->cold.hotChunks;
+		json << ", \"hot_bytes\": " << server->cold.hotBytes;
+		json << ", \"cold_chunks\": " << server->cold.coldChunks;
+		json << ", \"cold_bytes\": " << server->cold.coldBytes;
+		json << ", \"freezes\": " << server->cold.freezes;
+		json << ", \"thaws\": " << server->cold.thaws;
+		json << ", \"thaw_ms\": " << server->cold.thawMilliseconds;
+		json << "}";
+	}
+	json << "\n}\n";
+
+	std::ofstream out(path);
+	if (!out.is_open()) throw std::runtime_error("failed to write " + path.string());
+	out << json.str();
+}
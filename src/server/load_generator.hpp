@@ -0,0 +1,43 @@
+#pragma once
+
+#include <core/jobs.hpp>
+#include <server/server.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct LoadOptions {
+	std::string address;
+	size_t clients = 32;
+	double seconds = 30.0;
+	uint8_t viewRadius = 8;
+	// Random block edits each client sends per tick near itself.
+	size_t editsPerTick = 1;
+};
+
+struct LoadReport {
+	LoadOptions options;
+	uint64_t chunks = 0;
+	uint64_t sections = 0;
+	uint64_t blockChanges = 0;
+	uint64_t unloads = 0;
+	uint64_t messages = 0;
+	uint64_t bytesReceived = 0;
+	uint64_t disconnected = 0;
+	double elapsedSeconds = 0.0;
+	// Time from connecting until every chunk in view had arrived, for
+	// each client that got there.
+	std::vector<double> fullViewMilliseconds;
+};
+
+// Connects a number of simulated players to a server. Each has its own
+// copy of the world fed by a ChunkReceiver; it waits for its view to fill,
+// then walks in a wandering line while sending random edits, so the
+// server streams chunks in and out and broadcasts changes the whole run.
+// Clients are updated in parallel on the job system at the server's tick
+// rate. Throws std::runtime_error if a client cannot connect.
+LoadReport runLoad(const LoadOptions& options, JobSystem& jobs);
+
+// Server stats are included when the server ran in the same process.
+void writeLoadReport(const std::filesystem::path& path, const LoadReport& report, const ServerStats *server);
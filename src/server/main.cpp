@@ -0,0 +1,184 @@
+#include <assets/file.hpp>
+#include <core/jobs.hpp>
+#include <server/load_generator.hpp>
+#include <server/server.hpp>
+#include <world/blocks.hpp>
+#include <world/generator.hpp>
+#include <world/region.hpp>
+#include <world/saver.hpp>
+#include <world/world.hpp>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+const auto AUTOSAVE_INTERVAL = std::chrono::minutes(5);
+const auto STATS_INTERVAL = std::chrono::seconds(10);
+const int MAX_TICK_BACKLOG = 5;
+
+static std::atomic<bool> running{true};
+
+static void stop(int) {
+	running = false;
+}
+
+// Ticks the server until stopped, saving every AUTOSAVE_INTERVAL and once
+// more on the way out. In between, idle chunks the compactor wants to
+// compress are saved early, so the hot budget holds for new terrain too.
+static void serve(ChunkServer& server, World& world, WorldSaver& saver, bool log) {
+	auto nextTick = std::chrono::steady_clock::now();
+	auto lastSave = nextTick;
+	auto lastStats = nextTick;
+	ServerStats reported;
+	std::unordered_set<ChunkPos, ChunkPosHash> saveBacklog;
+
+	while (running) {
+		server.tick();
+
+		auto now = std::chrono::steady_clock::now();
+		// Requests wait here while a save is still running, rather than
+		// being dropped until the compactor asks again.
+		for (ChunkPos pos : server.takeSaveRequests()) saveBacklog.insert(pos);
+		if (now - lastSave >= AUTOSAVE_INTERVAL && saver.snapshot(world)) {
+			// The snapshot took every unsaved chunk, requested or not.
+			lastSave = now;
+			saveBacklog.clear();
+		} else if (!saveBacklog.empty() && !saver.busy()) {
+			saver.save(world, std::vector<ChunkPos>(saveBacklog.begin(), saveBacklog.end()));
+			saveBacklog.clear();
+		}
+
+		if (log && now - lastStats >= STATS_INTERVAL) {
+			const ServerStats& stats = server.stats();
+			uint64_t ticks = stats.ticks - reported.ticks;
+			double tickMilliseconds = stats.totalTickMilliseconds - reported.totalTickMilliseconds;
+			std::cout << server.clientCount() << " clients, "
+				<< (ticks > 0 ? tickMilliseconds / ticks : 0.0) << " ms/tick, "
+				<< stats.chunksSent - reported.chunksSent << " chunks and "
+				<< stats.blockChanges - reported.blockChanges << " edits sent, "
+				<< (stats.bytesSent - reported.bytesSent) / (1024 * 1024) << " MiB, "
+				<< stats.scheduledUpdates - reported.scheduledUpdates << " block updates, "
+				<< stats.cold.hotChunks << " hot chunks (" << stats.cold.hotBytes / (1024 * 1024) << " MiB), "
+				<< stats.cold.coldChunks << " cold (" << stats.cold.coldBytes / (1024 * 1024) << " MiB), "
+				<< stats.cold.thaws - reported.cold.thaws << " thawed" << std::endl;
+			// Regions of the latest tick only, to spot where the work is.
+			const RegionTickStats *slowest = nullptr;
+			for (const RegionTickStats& region : server.regionStats()) {
+				if (!slowest || region.milliseconds > slowest->milliseconds) slowest = &region;
+			}
+			if (slowest) {
+				std::cout << "slowest tick region (" << slowest->region.x << ", " << slowest->region.z << "): "
+					<< slowest->milliseconds << " ms, " << slowest->scheduledUpdates << " updates, "
+					<< slowest->randomTicks << " random ticks" << std::endl;
+			}
+			reported = stats;
+			lastStats = now;
+		}
+
+		nextTick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(TICK_LENGTH);
+		if (now - nextTick > TICK_LENGTH * MAX_TICK_BACKLOG) nextTick = now;
+		std::this_thread::sleep_until(nextTick);
+	}
+	saver.flush(world);
+}
+
+int main(int argc, char **argv)
+{
+	std::string address = "game_server.sock";
+	std::string worldName = "world";
+	uint64_t seed = WORLD_SEED;
+	std::string loadOutput = "load.json";
+	std::string connectAddress;
+	size_t hotBudget = DEFAULT_HOT_BUDGET;
+	uint32_t coldAfter = DEFAULT_COLD_AFTER;
+	LoadOptions load;
+	load.clients = 0;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		// "host:port" for TCP, otherwise a UNIX socket path.
+		if (arg == "--listen" && i + 1 < argc) address = argv[++i];
+		if (arg == "--world" && i + 1 < argc) worldName = argv[++i];
+		if (arg == "--seed" && i + 1 < argc) seed = std::stoull(argv[++i]);
+		// Memory for uncompressed chunks in MiB, and how long a chunk goes
+		// unused before it may be compressed.
+		if (arg == "--hot-budget" && i + 1 < argc) hotBudget = std::stoull(argv[++i]) << 20;
+		if (arg == "--cold-after" && i + 1 < argc) coldAfter = static_cast<uint32_t>(std::stod(argv[++i]) / TICK_LENGTH.count());
+		// Load test mode: runs that many simulated clients against the
+		// server at --connect, or against one started in this process on a
+		// scratch world, then writes a report.
+		if (arg == "--load" && i + 1 < argc) load.clients = std::stoul(argv[++i]);
+		if (arg == "--connect" && i + 1 < argc) connectAddress = argv[++i];
+		if (arg == "--seconds" && i + 1 < argc) load.seconds = std::stod(argv[++i]);
+		if (arg == "--radius" && i + 1 < argc) load.viewRadius = static_cast<uint8_t>(std::min(std::stoul(argv[++i]), static_cast<unsigned long>(MAX_VIEW_RADIUS)));
+		if (arg == "--edits" && i + 1 < argc) load.editsPerTick = std::stoul(argv[++i]);
+		if (arg == "--load-output" && i + 1 < argc) loadOutput = argv[++i];
+	}
+
+	std::signal(SIGINT, stop);
+	std::signal(SIGTERM, stop);
+
+	// Mods register their blocks before this; ids are fixed from here on.
+	freezeBlocks();
+
+	JobSystem jobs;
+
+	try {
+		if (load.clients > 0) {
+			if (!connectAddress.empty()) {
+				load.address = connectAddress;
+				writeLoadReport(loadOutput, runLoad(load, jobs), nullptr);
+			} else {
+				// Generated from the seed every time; nothing is kept.
+				std::filesystem::path worldPath = getWorldPath("load_test");
+				std::filesystem::remove_all(worldPath);
+
+				ServerStats stats;
+				LoadReport report;
+				{
+					World world;
+					RegionStorage storage(worldPath);
+					WorldSaver saver(storage, jobs);
+					TerrainGenerator generator(seed);
+					ChunkServer server(address, world, storage, generator, jobs, seed);
+					server.setColdStorage(hotBudget, coldAfter);
+					std::thread serving(serve, std::ref(server), std::ref(world), std::ref(saver), false);
+
+					load.address = address;
+					try {
+						report = runLoad(load, jobs);
+					} catch (...) {
+						running = false;
+						serving.join();
+						throw;
+					}
+					running = false;
+					serving.join();
+					stats = server.stats();
+				}
+				std::filesystem::remove_all(worldPath);
+				writeLoadReport(loadOutput, report, &stats);
+			}
+			std::cout << "wrote " << loadOutput << std::endl;
+			return 0;
+		}
+
+		World world;
+		RegionStorage storage(getWorldPath(worldName));
+		WorldSaver saver(storage, jobs);
+		TerrainGenerator generator(seed);
+		ChunkServer server(address, world, storage, generator, jobs, seed);
+		server.setColdStorage(hotBudget, coldAfter);
+		std::cout << "listening on " << address << std::endl;
+		serve(server, world, saver, true);
+	} catch (std::exception & err) {
+		std::cout << "std::exception: " << err.what() << std::endl;
+		exit(-1);
+	}
+
+	return 0;
+}
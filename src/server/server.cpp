@@ -0,0 +1,237 @@
+#include <server/server.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+// Calls fn for every chunk within radius of center, in square rings
+// from the centre out, with the ring's distance.
+template <typename F>
+static void forEachInView(ChunkPos center, int radius, F fn) {
+	fn(center, 0);
+	for (int d = 1; d <= radius; d++) {
+		for (int i = -d; i < d; i++) {
+			fn(ChunkPos{center.x + i, center.z - d}, d);
+			fn(ChunkPos{center.x + d, center.z + i}, d);
+			fn(ChunkPos{center.x - i, center.z + d}, d);
+			fn(ChunkPos{center.x - d, center.z - i}, d);
+		}
+	}
+}
+
+static int chunkDistance(ChunkPos a, ChunkPos b) {
+	return std::max(std::abs(a.x - b.x), std::abs(a.z - b.z));
+}
+
+ChunkServer::ChunkServer(const std::string& address, World& world, RegionStorage& storage, const TerrainGenerator& generator, JobSystem& jobs, uint64_t seed)
+	: listener(address), world(world), storage(storage), generator(generator), jobs(jobs), seed(seed), ticker(seed), compactor(jobs) {}
+
+void ChunkServer::tick() {
+	auto start = std::chrono::steady_clock::now();
+
+	accept();
+	for (Client& client : clients) receive(client);
+
+	ticker.tick(world, jobs);
+	for (const BlockChange& change : ticker.changes()) recordChange(change.pos, change.id);
+	for (const RegionTickStats& region : ticker.regionStats()) {
+		counts.scheduledUpdates += region.scheduledUpdates;
+		counts.randomTicks += region.randomTicks;
+		counts.maxRegionTickMilliseconds = std::max(counts.maxRegionTickMilliseconds, region.milliseconds);
+	}
+	broadcastChanges();
+
+	missing.clear();
+	for (Client& client : clients) stream(client);
+	loadChunks();
+
+	for (Client& client : clients) {
+		client.connection->flush();
+		counts.bytesSent += client.connection->bytesSent() - client.countedBytes;
+		client.countedBytes = client.connection->bytesSent();
+	}
+	clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client& client) { return !client.connection->open(); }), clients.end());
+
+	// Nothing on the server meshes or lights, so what the world queues
+	// for that is dropped.
+	world.takeDirtySections();
+	world.takeUnlitChunks();
+	world.takeLightEdits();
+
+	compactor.update(world);
+	counts.cold = compactor.stats(world);
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	counts.ticks++;
+	counts.totalTickMilliseconds += milliseconds;
+	counts.maxTickMilliseconds = std::max(counts.maxTickMilliseconds, milliseconds);
+}
+
+void ChunkServer::accept() {
+	while (std::unique_ptr<Connection> connection = listener.accept()) {
+		Client client;
+		client.connection = std::move(connection);
+		clients.push_back(std::move(client));
+	}
+}
+
+// A client that sends something malformed is dropped.
+void ChunkServer::receive(Client& client) {
+	client.connection->receive();
+
+	try {
+		while (std::optional<Message> message = client.connection->next()) {
+			switch (message->type) {
+				case MessageType::Hello: {
+					HelloMessage hello = readHello(*message);
+					client.greeted = true;
+					client.viewRadius = std::min(hello.viewRadius, MAX_VIEW_RADIUS);
+					client.complete = false;
+					// A client on another version gets ours and gives up.
+					writeWelcome(client.connection->output(), seed);
+					break;
+				}
+				case MessageType::Position:
+					client.center = readPosition(*message);
+					client.complete = false;
+					break;
+				case MessageType::SetBlock:
+					if (client.greeted) setBlock(readSetBlock(*message));
+					break;
+				default:
+					break;
+			}
+		}
+	} catch (std::exception &) {
+		client.connection->close();
+	}
+}
+
+void ChunkServer::setBlock(const SetBlockMessage& edit) {
+	if (edit.y < 0 || edit.y >= CHUNK_HEIGHT || edit.id >= blockCount()) return;
+
+	ChunkPos chunk = chunkOf(edit.x, edit.z);
+	if (!world.getChunk(chunk) || world.getBlock(edit.x, edit.y, edit.z) == edit.id) return;
+
+	world.setBlock(edit.x, edit.y, edit.z, edit.id);
+	recordChange({edit.x, edit.y, edit.z}, edit.id);
+}
+
+// Queues a change already made to the world for this tick's broadcast.
+void ChunkServer::recordChange(BlockPos pos, BlockId id) {
+	encoded.erase(chunkOf(pos.x, pos.z));
+
+	SectionPos section = sectionOf(pos.x, pos.y, pos.z);
+	BlockChangeBatch& batch = changes[section];
+	batch.pos = section;
+	batch.changes.emplace_back(static_cast<uint16_t>(Section::index(pos.x & (SECTION_SIZE - 1), pos.y & (SECTION_SIZE - 1), pos.z & (SECTION_SIZE - 1))), id);
+	counts.blockChanges++;
+}
+
+// Each section's batch is encoded once and copied to every client
+// holding its chunk; a section edited all over is resent whole instead.
+void ChunkServer::broadcastChanges() {
+	std::vector<uint8_t> frame;
+	for (auto& [pos, batch] : changes) {
+		frame.clear();
+		if (batch.changes.size() > MAX_SECTION_CHANGES) {
+			writeSectionData(frame, pos, world.getChunk({pos.x, pos.z})->sections[pos.y]);
+		} else {
+			writeBlockChanges(frame, batch);
+		}
+
+		for (Client& client : clients) {
+			if (!client.sent.count({pos.x, pos.z})) continue;
+			std::vector<uint8_t>& out = client.connection->output();
+			out.insert(out.end(), frame.begin(), frame.end());
+		}
+	}
+	changes.clear();
+}
+
+// Unloads are one chunk past the view radius, so walking back and forth
+// over a chunk border does not resend a row of chunks each time.
+void ChunkServer::stream(Client& client) {
+	if (!client.greeted) return;
+
+	int radius = client.viewRadius;
+	std::vector<uint8_t>& out = client.connection->output();
+	for (auto it = client.sent.begin(); it != client.sent.end();) {
+		if (chunkDistance(*it, client.center) > radius + 1) {
+			writeUnloadChunk(out, *it);
+			it = client.sent.erase(it);
+		} else {
+			it++;
+		}
+	}
+
+	if (client.complete) return;
+
+	bool complete = true;
+	forEachInView(client.center, radius, [&](ChunkPos pos, int distance) {
+		if (client.sent.count(pos)) return;
+
+		const Chunk *chunk = world.getChunk(pos);
+		if (!chunk) {
+			auto [it, inserted] = missing.emplace(pos, distance);
+			if (!inserted) it->second = std::min(it->second, distance);
+			complete = false;
+			return;
+		}
+
+		if (client.connection->pending() >= CLIENT_BACKLOG) {
+			complete = false;
+			return;
+		}
+
+		const std::vector<uint8_t>& frame = chunkFrame(*chunk);
+		out.insert(out.end(), frame.begin(), frame.end());
+		client.sent.insert(pos);
+		counts.chunksSent++;
+	});
+	client.complete = complete;
+}
+
+// The nearest missing chunks are read from disk or generated on the job
+// system, like the client's spawn area; new ones are saved later.
+void ChunkServer::loadChunks() {
+	if (missing.empty()) return;
+
+	std::vector<std::pair<int, ChunkPos>> order;
+	order.reserve(missing.size());
+	for (const auto& [pos, distance] : missing) order.emplace_back(distance, pos);
+	size_t count = std::min(order.size(), CHUNKS_PER_TICK);
+	std::partial_sort(order.begin(), order.begin() + count, order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	for (size_t i = 0; i < count; i++) chunks.push_back(std::make_unique<Chunk>(order[i].second));
+
+	std::vector<char> generated(chunks.size(), 0);
+	jobs.parallelFor(chunks.size(), [&](size_t i) {
+		if (!storage.loadChunk(chunks[i]->pos, *chunks[i])) {
+			generator.generate(*chunks[i]);
+			generated[i] = 1;
+		}
+	});
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		if (generated[i]) {
+			world.markUnsaved(chunks[i]->pos);
+			counts.chunksGenerated++;
+		} else {
+			counts.chunksLoaded++;
+		}
+		world.addChunk(std::move(chunks[i]));
+	}
+
+	for (Client& client : clients) client.complete = false;
+}
+
+const std::vector<uint8_t>& ChunkServer::chunkFrame(const Chunk& chunk) {
+	auto it = encoded.find(chunk.pos);
+	if (it == encoded.end()) {
+		it = encoded.emplace(chunk.pos, std::vector<uint8_t>()).first;
+		writeChunkData(it->second, chunk);
+	}
+	return it->second;
+}
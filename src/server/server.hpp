@@ -0,0 +1,99 @@
+#pragma once
+
+#include <core/jobs.hpp>
+#include <net/protocol.hpp>
+#include <net/socket.hpp>
+#include <world/compactor.hpp>
+#include <world/generator.hpp>
+#include <world/region.hpp>
+#include <world/ticks.hpp>
+#include <world/world.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+const auto TICK_LENGTH = std::chrono::duration<double>(1.0 / 30.0);
+const uint8_t MAX_VIEW_RADIUS = 16;
+// Chunks loaded or generated per tick, nearest to a client first.
+const size_t CHUNKS_PER_TICK = 64;
+// Bytes a client may have queued before more chunks wait for it to
+// catch up; block changes are always sent.
+const size_t CLIENT_BACKLOG = 4 << 20;
+
+struct ServerStats {
+	uint64_t ticks = 0;
+	uint64_t chunksLoaded = 0;
+	uint64_t chunksGenerated = 0;
+	uint64_t chunksSent = 0;
+	uint64_t blockChanges = 0;
+	uint64_t scheduledUpdates = 0;
+	uint64_t randomTicks = 0;
+	uint64_t bytesSent = 0;
+	double totalTickMilliseconds = 0.0;
+	double maxTickMilliseconds = 0.0;
+	// The slowest block tick region in any tick.
+	double maxRegionTickMilliseconds = 0.0;
+	CompactorStats cold;
+};
+
+// Streams the world to connected clients. Each tick accepts new
+// connections, applies their edits, runs block updates, loads or generates the chunks their
+// view needs, and sends each client the chunks that entered its view,
+// unloads for the ones that left it, and the tick's block changes as one
+// batch per section. Encoded chunks are cached until edited, so clients
+// sharing an area share the encoding work. Loaded chunks stay loaded, and
+// those nobody has looked at for a while are compressed in memory.
+class ChunkServer {
+public:
+	ChunkServer(const std::string& address, World& world, RegionStorage& storage, const TerrainGenerator& generator, JobSystem& jobs, uint64_t seed);
+
+	void tick();
+	void setColdStorage(size_t budget, uint32_t idleTicks) { compactor.configure(budget, idleTicks); }
+	// Idle chunks that have to be saved before they can be compressed.
+	std::vector<ChunkPos> takeSaveRequests() { return compactor.takeSaveRequests(); }
+	size_t clientCount() const { return clients.size(); }
+	const ServerStats& stats() const { return counts; }
+	// Block tick regions of the last tick.
+	const std::vector<RegionTickStats>& regionStats() const { return ticker.regionStats(); }
+private:
+	struct Client {
+		std::unique_ptr<Connection> connection;
+		bool greeted = false;
+		uint8_t viewRadius = 0;
+		ChunkPos center = {0, 0};
+		// Chunks the client has been sent and not told to unload.
+		std::unordered_set<ChunkPos, ChunkPosHash> sent;
+		// Nothing in view is left to send.
+		bool complete = false;
+		uint64_t countedBytes = 0;
+	};
+
+	Listener listener;
+	World& world;
+	RegionStorage& storage;
+	const TerrainGenerator& generator;
+	JobSystem& jobs;
+	uint64_t seed;
+	BlockTicker ticker;
+	ChunkCompactor compactor;
+	std::vector<Client> clients;
+	std::unordered_map<ChunkPos, std::vector<uint8_t>, ChunkPosHash> encoded;
+	std::unordered_map<SectionPos, BlockChangeBatch, SectionPosHash> changes;
+	// Chunks some client wants that are not loaded, by distance to the
+	// nearest such client.
+	std::unordered_map<ChunkPos, int, ChunkPosHash> missing;
+	ServerStats counts;
+
+	void accept();
+	void receive(Client& client);
+	void setBlock(const SetBlockMessage& edit);
+	void recordChange(BlockPos pos, BlockId id);
+	void loadChunks();
+	void stream(Client& client);
+	void broadcastChanges();
+	const std::vector<uint8_t>& chunkFrame(const Chunk& chunk);
+};
@@ -0,0 +1,128 @@
+#include <world/blocks.hpp>
+#include <stdexcept>
+#include <vector>
+
+struct CoreBlock {
+	const char *name;
+	BlockDefinition definition;
+};
+
+static constexpr BlockDefinition opaqueBlock(uint32_t color, uint16_t texture) {
+	BlockDefinition definition;
+	definition.layer = RenderLayer::Opaque;
+	definition.fullCube = true;
+	definition.lightFilter = 15;
+	definition.color = color;
+	definition.textures = {texture, texture, texture, texture, texture, texture};
+	return definition;
+}
+
+static constexpr BlockDefinition grassBlock() {
+	BlockDefinition definition = opaqueBlock(0x4DA633FF, 3);
+	definition.textures[2] = 1;
+	definition.textures[3] = 2;
+	definition.randomTicks = true;
+	return definition;
+}
+
+static constexpr BlockDefinition sandBlock() {
+	BlockDefinition definition = opaqueBlock(0xDBCC8CFF, 4);
+	definition.updateDelay = 2;
+	return definition;
+}
+
+static constexpr BlockDefinition waterBlock() {
+	BlockDefinition definition;
+	definition.layer = RenderLayer::Translucent;
+	definition.lightFilter = 2;
+	definition.color = 0x3359CC99;
+	definition.textures = {5, 5, 5, 5, 5, 5};
+	return definition;
+}
+
+static constexpr BlockDefinition lampBlock() {
+	BlockDefinition definition = opaqueBlock(0xFFD980FF, 9);
+	definition.emission = 15;
+	return definition;
+}
+
+// Indexed by id.
+static constexpr CoreBlock CORE_BLOCKS[] = {
+	{"air", BlockDefinition()},
+	{"stone", opaqueBlock(0x808080FF, 0)},
+	{"dirt", opaqueBlock(0x734D2EFF, 1)},
+	{"grass", grassBlock()},
+	{"sand", sandBlock()},
+	{"water", waterBlock()},
+	{"snow", opaqueBlock(0xF2F2FAFF, 6)},
+	{"bedrock", opaqueBlock(0x262626FF, 7)},
+	{"sandstone", opaqueBlock(0xCCB880FF, 8)},
+	{"lamp", lampBlock()}
+};
+
+static_assert(sizeof(CORE_BLOCKS) / sizeof(CORE_BLOCKS[0]) == CORE_BLOCK_COUNT, "every core block needs a definition");
+
+static constexpr void fillBlock(BlockTables& tables, size_t id, const BlockDefinition& definition) {
+	uint8_t flags = 0;
+	if (definition.layer == RenderLayer::Opaque) flags |= BLOCK_OPAQUE;
+	if (definition.layer == RenderLayer::Translucent) flags |= BLOCK_TRANSLUCENT;
+	if (definition.fullCube) flags |= BLOCK_FULL_CUBE;
+	if (definition.randomTicks) flags |= BLOCK_RANDOM_TICKS;
+	if (definition.updateDelay > 0) flags |= BLOCK_SCHEDULED_UPDATES;
+
+	tables.flags[id] = flags;
+	tables.emission[id] = definition.emission;
+	tables.lightFilter[id] = definition.lightFilter;
+	tables.updateDelay[id] = definition.updateDelay;
+	tables.color[id] = definition.color;
+	tables.textures[id] = definition.textures;
+}
+
+static constexpr BlockTables coreTables() {
+	BlockTables tables{};
+	for (size_t id = 0; id < CORE_BLOCK_COUNT; id++) fillBlock(tables, id, CORE_BLOCKS[id].definition);
+	tables.count = CORE_BLOCK_COUNT;
+	return tables;
+}
+
+// Built by the compiler, so the core blocks are there before any static
+// constructor could look at them.
+static constexpr BlockTables CORE_TABLES = coreTables();
+
+BlockTables blockTables = CORE_TABLES;
+
+static std::vector<Identifier> modBlocks;
+static bool frozen = false;
+
+BlockId registerBlock(const Identifier& name, const BlockDefinition& definition) {
+	if (frozen) throw std::runtime_error("failed to register block " + name.space + ":" + name.name + ", blocks are frozen!");
+	if (blockTables.count >= MAX_BLOCKS) throw std::runtime_error("failed to register block " + name.space + ":" + name.name + ", too many blocks!");
+	if (findBlock(name)) throw std::runtime_error("failed to register block " + name.space + ":" + name.name + ", it already exists!");
+
+	size_t id = blockTables.count++;
+	fillBlock(blockTables, id, definition);
+	modBlocks.push_back(name);
+	return static_cast<BlockId>(id);
+}
+
+void freezeBlocks() {
+	frozen = true;
+}
+
+std::optional<BlockId> findBlock(const Identifier& name) {
+	if (name.space == "core") {
+		for (BlockId id = 0; id < CORE_BLOCK_COUNT; id++) {
+			if (name.name == CORE_BLOCKS[id].name) return id;
+		}
+	}
+	for (size_t i = 0; i < modBlocks.size(); i++) {
+		if (modBlocks[i].space == name.space && modBlocks[i].name == name.name) return static_cast<BlockId>(CORE_BLOCK_COUNT + i);
+	}
+	return std::nullopt;
+}
+
+Identifier blockName(BlockId id) {
+	if (id < CORE_BLOCK_COUNT) return Identifier("core", CORE_BLOCKS[id].name);
+	if (id < blockTables.count) return modBlocks[id - CORE_BLOCK_COUNT];
+	return Identifier("core", "unknown");
+}
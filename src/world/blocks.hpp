@@ -0,0 +1,138 @@
+#pragma once
+
+#include <assets/assets.hpp>
+#include <world/chunk.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+const BlockId STONE = 1;
+const BlockId DIRT = 2;
+const BlockId GRASS = 3;
+const BlockId SAND = 4;
+const BlockId WATER = 5;
+const BlockId SNOW = 6;
+const BlockId BEDROCK = 7;
+const BlockId SANDSTONE = 8;
+const BlockId LAMP = 9;
+const BlockId CORE_BLOCK_COUNT = 10;
+
+// Ids the property tables have room for. Lookups wrap ids past it, so a
+// corrupt palette reads some block's properties rather than past the end.
+const size_t MAX_BLOCKS = 4096;
+
+enum class RenderLayer : uint8_t {
+	None,
+	Opaque,
+	// Drawn blended in the translucent pass, sorted back to front.
+	Translucent
+};
+
+struct BlockDefinition {
+	RenderLayer layer = RenderLayer::None;
+	// Fills its whole cell for collisions.
+	bool fullCube = false;
+	uint8_t emission = 0;
+	// How much light the block takes away on top of the one level lost
+	// per step; 15 stops it completely.
+	uint8_t lightFilter = 0;
+	// 0xRRGGBBAA; alpha below one only matters for translucent blocks.
+	uint32_t color = 0;
+	// Layers in the block texture array, in mesher face order: -x, +x,
+	// -y, +y, -z, +z.
+	std::array<uint16_t, 6> textures = {};
+	// Sampled by random ticks, like grass spreading over dirt.
+	bool randomTicks = false;
+	// Updated this many ticks after it or a neighbour changed, like sand
+	// falling once the block under it is gone; 0 for never.
+	uint8_t updateDelay = 0;
+};
+
+const uint8_t BLOCK_OPAQUE = 1 << 0;
+const uint8_t BLOCK_TRANSLUCENT = 1 << 1;
+const uint8_t BLOCK_FULL_CUBE = 1 << 2;
+const uint8_t BLOCK_RANDOM_TICKS = 1 << 3;
+const uint8_t BLOCK_SCHEDULED_UPDATES = 1 << 4;
+
+// Block properties as one array per property, indexed by id, so the
+// mesher, light engine and collisions pay a single load per voxel and
+// only pull in the properties they read. Unregistered ids are zero,
+// which reads as air.
+struct BlockTables {
+	alignas(64) std::array<uint8_t, MAX_BLOCKS> flags;
+	alignas(64) std::array<uint8_t, MAX_BLOCKS> emission;
+	alignas(64) std::array<uint8_t, MAX_BLOCKS> lightFilter;
+	alignas(64) std::array<uint8_t, MAX_BLOCKS> updateDelay;
+	alignas(64) std::array<uint32_t, MAX_BLOCKS> color;
+	alignas(64) std::array<std::array<uint16_t, 6>, MAX_BLOCKS> textures;
+	size_t count;
+};
+
+// The core blocks followed by whatever mods registered. Written only
+// before freezeBlocks, while nothing else runs.
+extern BlockTables blockTables;
+
+// Appends a block and returns its id. Clients and servers have to
+// register the same blocks in the same order to agree on ids. Throws once
+// the registry is frozen.
+BlockId registerBlock(const Identifier& name, const BlockDefinition& definition);
+// Called once everything is registered, before any world is loaded.
+void freezeBlocks();
+std::optional<BlockId> findBlock(const Identifier& name);
+Identifier blockName(BlockId id);
+
+inline size_t blockCount() {
+	return blockTables.count;
+}
+
+inline uint8_t blockFlags(BlockId id) {
+	return blockTables.flags[id & (MAX_BLOCKS - 1)];
+}
+
+inline bool isOpaque(BlockId id) {
+	return blockFlags(id) & BLOCK_OPAQUE;
+}
+
+inline bool isTranslucent(BlockId id) {
+	return blockFlags(id) & BLOCK_TRANSLUCENT;
+}
+
+inline bool isSolid(BlockId id) {
+	return blockFlags(id) & BLOCK_FULL_CUBE;
+}
+
+inline RenderLayer renderLayer(BlockId id) {
+	uint8_t flags = blockFlags(id);
+	if (flags & BLOCK_OPAQUE) return RenderLayer::Opaque;
+	return flags & BLOCK_TRANSLUCENT ? RenderLayer::Translucent : RenderLayer::None;
+}
+
+inline uint8_t lightEmission(BlockId id) {
+	return blockTables.emission[id & (MAX_BLOCKS - 1)];
+}
+
+inline uint8_t lightOpacity(BlockId id) {
+	return blockTables.lightFilter[id & (MAX_BLOCKS - 1)];
+}
+
+inline bool ticksRandomly(BlockId id) {
+	return blockFlags(id) & BLOCK_RANDOM_TICKS;
+}
+
+inline bool hasScheduledUpdates(BlockId id) {
+	return blockFlags(id) & BLOCK_SCHEDULED_UPDATES;
+}
+
+inline uint32_t updateDelay(BlockId id) {
+	return blockTables.updateDelay[id & (MAX_BLOCKS - 1)];
+}
+
+inline uint32_t blockColorRGBA(BlockId id) {
+	return blockTables.color[id & (MAX_BLOCKS - 1)];
+}
+
+inline uint16_t blockTexture(BlockId id, int face) {
+	return blockTables.textures[id & (MAX_BLOCKS - 1)][face];
+}
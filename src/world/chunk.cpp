@@ -0,0 +1,171 @@
+#include <world/chunk.hpp>
+#include <atomic>
+#include <stdexcept>
+
+static uint32_t readIndex(const std::vector<uint64_t>& data, uint32_t bits, int index) {
+	if (bits == 0) return 0;
+
+	uint32_t perWord = 64 / bits;
+	return static_cast<uint32_t>((data[index / perWord] >> ((index % perWord) * bits)) & ((1ull << bits) - 1));
+}
+
+static void writeIndex(std::vector<uint64_t>& data, uint32_t bits, int index, uint32_t value) {
+	uint32_t perWord = 64 / bits;
+	uint64_t mask = (1ull << bits) - 1;
+	uint32_t shift = (index % perWord) * bits;
+	uint64_t& word = data[index / perWord];
+	word = (word & ~(mask << shift)) | (static_cast<uint64_t>(value) << shift);
+}
+
+static void resize(SectionData& section, uint32_t bits) {
+	std::vector<uint64_t> data(SECTION_VOLUME / (64 / bits), 0);
+
+	for (int i = 0; i < SECTION_VOLUME; i++) {
+		writeIndex(data, bits, i, readIndex(section.data, section.bits, i));
+	}
+
+	section.data.swap(data);
+	section.bits = bits;
+}
+
+static std::shared_ptr<SectionData> emptySection() {
+	static const std::shared_ptr<SectionData> empty = [] {
+		auto section = std::make_shared<SectionData>();
+		section->palette.push_back(AIR);
+		return section;
+	}();
+	return empty;
+}
+
+// Fresh sections all share one empty storage until they are written to.
+Section::Section() : storage(emptySection()) {}
+
+SectionData& Section::mutate() {
+	if (storage.use_count() > 1) {
+		storage = std::make_shared<SectionData>(*storage);
+	} else {
+		// Pairs with the release in the last snapshot's reference drop, so
+		// its reads are finished before this thread starts writing.
+		std::atomic_thread_fence(std::memory_order_acquire);
+	}
+
+	return *storage;
+}
+
+BlockId Section::get(int index) const {
+	return storage->palette[readIndex(storage->data, storage->bits, index)];
+}
+
+BlockId Section::get(int x, int y, int z) const {
+	return get(index(x, y, z));
+}
+
+void Section::set(int index, BlockId id) {
+	BlockId old = get(index);
+	if (old == id) return;
+
+	SectionData& section = mutate();
+
+	uint32_t value = 0;
+	while (value < section.palette.size() && section.palette[value] != id) value++;
+
+	if (value == section.palette.size()) {
+		section.palette.push_back(id);
+
+		uint32_t needed = section.bits == 0 ? 1 : section.bits;
+		while ((1ull << needed) < section.palette.size()) needed *= 2;
+		if (needed != section.bits) resize(section, needed);
+	}
+
+	writeIndex(section.data, section.bits, index, value);
+
+	if (old == AIR) section.blockCount++;
+	if (id == AIR) section.blockCount--;
+}
+
+void Section::set(int x, int y, int z, BlockId id) {
+	set(index(x, y, z), id);
+}
+
+void Section::fill(BlockId id) {
+	auto section = std::make_shared<SectionData>();
+	section->palette.push_back(id);
+	section->blockCount = id == AIR ? 0 : SECTION_VOLUME;
+	storage = std::move(section);
+}
+
+// Packs a full section given as one byte-sized palette index per block,
+// dropping palette entries that are never referenced.
+void Section::assign(const std::vector<BlockId>& palette, const uint8_t *indices) {
+	uint8_t remap[256];
+	bool used[256] = {};
+	for (int i = 0; i < SECTION_VOLUME; i++) used[indices[i]] = true;
+
+	std::vector<BlockId> compacted;
+	for (size_t i = 0; i < palette.size() && i < 256; i++) {
+		if (!used[i]) continue;
+		remap[i] = static_cast<uint8_t>(compacted.size());
+		compacted.push_back(palette[i]);
+	}
+
+	if (compacted.size() == 1) {
+		fill(compacted[0]);
+		return;
+	}
+
+	auto section = std::make_shared<SectionData>();
+	section->bits = 1;
+	while ((1ull << section->bits) < compacted.size()) section->bits *= 2;
+	section->data.assign(SECTION_VOLUME / (64 / section->bits), 0);
+
+	for (int i = 0; i < SECTION_VOLUME; i++) {
+		uint32_t value = remap[indices[i]];
+		writeIndex(section->data, section->bits, i, value);
+		if (compacted[value] != AIR) section->blockCount++;
+	}
+
+	section->palette = std::move(compacted);
+	storage = std::move(section);
+}
+
+void Section::load(std::vector<BlockId> palette, uint32_t bits, std::vector<uint64_t> data) {
+	if (palette.empty() || (bits != 0 && 64 % bits != 0) || bits > 16) {
+		throw std::runtime_error("invalid section palette!");
+	}
+
+	if (data.size() != (bits == 0 ? 0 : SECTION_VOLUME / (64 / bits))) {
+		throw std::runtime_error("invalid section data size!");
+	}
+
+	auto section = std::make_shared<SectionData>();
+	section->palette = std::move(palette);
+	section->bits = bits;
+	section->data = std::move(data);
+
+	for (int i = 0; i < SECTION_VOLUME; i++) {
+		uint32_t value = readIndex(section->data, bits, i);
+		if (value >= section->palette.size()) {
+			throw std::runtime_error("section palette index out of range!");
+		}
+		if (section->palette[value] != AIR) section->blockCount++;
+	}
+
+	storage = std::move(section);
+}
+
+Chunk::Chunk(ChunkPos pos) : pos(pos) {}
+
+BlockId Chunk::getBlock(int x, int y, int z) const {
+	return sections[y / SECTION_SIZE].get(x, y % SECTION_SIZE, z);
+}
+
+void Chunk::setBlock(int x, int y, int z, BlockId id) {
+	sections[y / SECTION_SIZE].set(x, y % SECTION_SIZE, z, id);
+}
+
+bool Chunk::isEmpty() const {
+	for (const auto& section : sections) {
+		if (!section.isEmpty()) return false;
+	}
+	return true;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using BlockId = uint16_t;
+
+const BlockId AIR = 0;
+
+const int SECTION_SIZE = 16;
+const int SECTION_VOLUME = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
+const int SECTIONS_PER_CHUNK = 16;
+const int CHUNK_HEIGHT = SECTION_SIZE * SECTIONS_PER_CHUNK;
+
+struct ChunkPos {
+	int32_t x;
+	int32_t z;
+
+	bool operator==(const ChunkPos& other) const {
+		return x == other.x && z == other.z;
+	}
+
+	bool operator!=(const ChunkPos& other) const {
+		return !(*this == other);
+	}
+};
+
+struct ChunkPosHash {
+	size_t operator()(const ChunkPos& pos) const {
+		return std::hash<uint64_t>()((static_cast<uint64_t>(static_cast<uint32_t>(pos.x)) << 32) | static_cast<uint32_t>(pos.z));
+	}
+};
+
+struct SectionData {
+	std::vector<BlockId> palette;
+	std::vector<uint64_t> data;
+	uint32_t bits = 0;
+	uint16_t blockCount = 0;
+};
+
+struct SectionPos {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+
+	bool operator==(const SectionPos& other) const {
+		return x == other.x && y == other.y && z == other.z;
+	}
+
+	bool operator!=(const SectionPos& other) const {
+		return !(*this == other);
+	}
+};
+
+struct SectionPosHash {
+	size_t operator()(const SectionPos& pos) const {
+		uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(pos.x)) << 36) ^
+			(static_cast<uint64_t>(static_cast<uint32_t>(pos.z)) << 8) ^
+			static_cast<uint64_t>(static_cast<uint8_t>(pos.y));
+		return std::hash<uint64_t>()(key);
+	}
+};
+
+// A 16x16x16 block volume stored as a palette of block ids plus a packed
+// array of palette indices. Entry widths are powers of two so an entry
+// never straddles two words; a width of 0 means the whole section is
+// palette[0].
+//
+// Copies share their storage and the first write to a shared section
+// clones it, so copying a chunk is a cheap snapshot that background
+// work can read while the live chunk keeps changing.
+class Section {
+public:
+	Section();
+
+	static int index(int x, int y, int z) {
+		return (y * SECTION_SIZE + z) * SECTION_SIZE + x;
+	}
+
+	BlockId get(int x, int y, int z) const;
+	BlockId get(int index) const;
+	void set(int x, int y, int z, BlockId id);
+	void set(int index, BlockId id);
+	void fill(BlockId id);
+	void assign(const std::vector<BlockId>& palette, const uint8_t *indices);
+
+	bool isEmpty() const { return storage->blockCount == 0; }
+	uint16_t nonAirCount() const { return storage->blockCount; }
+	uint32_t bitsPerEntry() const { return storage->bits; }
+	const std::vector<BlockId>& getPalette() const { return storage->palette; }
+	const std::vector<uint64_t>& getData() const { return storage->data; }
+	bool isShared() const { return storage.use_count() > 1; }
+
+	void load(std::vector<BlockId> palette, uint32_t bits, std::vector<uint64_t> data);
+private:
+	std::shared_ptr<SectionData> storage;
+
+	SectionData& mutate();
+};
+
+class Chunk {
+public:
+	Chunk(ChunkPos pos);
+
+	ChunkPos pos;
+	std::array<Section, SECTIONS_PER_CHUNK> sections;
+
+	BlockId getBlock(int x, int y, int z) const;
+	void setBlock(int x, int y, int z, BlockId id);
+
+	bool isEmpty() const;
+};
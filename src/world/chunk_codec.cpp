@@ -0,0 +1,114 @@
+#include <world/chunk_codec.hpp>
+#include <world/compression.hpp>
+#include <cstring>
+#include <stdexcept>
+
+const uint8_t CHUNK_FORMAT_VERSION = 1;
+const size_t PAYLOAD_HEADER_SIZE = 1 + 4;
+
+template<typename T>
+static void put(std::vector<uint8_t>& out, T value) {
+	uint8_t bytes[sizeof(T)];
+	memcpy(bytes, &value, sizeof(T));
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+static T take(const uint8_t *&ip, const uint8_t *end) {
+	if (static_cast<size_t>(end - ip) < sizeof(T)) {
+		throw std::runtime_error("truncated chunk data!");
+	}
+
+	T value;
+	memcpy(&value, ip, sizeof(T));
+	ip += sizeof(T);
+	return value;
+}
+
+void encodeSection(std::vector<uint8_t>& out, const Section& section) {
+	const auto& palette = section.getPalette();
+	const auto& data = section.getData();
+
+	put<uint8_t>(out, static_cast<uint8_t>(section.bitsPerEntry()));
+	put<uint16_t>(out, static_cast<uint16_t>(palette.size() - 1));
+	for (BlockId id : palette) put<BlockId>(out, id);
+
+	if (data.empty()) return;
+
+	size_t offset = out.size();
+	out.resize(offset + data.size() * sizeof(uint64_t));
+	memcpy(out.data() + offset, data.data(), data.size() * sizeof(uint64_t));
+}
+
+void decodeSection(const uint8_t *&ip, const uint8_t *end, Section& section) {
+	uint32_t bits = take<uint8_t>(ip, end);
+	size_t paletteSize = take<uint16_t>(ip, end) + 1;
+
+	std::vector<BlockId> palette(paletteSize);
+	for (auto& id : palette) id = take<BlockId>(ip, end);
+
+	if (bits != 0 && (bits > 16 || 64 % bits != 0)) {
+		throw std::runtime_error("invalid section bit width!");
+	}
+
+	size_t words = bits == 0 ? 0 : SECTION_VOLUME / (64 / bits);
+	if (static_cast<size_t>(end - ip) < words * sizeof(uint64_t)) {
+		throw std::runtime_error("truncated chunk data!");
+	}
+
+	std::vector<uint64_t> data(words);
+	if (words != 0) memcpy(data.data(), ip, words * sizeof(uint64_t));
+	ip += words * sizeof(uint64_t);
+
+	section.load(std::move(palette), bits, std::move(data));
+}
+
+std::vector<uint8_t> encodeChunk(const Chunk& chunk) {
+	std::vector<uint8_t> raw;
+	put<uint8_t>(raw, CHUNK_FORMAT_VERSION);
+	put<int32_t>(raw, chunk.pos.x);
+	put<int32_t>(raw, chunk.pos.z);
+	for (const auto& section : chunk.sections) encodeSection(raw, section);
+
+	std::vector<uint8_t> compressed = compressBlock(raw.data(), raw.size());
+
+	std::vector<uint8_t> payload;
+	payload.reserve(PAYLOAD_HEADER_SIZE + compressed.size());
+	put<uint8_t>(payload, static_cast<uint8_t>(ChunkCompression::Lz));
+	put<uint32_t>(payload, static_cast<uint32_t>(raw.size()));
+	payload.insert(payload.end(), compressed.begin(), compressed.end());
+
+	return payload;
+}
+
+void decodeChunk(const uint8_t *data, size_t size, Chunk& chunk) {
+	const uint8_t *ip = data;
+	const uint8_t *end = data + size;
+
+	auto compression = static_cast<ChunkCompression>(take<uint8_t>(ip, end));
+	uint32_t rawSize = take<uint32_t>(ip, end);
+
+	std::vector<uint8_t> raw;
+	switch (compression) {
+		case ChunkCompression::Raw:
+			raw.assign(ip, end);
+			break;
+		case ChunkCompression::Lz:
+			raw.resize(rawSize);
+			decompressBlock(ip, end - ip, raw.data(), raw.size());
+			break;
+		default:
+			throw std::runtime_error("unknown chunk compression!");
+	}
+
+	const uint8_t *rp = raw.data();
+	const uint8_t *rend = raw.data() + raw.size();
+
+	if (take<uint8_t>(rp, rend) != CHUNK_FORMAT_VERSION) {
+		throw std::runtime_error("unsupported chunk format version!");
+	}
+
+	chunk.pos.x = take<int32_t>(rp, rend);
+	chunk.pos.z = take<int32_t>(rp, rend);
+	for (auto& section : chunk.sections) decodeSection(rp, rend, section);
+}
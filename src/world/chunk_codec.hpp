@@ -0,0 +1,21 @@
+#pragma once
+
+#include <world/chunk.hpp>
+#include <cstdint>
+#include <vector>
+
+enum class ChunkCompression : uint8_t {
+	Raw = 0,
+	Lz = 1
+};
+
+// Serialized chunks are the raw section palettes and packed index words,
+// so decoding is a copy rather than a per-block rebuild. A section stored
+// with a single palette entry is written as that entry alone.
+std::vector<uint8_t> encodeChunk(const Chunk& chunk);
+void decodeChunk(const uint8_t *data, size_t size, Chunk& chunk);
+
+// One section's palette and index words, uncompressed; decoding advances
+// ip past it.
+void encodeSection(std::vector<uint8_t>& out, const Section& section);
+void decodeSection(const uint8_t *&ip, const uint8_t *end, Section& section);
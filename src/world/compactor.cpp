@@ -0,0 +1,91 @@
+#include <world/compactor.hpp>
+#include <world/chunk_codec.hpp>
+#include <world/compression.hpp>
+#include <algorithm>
+
+ChunkCompactor::ChunkCompactor(JobSystem& jobs, size_t budget, uint32_t idleTicks) : jobs(jobs), budget(budget), idleTicks(idleTicks) {}
+
+ChunkCompactor::~ChunkCompactor() {
+	group.wait();
+}
+
+void ChunkCompactor::configure(size_t budget, uint32_t idleTicks) {
+	this->budget = budget;
+	this->idleTicks = idleTicks;
+}
+
+void ChunkCompactor::update(World& world) {
+	world.advanceClock();
+
+	if (!pending.empty()) {
+		if (!group.done()) return;
+		for (Snapshot& snapshot : pending) {
+			if (!world.freeze(snapshot.pos, snapshot.lastUsed, std::move(snapshot.packedChunk), std::move(snapshot.packedLight))) abandoned++;
+		}
+		pending.clear();
+	}
+
+	if (++ticks % COMPACT_INTERVAL != 0) return;
+
+	std::vector<ChunkUsage> usage = world.chunkUsage();
+	hotChunks = usage.size();
+	hotBytes = 0;
+	for (const ChunkUsage& chunk : usage) hotBytes += chunk.bytes;
+	if (hotBytes <= budget) return;
+
+	uint64_t now = world.clock();
+	usage.erase(std::remove_if(usage.begin(), usage.end(), [&](const ChunkUsage& chunk) {
+		return now - chunk.lastUsed < idleTicks;
+	}), usage.end());
+	std::sort(usage.begin(), usage.end(), [](const ChunkUsage& a, const ChunkUsage& b) { return a.lastUsed < b.lastUsed; });
+
+	// The chunk copy shares its sections until the live chunk writes to
+	// them; the light has to be copied outright.
+	uint64_t remaining = hotBytes;
+	saveRequests.clear();
+	for (const ChunkUsage& chunk : usage) {
+		if (remaining <= budget || (pending.size() == COMPACT_BATCH && saveRequests.size() == COMPACT_BATCH)) break;
+		if (chunk.unsaved) {
+			if (saveRequests.size() == COMPACT_BATCH) continue;
+			saveRequests.push_back(chunk.pos);
+		} else {
+			if (pending.size() == COMPACT_BATCH) continue;
+			pending.push_back({chunk.pos, chunk.lastUsed, *chunk.chunk, std::make_unique<ChunkLight>(*chunk.light), {}, {}});
+		}
+		remaining -= chunk.bytes;
+	}
+
+	for (size_t i = 0; i < pending.size(); i++) {
+		jobs.submitBackground([this, i] {
+			Snapshot& snapshot = pending[i];
+			snapshot.packedChunk = encodeChunk(snapshot.chunk);
+			snapshot.packedLight = compressBlock(reinterpret_cast<const uint8_t *>(snapshot.light.get()), sizeof(ChunkLight));
+
+			// Dropping the copies now stops the live chunk cloning sections
+			// it writes to while the swap waits for the next update.
+			Chunk released = std::move(snapshot.chunk);
+			snapshot.light.reset();
+		}, &group);
+	}
+}
+
+std::vector<ChunkPos> ChunkCompactor::takeSaveRequests() {
+	std::vector<ChunkPos> positions;
+	positions.swap(saveRequests);
+	return positions;
+}
+
+CompactorStats ChunkCompactor::stats(const World& world) const {
+	ColdStats cold = world.coldStats();
+
+	CompactorStats stats;
+	stats.hotChunks = hotChunks;
+	stats.hotBytes = hotBytes;
+	stats.coldChunks = cold.coldChunks;
+	stats.coldBytes = cold.coldBytes;
+	stats.freezes = cold.freezes;
+	stats.thaws = cold.thaws;
+	stats.thawMilliseconds = cold.thawMilliseconds;
+	stats.abandoned = abandoned;
+	return stats;
+}
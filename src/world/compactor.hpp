@@ -0,0 +1,75 @@
+#pragma once
+
+#include <core/jobs.hpp>
+#include <world/chunk.hpp>
+#include <world/light.hpp>
+#include <world/world.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+const size_t DEFAULT_HOT_BUDGET = size_t(1) << 30;
+// Ticks without an access before a chunk may be compressed; a minute at
+// 30 ticks a second.
+const uint32_t DEFAULT_COLD_AFTER = 30 * 60;
+// Ticks between looks at which chunks went cold.
+const uint32_t COMPACT_INTERVAL = 30;
+// Most chunks compressed per look, so a burst does not flood the jobs.
+const size_t COMPACT_BATCH = 64;
+
+struct CompactorStats {
+	size_t hotChunks = 0;
+	// Estimated at the last look.
+	uint64_t hotBytes = 0;
+	size_t coldChunks = 0;
+	uint64_t coldBytes = 0;
+	uint64_t freezes = 0;
+	uint64_t thaws = 0;
+	double thawMilliseconds = 0.0;
+	// Compressed, but used again before they could be swapped in.
+	uint64_t abandoned = 0;
+};
+
+// Keeps the uncompressed chunks in a world within a byte budget. While
+// they take more, chunks no lookup has touched for idleTicks are
+// compressed least recently used first: the blocks with the region file
+// encoding and the light with the LZ codec, as background jobs from a
+// snapshot, then swapped in at the next update if the chunk was not used
+// in the meantime. The world thaws them again on their next lookup.
+// Idle chunks that are not saved yet cannot be dropped; they are asked to
+// be saved instead, so the next look can compress them.
+class ChunkCompactor {
+public:
+	ChunkCompactor(JobSystem& jobs, size_t budget = DEFAULT_HOT_BUDGET, uint32_t idleTicks = DEFAULT_COLD_AFTER);
+	~ChunkCompactor();
+
+	ChunkCompactor(const ChunkCompactor&) = delete;
+	ChunkCompactor& operator=(const ChunkCompactor&) = delete;
+
+	void configure(size_t budget, uint32_t idleTicks);
+	// Once per tick, between ticks; also advances the world's access clock.
+	void update(World& world);
+	// Idle unsaved chunks the last look wanted to compress, for the saver.
+	std::vector<ChunkPos> takeSaveRequests();
+	CompactorStats stats(const World& world) const;
+private:
+	struct Snapshot {
+		ChunkPos pos;
+		uint64_t lastUsed;
+		Chunk chunk;
+		std::unique_ptr<ChunkLight> light;
+		std::vector<uint8_t> packedChunk;
+		std::vector<uint8_t> packedLight;
+	};
+
+	JobSystem& jobs;
+	JobGroup group;
+	std::vector<Snapshot> pending;
+	std::vector<ChunkPos> saveRequests;
+	size_t budget;
+	uint32_t idleTicks;
+	uint64_t ticks = 0;
+	size_t hotChunks = 0;
+	uint64_t hotBytes = 0;
+	uint64_t abandoned = 0;
+};
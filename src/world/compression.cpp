@@ -0,0 +1,144 @@
+#include <world/compression.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+const size_t MIN_MATCH = 4;
+const size_t LAST_LITERALS = 5;
+const size_t MATCH_FIND_LIMIT = 12;
+const size_t MAX_OFFSET = 65535;
+const int HASH_BITS = 12;
+
+static uint32_t read32(const uint8_t *p) {
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint32_t hash(uint32_t sequence) {
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void writeLength(std::vector<uint8_t>& out, size_t length) {
+	while (length >= 255) {
+		out.push_back(255);
+		length -= 255;
+	}
+	out.push_back(static_cast<uint8_t>(length));
+}
+
+static void emitSequence(std::vector<uint8_t>& out, const uint8_t *literals, size_t literalLength, size_t offset, size_t matchLength) {
+	uint8_t token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+	if (offset != 0) {
+		size_t code = matchLength - MIN_MATCH;
+		token |= static_cast<uint8_t>(code >= 15 ? 15 : code);
+	}
+	out.push_back(token);
+
+	if (literalLength >= 15) writeLength(out, literalLength - 15);
+	out.insert(out.end(), literals, literals + literalLength);
+
+	if (offset == 0) return;
+
+	out.push_back(static_cast<uint8_t>(offset & 0xff));
+	out.push_back(static_cast<uint8_t>(offset >> 8));
+	if (matchLength - MIN_MATCH >= 15) writeLength(out, matchLength - MIN_MATCH - 15);
+}
+
+std::vector<uint8_t> compressBlock(const uint8_t *src, size_t size) {
+	std::vector<uint8_t> out;
+	out.reserve(size / 2 + 16);
+
+	size_t anchor = 0;
+
+	if (size > MATCH_FIND_LIMIT) {
+		uint32_t table[1 << HASH_BITS];
+		std::fill(table, table + (1 << HASH_BITS), UINT32_MAX);
+
+		size_t limit = size - MATCH_FIND_LIMIT;
+		size_t matchLimit = size - LAST_LITERALS;
+		size_t ip = 0;
+
+		while (ip < limit) {
+			uint32_t sequence = read32(src + ip);
+			uint32_t h = hash(sequence);
+			uint32_t ref = table[h];
+			table[h] = static_cast<uint32_t>(ip);
+
+			if (ref == UINT32_MAX || ip - ref > MAX_OFFSET || read32(src + ref) != sequence) {
+				ip++;
+				continue;
+			}
+
+			size_t length = MIN_MATCH;
+			while (ip + length < matchLimit && src[ref + length] == src[ip + length]) length++;
+
+			emitSequence(out, src + anchor, ip - anchor, ip - ref, length);
+			ip += length;
+			anchor = ip;
+		}
+	}
+
+	emitSequence(out, src + anchor, size - anchor, 0, 0);
+
+	return out;
+}
+
+static size_t readLength(const uint8_t *&ip, const uint8_t *end) {
+	size_t length = 0;
+	uint8_t byte;
+	do {
+		if (ip >= end) throw std::runtime_error("truncated compressed block!");
+		byte = *ip++;
+		length += byte;
+	} while (byte == 255);
+	return length;
+}
+
+void decompressBlock(const uint8_t *src, size_t size, uint8_t *dst, size_t dstSize) {
+	const uint8_t *ip = src;
+	const uint8_t *end = src + size;
+	size_t op = 0;
+
+	while (ip < end) {
+		uint8_t token = *ip++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15) literalLength += readLength(ip, end);
+
+		if (literalLength > static_cast<size_t>(end - ip) || literalLength > dstSize - op) {
+			throw std::runtime_error("corrupt compressed block!");
+		}
+		memcpy(dst + op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		if (ip == end) break;
+
+		if (end - ip < 2) throw std::runtime_error("truncated compressed block!");
+		size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15) matchLength += readLength(ip, end);
+		matchLength += MIN_MATCH;
+
+		if (offset == 0 || offset > op || matchLength > dstSize - op) {
+			throw std::runtime_error("corrupt compressed block!");
+		}
+
+		// Overlapping copies are how runs are encoded, so this has to go
+		// byte by byte when the match source is closer than its length.
+		uint8_t *match = dst + op - offset;
+		if (offset >= matchLength) {
+			memcpy(dst + op, match, matchLength);
+		} else {
+			for (size_t i = 0; i < matchLength; i++) dst[op + i] = match[i];
+		}
+		op += matchLength;
+	}
+
+	if (op != dstSize) {
+		throw std::runtime_error("compressed block size mismatch!");
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Byte-oriented LZ77 codec using the LZ4 block layout: no entropy stage,
+// so both directions run at memory speed, which matters more than ratio
+// for chunk payloads that are already palette packed.
+std::vector<uint8_t> compressBlock(const uint8_t *src, size_t size);
+void decompressBlock(const uint8_t *src, size_t size, uint8_t *dst, size_t dstSize);
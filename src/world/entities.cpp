@@ -0,0 +1,160 @@
+#include <world/entities.hpp>
+#include <world/world.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+const size_t ENTITY_BATCH = 1024;
+const float GRAVITY = 20.0f;
+// Entities below this have fallen out of the loaded world for good.
+const float MIN_ENTITY_Y = -64.0f;
+
+uint32_t EntityStore::findArchetype(ComponentMask mask, EntityModel model) {
+	for (uint32_t i = 0; i < tables.size(); i++) {
+		if (tables[i].mask == mask && tables[i].model == model) return i;
+	}
+
+	Archetype archetype;
+	archetype.mask = mask;
+	archetype.model = model;
+	tables.push_back(std::move(archetype));
+	return static_cast<uint32_t>(tables.size() - 1);
+}
+
+Entity EntityStore::spawn(const EntityDesc& desc) {
+	uint32_t index;
+	if (!freeSlots.empty()) {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		index = static_cast<uint32_t>(slots.size());
+		slots.emplace_back();
+	}
+
+	uint32_t a = findArchetype(desc.mask, desc.model);
+	Archetype& archetype = tables[a];
+
+	Slot& slot = slots[index];
+	slot.archetype = a;
+	slot.row = static_cast<uint32_t>(archetype.size());
+	slot.alive = true;
+
+	Entity entity{index, slot.generation};
+	archetype.entities.push_back(entity);
+	if (archetype.has(COMPONENT_POSITION)) archetype.positions.push_back(desc.position);
+	if (archetype.has(COMPONENT_VELOCITY)) archetype.velocities.push_back(desc.velocity);
+	if (archetype.has(COMPONENT_YAW)) archetype.yaws.push_back(desc.yaw);
+	if (archetype.has(COMPONENT_SPIN)) archetype.spins.push_back(desc.spin);
+	if (archetype.has(COMPONENT_SCALE)) archetype.scales.push_back(desc.scale);
+	if (archetype.has(COMPONENT_LIFETIME)) archetype.lifetimes.push_back(desc.lifetime);
+
+	count++;
+	return entity;
+}
+
+template <typename T>
+static void removeRow(std::vector<T>& column, size_t row) {
+	if (column.empty()) return;
+	column[row] = column.back();
+	column.pop_back();
+}
+
+void EntityStore::destroy(Entity entity) {
+	if (!alive(entity)) return;
+
+	Slot& slot = slots[entity.index];
+	Archetype& archetype = tables[slot.archetype];
+	size_t row = slot.row;
+
+	Entity moved = archetype.entities.back();
+	slots[moved.index].row = static_cast<uint32_t>(row);
+
+	removeRow(archetype.entities, row);
+	removeRow(archetype.positions, row);
+	removeRow(archetype.velocities, row);
+	removeRow(archetype.yaws, row);
+	removeRow(archetype.spins, row);
+	removeRow(archetype.scales, row);
+	removeRow(archetype.lifetimes, row);
+
+	slot.alive = false;
+	slot.generation++;
+	freeSlots.push_back(entity.index);
+	count--;
+}
+
+bool EntityStore::alive(Entity entity) const {
+	return entity.index < slots.size() && slots[entity.index].alive && slots[entity.index].generation == entity.generation;
+}
+
+void EntityStore::each(ComponentMask required, JobSystem& jobs, const std::function<void(Archetype&, size_t, size_t)>& body) {
+	ranges.clear();
+	for (uint32_t a = 0; a < tables.size(); a++) {
+		if (!tables[a].has(required)) continue;
+		for (size_t begin = 0; begin < tables[a].size(); begin += ENTITY_BATCH) {
+			ranges.push_back({a, begin, std::min(tables[a].size(), begin + ENTITY_BATCH)});
+		}
+	}
+
+	jobs.parallelFor(ranges.size(), [&](size_t i) {
+		body(tables[ranges[i].archetype], ranges[i].begin, ranges[i].end);
+	});
+}
+
+static bool solidAt(const World& world, glm::vec3 position) {
+	glm::ivec3 block(glm::floor(position));
+	return isSolid(world.getBlock(block.x, block.y, block.z));
+}
+
+void updateEntities(EntityStore& store, const World& world, JobSystem& jobs, float dt) {
+	// Falling entities land on top of the block below; walking ones turn
+	// around at walls, facing where they now go.
+	store.each(COMPONENT_POSITION | COMPONENT_VELOCITY, jobs, [&](Archetype& archetype, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			glm::vec3& position = archetype.positions[i];
+			glm::vec3& velocity = archetype.velocities[i];
+			velocity.y -= GRAVITY * dt;
+
+			glm::vec3 next = position + velocity * dt;
+			if (velocity.y < 0.0f && solidAt(world, next)) {
+				next.y = std::floor(next.y) + 1.0f;
+				velocity.y = 0.0f;
+			}
+
+			glm::vec3 ahead(next.x, position.y + 0.5f, next.z);
+			if ((velocity.x != 0.0f || velocity.z != 0.0f) && solidAt(world, ahead)) {
+				next.x = position.x;
+				next.z = position.z;
+				velocity.x = -velocity.x;
+				velocity.z = -velocity.z;
+				if (archetype.has(COMPONENT_YAW) && !archetype.has(COMPONENT_SPIN)) {
+					archetype.yaws[i] = std::atan2(velocity.x, -velocity.z);
+				}
+			}
+
+			position = next;
+		}
+	});
+
+	store.each(COMPONENT_YAW | COMPONENT_SPIN, jobs, [&](Archetype& archetype, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			archetype.yaws[i] = std::fmod(archetype.yaws[i] + archetype.spins[i] * dt, 6.2831853f);
+		}
+	});
+
+	store.each(COMPONENT_LIFETIME, jobs, [&](Archetype& archetype, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) archetype.lifetimes[i] -= dt;
+	});
+
+	std::vector<Entity> dead;
+	for (const Archetype& archetype : store.archetypes()) {
+		for (size_t i = 0; i < archetype.size(); i++) {
+			bool expired = archetype.has(COMPONENT_LIFETIME) && archetype.lifetimes[i] <= 0.0f;
+			bool fallen = archetype.has(COMPONENT_POSITION) && archetype.positions[i].y < MIN_ENTITY_Y;
+			if (expired || fallen) dead.push_back(archetype.entities[i]);
+		}
+	}
+
+	for (Entity entity : dead) store.destroy(entity);
+}
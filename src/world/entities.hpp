@@ -0,0 +1,111 @@
+#pragma once
+
+#include <core/jobs.hpp>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class World;
+
+using ComponentMask = uint32_t;
+
+// Each component is one column of an archetype, stored only when the
+// archetype's mask has its bit.
+const ComponentMask COMPONENT_POSITION = 1 << 0;
+const ComponentMask COMPONENT_VELOCITY = 1 << 1;
+const ComponentMask COMPONENT_YAW = 1 << 2;
+const ComponentMask COMPONENT_SPIN = 1 << 3;
+const ComponentMask COMPONENT_SCALE = 1 << 4;
+const ComponentMask COMPONENT_LIFETIME = 1 << 5;
+
+// What an entity is drawn as. Entities of one model share an archetype,
+// so the renderer can draw each model with a single instanced draw.
+enum class EntityModel : uint8_t {
+	Mob,
+	Item,
+	Particle,
+	None
+};
+
+const size_t ENTITY_MODEL_COUNT = 3;
+
+// Handles stay valid while the entity lives; the generation tells a
+// reused slot from the entity that held it before.
+struct Entity {
+	uint32_t index;
+	uint32_t generation;
+};
+
+// Every entity with the same components and model, one contiguous array
+// per component. Rows are packed: destroying an entity moves the last
+// row into its place.
+struct Archetype {
+	ComponentMask mask;
+	EntityModel model;
+	std::vector<Entity> entities;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> velocities;
+	std::vector<float> yaws;
+	std::vector<float> spins;
+	std::vector<float> scales;
+	std::vector<float> lifetimes;
+
+	size_t size() const { return entities.size(); }
+	bool has(ComponentMask components) const { return (mask & components) == components; }
+};
+
+// Starting values for spawn(); only components in mask are kept.
+struct EntityDesc {
+	ComponentMask mask = COMPONENT_POSITION;
+	EntityModel model = EntityModel::None;
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::vec3 velocity = glm::vec3(0.0f);
+	float yaw = 0.0f;
+	float spin = 0.0f;
+	float scale = 1.0f;
+	float lifetime = 0.0f;
+};
+
+// Entities grouped into archetypes. Owned by the simulation thread.
+class EntityStore {
+public:
+	Entity spawn(const EntityDesc& desc);
+	void destroy(Entity entity);
+	bool alive(Entity entity) const;
+	size_t size() const { return count; }
+
+	// Runs body over the rows of every archetype that has all of
+	// required, in batches spread over the job system. A body may write
+	// any column of its own rows but must not spawn or destroy.
+	void each(ComponentMask required, JobSystem& jobs, const std::function<void(Archetype&, size_t, size_t)>& body);
+
+	std::vector<Archetype>& archetypes() { return tables; }
+	const std::vector<Archetype>& archetypes() const { return tables; }
+private:
+	struct Slot {
+		uint32_t generation = 0;
+		uint32_t archetype = 0;
+		uint32_t row = 0;
+		bool alive = false;
+	};
+
+	struct Range {
+		uint32_t archetype;
+		size_t begin;
+		size_t end;
+	};
+
+	std::vector<Archetype> tables;
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	std::vector<Range> ranges;
+	size_t count = 0;
+
+	uint32_t findArchetype(ComponentMask mask, EntityModel model);
+};
+
+// Moves every entity by one tick: gravity, a ground and wall test
+// against the world, spin, and lifetimes. Entities whose lifetime ran
+// out or that fell out of the world are destroyed.
+void updateEntities(EntityStore& store, const World& world, JobSystem& jobs, float dt);
@@ -0,0 +1,171 @@
+#include <world/generator.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+#include <cmath>
+
+const int COLUMNS = SECTION_SIZE * SECTION_SIZE;
+const int CAVE_STEP = 4;
+const int CAVE_CELLS_XZ = SECTION_SIZE / CAVE_STEP + 1;
+const int CAVE_CELLS_Y = CHUNK_HEIGHT / CAVE_STEP + 1;
+const int CAVE_SAMPLES = CAVE_CELLS_XZ * CAVE_CELLS_XZ * CAVE_CELLS_Y;
+const float CAVE_THRESHOLD = 0.02f;
+
+// Fixed palette the generator writes indices into; Section::assign drops
+// whatever a given section does not use.
+enum Layer : uint8_t {
+	LayerAir,
+	LayerStone,
+	LayerDirt,
+	LayerGrass,
+	LayerSand,
+	LayerWater,
+	LayerSnow,
+	LayerBedrock,
+	LayerSandstone
+};
+
+static const std::vector<BlockId> LAYER_PALETTE = {AIR, STONE, DIRT, GRASS, SAND, WATER, SNOW, BEDROCK, SANDSTONE};
+
+TerrainGenerator::TerrainGenerator(uint64_t seed) :
+	continental(mixSeed(seed, 1)),
+	detail(mixSeed(seed, 2)),
+	temperature(mixSeed(seed, 3)),
+	humidity(mixSeed(seed, 4)),
+	caves(mixSeed(seed, 5)) {}
+
+static Biome classify(int height, float temperature, float humidity) {
+	if (height < SEA_LEVEL - 2) return Biome::Ocean;
+	if (height <= SEA_LEVEL + 1) return Biome::Beach;
+	if (temperature < -0.12f || height > SEA_LEVEL + 70) return Biome::Snowy;
+	if (temperature > 0.12f && humidity < 0.0f) return Biome::Desert;
+	return Biome::Plains;
+}
+
+static uint8_t surfaceLayer(Biome biome, bool top) {
+	switch (biome) {
+		case Biome::Ocean:
+		case Biome::Beach:
+			return LayerSand;
+		case Biome::Desert:
+			return top ? LayerSand : LayerSandstone;
+		case Biome::Snowy:
+			return top ? LayerSnow : LayerDirt;
+		case Biome::Plains:
+			break;
+	}
+	return top ? LayerGrass : LayerDirt;
+}
+
+void TerrainGenerator::generate(Chunk& chunk) const {
+	float baseX = static_cast<float>(chunk.pos.x * SECTION_SIZE);
+	float baseZ = static_cast<float>(chunk.pos.z * SECTION_SIZE);
+
+	alignas(32) float xs[COLUMNS];
+	alignas(32) float zs[COLUMNS];
+	for (int i = 0; i < COLUMNS; i++) {
+		xs[i] = baseX + static_cast<float>(i % SECTION_SIZE);
+		zs[i] = baseZ + static_cast<float>(i / SECTION_SIZE);
+	}
+
+	alignas(32) float shape[COLUMNS] = {};
+	alignas(32) float roughness[COLUMNS] = {};
+	alignas(32) float heat[COLUMNS] = {};
+	alignas(32) float moisture[COLUMNS] = {};
+	continental.fractal2D(xs, zs, COLUMNS, 4, 1.0f / 512.0f, shape);
+	detail.fractal2D(xs, zs, COLUMNS, 4, 1.0f / 64.0f, roughness);
+	temperature.fractal2D(xs, zs, COLUMNS, 3, 1.0f / 1024.0f, heat);
+	humidity.fractal2D(xs, zs, COLUMNS, 3, 1.0f / 1024.0f, moisture);
+
+	int heights[COLUMNS];
+	Biome biomes[COLUMNS];
+	for (int i = 0; i < COLUMNS; i++) {
+		// Mountains get sharper detail than lowlands.
+		float mountains = std::max(shape[i], 0.0f);
+		float height = SEA_LEVEL + shape[i] * 110.0f + roughness[i] * (12.0f + mountains * 80.0f);
+		heights[i] = std::clamp(static_cast<int>(height), 1, CHUNK_HEIGHT - 2);
+		biomes[i] = classify(heights[i], heat[i], moisture[i]);
+	}
+
+	alignas(32) float cx[CAVE_SAMPLES];
+	alignas(32) float cy[CAVE_SAMPLES];
+	alignas(32) float cz[CAVE_SAMPLES];
+	alignas(32) float density[CAVE_SAMPLES] = {};
+	for (int i = 0; i < CAVE_SAMPLES; i++) {
+		int x = i % CAVE_CELLS_XZ;
+		int z = (i / CAVE_CELLS_XZ) % CAVE_CELLS_XZ;
+		int y = i / (CAVE_CELLS_XZ * CAVE_CELLS_XZ);
+		cx[i] = baseX + static_cast<float>(x * CAVE_STEP);
+		cy[i] = static_cast<float>(y * CAVE_STEP) * 1.6f;
+		cz[i] = baseZ + static_cast<float>(z * CAVE_STEP);
+	}
+	caves.fractal3D(cx, cy, cz, CAVE_SAMPLES, 2, 1.0f / 48.0f, density);
+
+	auto lattice = [&](int x, int y, int z) {
+		return density[(y * CAVE_CELLS_XZ + z) * CAVE_CELLS_XZ + x];
+	};
+
+	uint8_t indices[SECTION_VOLUME];
+
+	for (int sy = 0; sy < SECTIONS_PER_CHUNK; sy++) {
+		int minY = sy * SECTION_SIZE;
+
+		for (int ly = 0; ly < SECTION_SIZE; ly++) {
+			int y = minY + ly;
+			int gy = y / CAVE_STEP;
+			float ty = static_cast<float>(y % CAVE_STEP) / CAVE_STEP;
+
+			for (int z = 0; z < SECTION_SIZE; z++) {
+				int gz = z / CAVE_STEP;
+				float tz = static_cast<float>(z % CAVE_STEP) / CAVE_STEP;
+
+				for (int x = 0; x < SECTION_SIZE; x++) {
+					int column = z * SECTION_SIZE + x;
+					int height = heights[column];
+					Biome biome = biomes[column];
+					uint8_t layer;
+
+					if (y == 0) {
+						layer = LayerBedrock;
+					} else if (y > height) {
+						layer = y <= SEA_LEVEL ? LayerWater : LayerAir;
+					} else if (y == height) {
+						layer = surfaceLayer(biome, true);
+					} else if (y > height - 4) {
+						layer = surfaceLayer(biome, false);
+					} else {
+						layer = LayerStone;
+					}
+
+					// Caves stay sealed below water so oceans do not drain
+					// into them.
+					bool carvable = layer != LayerBedrock && layer != LayerWater && layer != LayerAir &&
+						y > 4 && (height > SEA_LEVEL + 1 || y < height - 6);
+
+					if (carvable) {
+						int gx = x / CAVE_STEP;
+						float tx = static_cast<float>(x % CAVE_STEP) / CAVE_STEP;
+
+						float c00 = lattice(gx, gy, gz) + tx * (lattice(gx + 1, gy, gz) - lattice(gx, gy, gz));
+						float c10 = lattice(gx, gy + 1, gz) + tx * (lattice(gx + 1, gy + 1, gz) - lattice(gx, gy + 1, gz));
+						float c01 = lattice(gx, gy, gz + 1) + tx * (lattice(gx + 1, gy, gz + 1) - lattice(gx, gy, gz + 1));
+						float c11 = lattice(gx, gy + 1, gz + 1) + tx * (lattice(gx + 1, gy + 1, gz + 1) - lattice(gx, gy + 1, gz + 1));
+						float c0 = c00 + ty * (c10 - c00);
+						float c1 = c01 + ty * (c11 - c01);
+
+						if (std::fabs(c0 + tz * (c1 - c0)) < CAVE_THRESHOLD) layer = LayerAir;
+					}
+
+					indices[Section::index(x, ly, z)] = layer;
+				}
+			}
+		}
+
+		chunk.sections[sy].assign(LAYER_PALETTE, indices);
+	}
+}
+
+void TerrainGenerator::generate(const std::vector<Chunk *>& chunks, JobSystem& jobs) const {
+	jobs.parallelFor(chunks.size(), [&](size_t i) {
+		generate(*chunks[i]);
+	});
+}
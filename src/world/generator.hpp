@@ -0,0 +1,38 @@
+#pragma once
+
+#include <core/jobs.hpp>
+#include <world/chunk.hpp>
+#include <world/noise.hpp>
+#include <cstdint>
+#include <vector>
+
+const int SEA_LEVEL = 64;
+// The seed every world is generated with; the server sends it to clients.
+const uint64_t WORLD_SEED = 0x5eed;
+
+enum class Biome : uint8_t {
+	Ocean,
+	Beach,
+	Plains,
+	Desert,
+	Snowy
+};
+
+// Fills whole chunk columns at a time: the height and biome noise for all
+// 256 columns is one batch, and caves come from a 4-block lattice of 3D
+// noise that is interpolated per block. Output only depends on the seed
+// and the chunk position, so any number of threads may generate chunks
+// concurrently and the result is the same.
+class TerrainGenerator {
+public:
+	TerrainGenerator(uint64_t seed);
+
+	void generate(Chunk& chunk) const;
+	void generate(const std::vector<Chunk *>& chunks, JobSystem& jobs) const;
+private:
+	Noise continental;
+	Noise detail;
+	Noise temperature;
+	Noise humidity;
+	Noise caves;
+};
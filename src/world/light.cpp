@@ -0,0 +1,360 @@
+#include <world/light.hpp>
+#include <world/world.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+const int TILE_CHUNKS = 8;
+
+struct LightNode {
+	int x, y, z;
+	uint8_t level;
+};
+
+struct LightTile {
+	std::vector<ChunkPos> chunks;
+	std::vector<BlockPos> edits;
+};
+
+static const int DIRECTIONS[6][3] = {
+	{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+};
+
+const int DOWN = 2;
+
+// Runs the flood fills for one tile. Only this tile's worker touches the
+// chunks within reach of its edits, so it reads and writes the world
+// without locking.
+class LightPropagator {
+public:
+	LightPropagator(World& world) : world(world) {}
+
+	std::unordered_set<SectionPos, SectionPosHash> touched;
+
+	void lightChunk(ChunkPos pos);
+	void edit(BlockPos pos);
+	void run();
+private:
+	World& world;
+	std::vector<LightNode> adds[2];
+	std::vector<LightNode> removes[2];
+
+	ChunkPos cachedPos = {0, 0};
+	Chunk *cachedChunk = nullptr;
+	ChunkLight *cachedLight = nullptr;
+	bool cached = false;
+	SectionPos lastTouched = {0, -1, 0};
+
+	bool load(int x, int z);
+	BlockId block(int x, int y, int z);
+	uint8_t get(LightChannel channel, int x, int y, int z);
+	void set(LightChannel channel, int x, int y, int z, uint8_t level);
+	void touch(int x, int y, int z);
+	int skyHeight(int x, int z);
+	void propagate(LightChannel channel);
+};
+
+bool LightPropagator::load(int x, int z) {
+	ChunkPos pos = chunkOf(x, z);
+	if (!cached || pos != cachedPos) {
+		cachedPos = pos;
+		cachedChunk = world.getChunk(pos);
+		cachedLight = world.getLight(pos);
+		cached = true;
+	}
+	return cachedChunk != nullptr;
+}
+
+BlockId LightPropagator::block(int x, int y, int z) {
+	if (!load(x, z)) return AIR;
+	return cachedChunk->getBlock(x & (SECTION_SIZE - 1), y, z & (SECTION_SIZE - 1));
+}
+
+uint8_t LightPropagator::get(LightChannel channel, int x, int y, int z) {
+	if (!load(x, z)) return 0;
+	return cachedLight->get(channel, x & (SECTION_SIZE - 1), y, z & (SECTION_SIZE - 1));
+}
+
+void LightPropagator::set(LightChannel channel, int x, int y, int z, uint8_t level) {
+	if (!load(x, z)) return;
+	cachedLight->set(channel, x & (SECTION_SIZE - 1), y, z & (SECTION_SIZE - 1), level);
+	touch(x, y, z);
+}
+
+// Faces are lit by the cell in front of them, so a cell on a section
+// border also changes the mesh of the section next to it.
+void LightPropagator::touch(int x, int y, int z) {
+	SectionPos section = sectionOf(x, y, z);
+	int lx = x & (SECTION_SIZE - 1);
+	int ly = y & (SECTION_SIZE - 1);
+	int lz = z & (SECTION_SIZE - 1);
+	bool border = lx == 0 || lx == SECTION_SIZE - 1 || ly == 0 || ly == SECTION_SIZE - 1 || lz == 0 || lz == SECTION_SIZE - 1;
+
+	if (!border) {
+		if (section != lastTouched) touched.insert(section);
+		lastTouched = section;
+		return;
+	}
+
+	touched.insert(section);
+	if (lx == 0) touched.insert({section.x - 1, section.y, section.z});
+	if (lx == SECTION_SIZE - 1) touched.insert({section.x + 1, section.y, section.z});
+	if (ly == 0) touched.insert({section.x, section.y - 1, section.z});
+	if (ly == SECTION_SIZE - 1) touched.insert({section.x, section.y + 1, section.z});
+	if (lz == 0) touched.insert({section.x, section.y, section.z - 1});
+	if (lz == SECTION_SIZE - 1) touched.insert({section.x, section.y, section.z + 1});
+}
+
+// Lowest y from which the column is open to the sky.
+int LightPropagator::skyHeight(int x, int z) {
+	if (!load(x, z)) return 0;
+
+	int lx = x & (SECTION_SIZE - 1);
+	int lz = z & (SECTION_SIZE - 1);
+	for (int s = SECTIONS_PER_CHUNK - 1; s >= 0; s--) {
+		const Section& section = cachedChunk->sections[s];
+		if (section.isEmpty()) continue;
+
+		for (int y = SECTION_SIZE - 1; y >= 0; y--) {
+			if (lightOpacity(section.get(lx, y, lz)) > 0) return s * SECTION_SIZE + y + 1;
+		}
+	}
+	return 0;
+}
+
+void LightPropagator::lightChunk(ChunkPos pos) {
+	if (!world.getChunk(pos)) return;
+
+	int baseX = pos.x * SECTION_SIZE;
+	int baseZ = pos.z * SECTION_SIZE;
+	auto& skyAdds = adds[static_cast<int>(LightChannel::Sky)];
+	auto& blockAdds = adds[static_cast<int>(LightChannel::Block)];
+
+	int heights[SECTION_SIZE + 2][SECTION_SIZE + 2];
+	for (int z = -1; z <= SECTION_SIZE; z++) {
+		for (int x = -1; x <= SECTION_SIZE; x++) {
+			heights[x + 1][z + 1] = skyHeight(baseX + x, baseZ + z);
+		}
+	}
+
+	// Everything above the first light-blocking block of a column sees the
+	// sky directly. Only cells next to a taller column, and the top cell
+	// that lights whatever partially opaque block lies below it, need to
+	// spread sideways or down.
+	for (int z = 0; z < SECTION_SIZE; z++) {
+		for (int x = 0; x < SECTION_SIZE; x++) {
+			int wx = baseX + x;
+			int wz = baseZ + z;
+			int height = heights[x + 1][z + 1];
+
+			for (int y = height; y < CHUNK_HEIGHT; y++) {
+				set(LightChannel::Sky, wx, y, wz, MAX_LIGHT);
+			}
+
+			int tallest = std::max({heights[x][z + 1], heights[x + 2][z + 1], heights[x + 1][z], heights[x + 1][z + 2]});
+			for (int y = height; y < tallest; y++) {
+				skyAdds.push_back({wx, y, wz, MAX_LIGHT});
+			}
+			if (height > 0 && height < CHUNK_HEIGHT) {
+				skyAdds.push_back({wx, height, wz, MAX_LIGHT});
+			}
+		}
+	}
+
+	const Chunk *chunk = world.getChunk(pos);
+	for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+		const Section& section = chunk->sections[s];
+		const auto& palette = section.getPalette();
+		if (std::none_of(palette.begin(), palette.end(), [](BlockId id) { return lightEmission(id) > 0; })) continue;
+
+		for (int i = 0; i < SECTION_VOLUME; i++) {
+			uint8_t emission = lightEmission(section.get(i));
+			if (emission == 0) continue;
+
+			int x = baseX + i % SECTION_SIZE;
+			int y = s * SECTION_SIZE + i / (SECTION_SIZE * SECTION_SIZE);
+			int z = baseZ + (i / SECTION_SIZE) % SECTION_SIZE;
+			set(LightChannel::Block, x, y, z, emission);
+			blockAdds.push_back({x, y, z, emission});
+		}
+	}
+
+	// Light already in the neighbours flows in across the shared faces.
+	auto inflow = [&](int nx, int nz, int x, int z) {
+		if (!world.getChunk(chunkOf(nx, nz))) return;
+
+		for (int y = 0; y < CHUNK_HEIGHT; y++) {
+			for (int c = 0; c < 2; c++) {
+				LightChannel channel = static_cast<LightChannel>(c);
+				uint8_t level = get(channel, nx, y, nz);
+				if (level > get(channel, x, y, z) + 1) adds[c].push_back({nx, y, nz, level});
+			}
+		}
+	};
+
+	for (int i = 0; i < SECTION_SIZE; i++) {
+		inflow(baseX - 1, baseZ + i, baseX, baseZ + i);
+		inflow(baseX + SECTION_SIZE, baseZ + i, baseX + SECTION_SIZE - 1, baseZ + i);
+		inflow(baseX + i, baseZ - 1, baseX + i, baseZ);
+		inflow(baseX + i, baseZ + SECTION_SIZE, baseX + i, baseZ + SECTION_SIZE - 1);
+	}
+}
+
+void LightPropagator::edit(BlockPos pos) {
+	if (!load(pos.x, pos.z)) return;
+
+	BlockId id = block(pos.x, pos.y, pos.z);
+
+	for (int c = 0; c < 2; c++) {
+		LightChannel channel = static_cast<LightChannel>(c);
+
+		uint8_t old = get(channel, pos.x, pos.y, pos.z);
+		if (old > 0) {
+			set(channel, pos.x, pos.y, pos.z, 0);
+			removes[c].push_back({pos.x, pos.y, pos.z, old});
+		}
+
+		// Whatever light surrounds the block is offered back to it; it only
+		// gets in if the new block lets it.
+		for (const auto& d : DIRECTIONS) {
+			int ny = pos.y + d[1];
+			if (ny < 0 || ny >= CHUNK_HEIGHT) continue;
+			adds[c].push_back({pos.x + d[0], ny, pos.z + d[2], 0});
+		}
+	}
+
+	uint8_t emission = lightEmission(id);
+	if (emission > 0) {
+		set(LightChannel::Block, pos.x, pos.y, pos.z, emission);
+		adds[static_cast<int>(LightChannel::Block)].push_back({pos.x, pos.y, pos.z, emission});
+	}
+
+	// Nothing is stored above the world, so the top layer is relit here.
+	if (pos.y == CHUNK_HEIGHT - 1 && lightOpacity(id) == 0) {
+		set(LightChannel::Sky, pos.x, pos.y, pos.z, MAX_LIGHT);
+		adds[static_cast<int>(LightChannel::Sky)].push_back({pos.x, pos.y, pos.z, MAX_LIGHT});
+	}
+}
+
+void LightPropagator::run() {
+	propagate(LightChannel::Block);
+	propagate(LightChannel::Sky);
+}
+
+void LightPropagator::propagate(LightChannel channel) {
+	int c = static_cast<int>(channel);
+	bool sky = channel == LightChannel::Sky;
+	auto& addQueue = adds[c];
+	auto& removeQueue = removes[c];
+
+	// Clear every cell whose light came through a removed cell; brighter
+	// cells met on the way are sources that refill the cleared area.
+	for (size_t head = 0; head < removeQueue.size(); head++) {
+		LightNode node = removeQueue[head];
+
+		for (int dir = 0; dir < 6; dir++) {
+			int nx = node.x + DIRECTIONS[dir][0];
+			int ny = node.y + DIRECTIONS[dir][1];
+			int nz = node.z + DIRECTIONS[dir][2];
+			if (ny < 0 || ny >= CHUNK_HEIGHT) continue;
+
+			uint8_t level = get(channel, nx, ny, nz);
+			if (level == 0) continue;
+
+			bool fromNode = level < node.level || (sky && dir == DOWN && node.level == MAX_LIGHT && level == MAX_LIGHT);
+			if (!fromNode) {
+				addQueue.push_back({nx, ny, nz, level});
+				continue;
+			}
+
+			set(channel, nx, ny, nz, 0);
+			removeQueue.push_back({nx, ny, nz, level});
+
+			if (!sky) {
+				uint8_t emission = lightEmission(block(nx, ny, nz));
+				if (emission > 0) {
+					set(channel, nx, ny, nz, emission);
+					addQueue.push_back({nx, ny, nz, emission});
+				}
+			}
+		}
+	}
+	removeQueue.clear();
+
+	for (size_t head = 0; head < addQueue.size(); head++) {
+		LightNode node = addQueue[head];
+
+		// Queued levels can be stale after a removal; the stored level is
+		// what actually spreads.
+		uint8_t level = get(channel, node.x, node.y, node.z);
+		if (level <= 1) continue;
+
+		for (int dir = 0; dir < 6; dir++) {
+			int nx = node.x + DIRECTIONS[dir][0];
+			int ny = node.y + DIRECTIONS[dir][1];
+			int nz = node.z + DIRECTIONS[dir][2];
+			if (ny < 0 || ny >= CHUNK_HEIGHT) continue;
+			if (!load(nx, nz)) continue;
+
+			uint8_t opacity = lightOpacity(block(nx, ny, nz));
+			if (opacity >= MAX_LIGHT) continue;
+
+			int target;
+			if (sky && dir == DOWN && level == MAX_LIGHT && opacity == 0) {
+				target = MAX_LIGHT;
+			} else {
+				target = level - 1 - opacity;
+			}
+
+			if (target <= get(channel, nx, ny, nz)) continue;
+
+			set(channel, nx, ny, nz, static_cast<uint8_t>(target));
+			addQueue.push_back({nx, ny, nz, static_cast<uint8_t>(target)});
+		}
+	}
+	addQueue.clear();
+}
+
+static int tileOf(int chunk) {
+	return chunk >= 0 ? chunk / TILE_CHUNKS : (chunk + 1) / TILE_CHUNKS - 1;
+}
+
+void updateLight(World& world, JobSystem& jobs) {
+	std::vector<ChunkPos> chunks = world.takeUnlitChunks();
+	std::vector<BlockPos> edits = world.takeLightEdits();
+	if (chunks.empty() && edits.empty()) return;
+
+	std::unordered_map<ChunkPos, LightTile, ChunkPosHash> tiles;
+	for (ChunkPos pos : chunks) {
+		tiles[{tileOf(pos.x), tileOf(pos.z)}].chunks.push_back(pos);
+	}
+	for (BlockPos pos : edits) {
+		ChunkPos chunk = chunkOf(pos.x, pos.z);
+		tiles[{tileOf(chunk.x), tileOf(chunk.z)}].edits.push_back(pos);
+	}
+
+	// Four passes over a 2x2 colouring of the tiles: tiles of one colour
+	// are a whole tile apart, further than any update can reach.
+	for (int colour = 0; colour < 4; colour++) {
+		std::vector<LightTile *> batch;
+		for (auto& [pos, tile] : tiles) {
+			if ((pos.x & 1) == (colour & 1) && (pos.z & 1) == (colour >> 1)) batch.push_back(&tile);
+		}
+		if (batch.empty()) continue;
+
+		std::vector<std::unordered_set<SectionPos, SectionPosHash>> touched(batch.size());
+		jobs.parallelFor(batch.size(), [&](size_t i) {
+			LightPropagator propagator(world);
+			for (ChunkPos pos : batch[i]->chunks) propagator.lightChunk(pos);
+			for (BlockPos pos : batch[i]->edits) propagator.edit(pos);
+			propagator.run();
+			touched[i] = std::move(propagator.touched);
+		});
+
+		for (const auto& sections : touched) {
+			for (SectionPos section : sections) world.markSectionDirty(section);
+		}
+	}
+}
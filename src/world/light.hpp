@@ -0,0 +1,58 @@
+#pragma once
+
+#include <world/chunk.hpp>
+#include <core/jobs.hpp>
+#include <array>
+#include <cstdint>
+
+class World;
+
+const uint8_t MAX_LIGHT = 15;
+
+enum class LightChannel {
+	Block,
+	Sky
+};
+
+// Block and sky light of one section as 4-bit levels, two per byte in
+// Section::index order.
+struct SectionLight {
+	std::array<uint8_t, SECTION_VOLUME / 2> block;
+	std::array<uint8_t, SECTION_VOLUME / 2> sky;
+
+	uint8_t get(LightChannel channel, int index) const {
+		const auto& nibbles = channel == LightChannel::Block ? block : sky;
+		return (nibbles[index >> 1] >> ((index & 1) * 4)) & 0xF;
+	}
+
+	void set(LightChannel channel, int index, uint8_t level) {
+		auto& nibbles = channel == LightChannel::Block ? block : sky;
+		int shift = (index & 1) * 4;
+		nibbles[index >> 1] = static_cast<uint8_t>((nibbles[index >> 1] & ~(0xF << shift)) | (level << shift));
+	}
+};
+
+struct ChunkLight {
+	std::array<SectionLight, SECTIONS_PER_CHUNK> sections;
+
+	uint8_t get(LightChannel channel, int x, int y, int z) const {
+		return sections[y / SECTION_SIZE].get(channel, Section::index(x, y % SECTION_SIZE, z));
+	}
+
+	void set(LightChannel channel, int x, int y, int z, uint8_t level) {
+		sections[y / SECTION_SIZE].set(channel, Section::index(x, y % SECTION_SIZE, z), level);
+	}
+};
+
+// Lights newly added chunks and repropagates light around the blocks
+// edited since the last call, then marks the sections whose light
+// changed for remeshing.
+//
+// Propagation is a breadth-first flood fill: a removal pass clears the
+// light that came through the changed blocks and collects the brighter
+// cells around that area, and an add pass spreads light back in from
+// them, so only the affected neighbourhood is visited. Light travels at
+// most 15 blocks, which keeps the work of one edit within two chunks of
+// it; edits are grouped into 8x8 chunk tiles and tiles at least one tile
+// apart are processed in parallel.
+void updateLight(World& world, JobSystem& jobs);
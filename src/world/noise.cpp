@@ -0,0 +1,325 @@
+#include <world/noise.hpp>
+#include <cmath>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NOISE_AVX2 1
+#endif
+
+uint64_t mixSeed(uint64_t seed, uint64_t salt) {
+	uint64_t z = seed + salt * 0x9e3779b97f4a7c15ull;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+Noise::Noise(uint64_t seed) {
+	for (int i = 0; i < 256; i++) perm[i] = i;
+
+	// Shuffled with our own generator rather than <random> distributions,
+	// whose output is not specified across standard libraries.
+	uint64_t state = seed;
+	for (int i = 255; i > 0; i--) {
+		state = mixSeed(state, static_cast<uint64_t>(i));
+		int j = static_cast<int>(state % static_cast<uint64_t>(i + 1));
+		std::swap(perm[i], perm[j]);
+	}
+
+	for (int i = 0; i < 256; i++) perm[i + 256] = perm[i];
+}
+
+bool Noise::vectorized() {
+#ifdef NOISE_AVX2
+	static const bool supported = __builtin_cpu_supports("avx2");
+	return supported;
+#else
+	return false;
+#endif
+}
+
+static inline float fade(float t) {
+	return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline float lerp(float t, float a, float b) {
+	return a + t * (b - a);
+}
+
+static inline float grad2(int32_t h, float x, float z) {
+	float u = (h & 1) ? -x : x;
+	float v = (h & 2) ? -z : z;
+	return u + v;
+}
+
+static inline float grad3(int32_t h, float x, float y, float z) {
+	h &= 15;
+	float u = h < 8 ? x : y;
+	float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+	return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+static inline float noise2(const int32_t *perm, float fx, float fz) {
+	float x0 = std::floor(fx);
+	float z0 = std::floor(fz);
+	int32_t xi = static_cast<int32_t>(x0) & 255;
+	int32_t zi = static_cast<int32_t>(z0) & 255;
+	float xf = fx - x0;
+	float zf = fz - z0;
+	float u = fade(xf);
+	float v = fade(zf);
+
+	int32_t a = perm[xi] + zi;
+	int32_t b = perm[xi + 1] + zi;
+
+	float n00 = grad2(perm[a], xf, zf);
+	float n10 = grad2(perm[b], xf - 1.0f, zf);
+	float n01 = grad2(perm[a + 1], xf, zf - 1.0f);
+	float n11 = grad2(perm[b + 1], xf - 1.0f, zf - 1.0f);
+
+	return lerp(v, lerp(u, n00, n10), lerp(u, n01, n11));
+}
+
+static inline float noise3(const int32_t *perm, float fx, float fy, float fz) {
+	float x0 = std::floor(fx);
+	float y0 = std::floor(fy);
+	float z0 = std::floor(fz);
+	int32_t xi = static_cast<int32_t>(x0) & 255;
+	int32_t yi = static_cast<int32_t>(y0) & 255;
+	int32_t zi = static_cast<int32_t>(z0) & 255;
+	float xf = fx - x0;
+	float yf = fy - y0;
+	float zf = fz - z0;
+	float u = fade(xf);
+	float v = fade(yf);
+	float w = fade(zf);
+
+	int32_t a = perm[xi] + yi;
+	int32_t aa = perm[a] + zi;
+	int32_t ab = perm[a + 1] + zi;
+	int32_t b = perm[xi + 1] + yi;
+	int32_t ba = perm[b] + zi;
+	int32_t bb = perm[b + 1] + zi;
+
+	float n000 = grad3(perm[aa], xf, yf, zf);
+	float n100 = grad3(perm[ba], xf - 1.0f, yf, zf);
+	float n010 = grad3(perm[ab], xf, yf - 1.0f, zf);
+	float n110 = grad3(perm[bb], xf - 1.0f, yf - 1.0f, zf);
+	float n001 = grad3(perm[aa + 1], xf, yf, zf - 1.0f);
+	float n101 = grad3(perm[ba + 1], xf - 1.0f, yf, zf - 1.0f);
+	float n011 = grad3(perm[ab + 1], xf, yf - 1.0f, zf - 1.0f);
+	float n111 = grad3(perm[bb + 1], xf - 1.0f, yf - 1.0f, zf - 1.0f);
+
+	float y0v = lerp(u, n000, n100);
+	float y1v = lerp(u, n010, n110);
+	float y2v = lerp(u, n001, n101);
+	float y3v = lerp(u, n011, n111);
+
+	return lerp(w, lerp(v, y0v, y1v), lerp(v, y2v, y3v));
+}
+
+#ifdef NOISE_AVX2
+
+#define NOISE_TARGET __attribute__((target("avx2")))
+
+NOISE_TARGET static inline __m256 fade8(__m256 t) {
+	__m256 t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+	__m256 inner = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f));
+	return _mm256_mul_ps(t3, _mm256_add_ps(_mm256_mul_ps(t, inner), _mm256_set1_ps(10.0f)));
+}
+
+NOISE_TARGET static inline __m256 lerp8(__m256 t, __m256 a, __m256 b) {
+	return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+NOISE_TARGET static inline __m256 negateIf(__m256i h, int bit, __m256 value) {
+	__m256i set = _mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(bit)), _mm256_set1_epi32(bit));
+	__m256i sign = _mm256_and_si256(set, _mm256_set1_epi32(INT32_MIN));
+	return _mm256_xor_ps(value, _mm256_castsi256_ps(sign));
+}
+
+NOISE_TARGET static inline __m256 grad2x8(__m256i h, __m256 x, __m256 z) {
+	return _mm256_add_ps(negateIf(h, 1, x), negateIf(h, 2, z));
+}
+
+NOISE_TARGET static inline __m256 grad3x8(__m256i h, __m256 x, __m256 y, __m256 z) {
+	h = _mm256_and_si256(h, _mm256_set1_epi32(15));
+
+	__m256 below8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+	__m256 below4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+	__m256 useX = _mm256_castsi256_ps(_mm256_or_si256(
+		_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)),
+		_mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+
+	__m256 u = _mm256_blendv_ps(y, x, below8);
+	__m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, useX), y, below4);
+
+	return _mm256_add_ps(negateIf(h, 1, u), negateIf(h, 2, v));
+}
+
+NOISE_TARGET static inline __m256i gather(const int32_t *perm, __m256i index) {
+	return _mm256_i32gather_epi32(perm, index, 4);
+}
+
+NOISE_TARGET static void accumulate2DAVX2(const int32_t *perm, const float *x, const float *z, size_t count, float frequency, float amplitude, float *out) {
+	const __m256 freq = _mm256_set1_ps(frequency);
+	const __m256 amp = _mm256_set1_ps(amplitude);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256i mask = _mm256_set1_epi32(255);
+	const __m256i inc = _mm256_set1_epi32(1);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 fx = _mm256_mul_ps(_mm256_loadu_ps(x + i), freq);
+		__m256 fz = _mm256_mul_ps(_mm256_loadu_ps(z + i), freq);
+		__m256 x0 = _mm256_floor_ps(fx);
+		__m256 z0 = _mm256_floor_ps(fz);
+		__m256i xi = _mm256_and_si256(_mm256_cvttps_epi32(x0), mask);
+		__m256i zi = _mm256_and_si256(_mm256_cvttps_epi32(z0), mask);
+		__m256 xf = _mm256_sub_ps(fx, x0);
+		__m256 zf = _mm256_sub_ps(fz, z0);
+		__m256 u = fade8(xf);
+		__m256 v = fade8(zf);
+
+		__m256i a = _mm256_add_epi32(gather(perm, xi), zi);
+		__m256i b = _mm256_add_epi32(gather(perm, _mm256_add_epi32(xi, inc)), zi);
+
+		__m256 xf1 = _mm256_sub_ps(xf, one);
+		__m256 zf1 = _mm256_sub_ps(zf, one);
+
+		__m256 n00 = grad2x8(gather(perm, a), xf, zf);
+		__m256 n10 = grad2x8(gather(perm, b), xf1, zf);
+		__m256 n01 = grad2x8(gather(perm, _mm256_add_epi32(a, inc)), xf, zf1);
+		__m256 n11 = grad2x8(gather(perm, _mm256_add_epi32(b, inc)), xf1, zf1);
+
+		__m256 result = lerp8(v, lerp8(u, n00, n10), lerp8(u, n01, n11));
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(amp, result)));
+	}
+
+	for (; i < count; i++) {
+		out[i] += amplitude * noise2(perm, x[i] * frequency, z[i] * frequency);
+	}
+}
+
+NOISE_TARGET static void accumulate3DAVX2(const int32_t *perm, const float *x, const float *y, const float *z, size_t count, float frequency, float amplitude, float *out) {
+	const __m256 freq = _mm256_set1_ps(frequency);
+	const __m256 amp = _mm256_set1_ps(amplitude);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256i mask = _mm256_set1_epi32(255);
+	const __m256i inc = _mm256_set1_epi32(1);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 fx = _mm256_mul_ps(_mm256_loadu_ps(x + i), freq);
+		__m256 fy = _mm256_mul_ps(_mm256_loadu_ps(y + i), freq);
+		__m256 fz = _mm256_mul_ps(_mm256_loadu_ps(z + i), freq);
+		__m256 x0 = _mm256_floor_ps(fx);
+		__m256 y0 = _mm256_floor_ps(fy);
+		__m256 z0 = _mm256_floor_ps(fz);
+		__m256i xi = _mm256_and_si256(_mm256_cvttps_epi32(x0), mask);
+		__m256i yi = _mm256_and_si256(_mm256_cvttps_epi32(y0), mask);
+		__m256i zi = _mm256_and_si256(_mm256_cvttps_epi32(z0), mask);
+		__m256 xf = _mm256_sub_ps(fx, x0);
+		__m256 yf = _mm256_sub_ps(fy, y0);
+		__m256 zf = _mm256_sub_ps(fz, z0);
+		__m256 u = fade8(xf);
+		__m256 v = fade8(yf);
+		__m256 w = fade8(zf);
+
+		__m256i a = _mm256_add_epi32(gather(perm, xi), yi);
+		__m256i aa = _mm256_add_epi32(gather(perm, a), zi);
+		__m256i ab = _mm256_add_epi32(gather(perm, _mm256_add_epi32(a, inc)), zi);
+		__m256i b = _mm256_add_epi32(gather(perm, _mm256_add_epi32(xi, inc)), yi);
+		__m256i ba = _mm256_add_epi32(gather(perm, b), zi);
+		__m256i bb = _mm256_add_epi32(gather(perm, _mm256_add_epi32(b, inc)), zi);
+
+		__m256 xf1 = _mm256_sub_ps(xf, one);
+		__m256 yf1 = _mm256_sub_ps(yf, one);
+		__m256 zf1 = _mm256_sub_ps(zf, one);
+
+		__m256 n000 = grad3x8(gather(perm, aa), xf, yf, zf);
+		__m256 n100 = grad3x8(gather(perm, ba), xf1, yf, zf);
+		__m256 n010 = grad3x8(gather(perm, ab), xf, yf1, zf);
+		__m256 n110 = grad3x8(gather(perm, bb), xf1, yf1, zf);
+		__m256 n001 = grad3x8(gather(perm, _mm256_add_epi32(aa, inc)), xf, yf, zf1);
+		__m256 n101 = grad3x8(gather(perm, _mm256_add_epi32(ba, inc)), xf1, yf, zf1);
+		__m256 n011 = grad3x8(gather(perm, _mm256_add_epi32(ab, inc)), xf, yf1, zf1);
+		__m256 n111 = grad3x8(gather(perm, _mm256_add_epi32(bb, inc)), xf1, yf1, zf1);
+
+		__m256 y0v = lerp8(u, n000, n100);
+		__m256 y1v = lerp8(u, n010, n110);
+		__m256 y2v = lerp8(u, n001, n101);
+		__m256 y3v = lerp8(u, n011, n111);
+
+		__m256 result = lerp8(w, lerp8(v, y0v, y1v), lerp8(v, y2v, y3v));
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(amp, result)));
+	}
+
+	for (; i < count; i++) {
+		out[i] += amplitude * noise3(perm, x[i] * frequency, y[i] * frequency, z[i] * frequency);
+	}
+}
+
+#endif
+
+void Noise::accumulate2D(const float *x, const float *z, size_t count, float frequency, float amplitude, float *out) const {
+#ifdef NOISE_AVX2
+	if (vectorized()) {
+		accumulate2DAVX2(perm.data(), x, z, count, frequency, amplitude, out);
+		return;
+	}
+#endif
+
+	for (size_t i = 0; i < count; i++) {
+		out[i] += amplitude * noise2(perm.data(), x[i] * frequency, z[i] * frequency);
+	}
+}
+
+void Noise::accumulate3D(const float *x, const float *y, const float *z, size_t count, float frequency, float amplitude, float *out) const {
+#ifdef NOISE_AVX2
+	if (vectorized()) {
+		accumulate3DAVX2(perm.data(), x, y, z, count, frequency, amplitude, out);
+		return;
+	}
+#endif
+
+	for (size_t i = 0; i < count; i++) {
+		out[i] += amplitude * noise3(perm.data(), x[i] * frequency, y[i] * frequency, z[i] * frequency);
+	}
+}
+
+static float octaveWeight(int octaves) {
+	float total = 0.0f;
+	float amplitude = 1.0f;
+	for (int o = 0; o < octaves; o++) {
+		total += amplitude;
+		amplitude *= 0.5f;
+	}
+	return 1.0f / total;
+}
+
+void Noise::fractal2D(const float *x, const float *z, size_t count, int octaves, float frequency, float *out) const {
+	float amplitude = octaveWeight(octaves);
+	for (int o = 0; o < octaves; o++) {
+		accumulate2D(x, z, count, frequency, amplitude, out);
+		frequency *= 2.0f;
+		amplitude *= 0.5f;
+	}
+}
+
+void Noise::fractal3D(const float *x, const float *y, const float *z, size_t count, int octaves, float frequency, float *out) const {
+	float amplitude = octaveWeight(octaves);
+	for (int o = 0; o < octaves; o++) {
+		accumulate3D(x, y, z, count, frequency, amplitude, out);
+		frequency *= 2.0f;
+		amplitude *= 0.5f;
+	}
+}
+
+float Noise::sample2D(float x, float z) const {
+	return noise2(perm.data(), x, z);
+}
+
+float Noise::sample3D(float x, float y, float z) const {
+	return noise3(perm.data(), x, y, z);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Seeded gradient noise evaluated over structure-of-arrays coordinate
+// batches. Every call adds amplitude * noise(coord * frequency) into out,
+// so fractal sums are a loop over octaves without temporary buffers.
+//
+// On x86 CPUs with AVX2 the batch kernels process eight samples at a time;
+// the scalar path performs the same operations in the same order and
+// this file is built without floating point contraction, so both paths
+// produce bit-identical results for a given seed.
+class Noise {
+public:
+	Noise(uint64_t seed);
+
+	void accumulate2D(const float *x, const float *z, size_t count, float frequency, float amplitude, float *out) const;
+	void accumulate3D(const float *x, const float *y, const float *z, size_t count, float frequency, float amplitude, float *out) const;
+
+	void fractal2D(const float *x, const float *z, size_t count, int octaves, float frequency, float *out) const;
+	void fractal3D(const float *x, const float *y, const float *z, size_t count, int octaves, float frequency, float *out) const;
+
+	float sample2D(float x, float z) const;
+	float sample3D(float x, float y, float z) const;
+
+	static bool vectorized();
+private:
+	alignas(32) std::array<int32_t, 512> perm;
+};
+
+uint64_t mixSeed(uint64_t seed, uint64_t salt);
@@ -0,0 +1,92 @@
+#include <world/occupancy.hpp>
+#include <world/blocks.hpp>
+
+// Low nibble of each of the four 16-bit rows in a word.
+const uint64_t BRICK_ROWS = 0x000F000F000F000Full;
+
+void SectionOccupancy::set(int x, int y, int z, bool solid) {
+	int i = Section::index(x, y, z);
+	uint64_t bit = 1ull << (i & 63);
+	if (solid) {
+		blocks[i >> 6] |= bit;
+	} else {
+		blocks[i >> 6] &= ~bit;
+	}
+
+	int by = y - y % BRICK_SIZE;
+	uint64_t mask = BRICK_ROWS << (x - x % BRICK_SIZE);
+	uint64_t any = 0;
+	for (int row = 0; row < BRICK_SIZE; row++) {
+		any |= blocks[(by + row) * (SECTION_SIZE / BRICK_SIZE) + z / BRICK_SIZE] & mask;
+	}
+
+	uint64_t brickBit = 1ull << brickIndex(x, y, z);
+	if (any) {
+		bricks |= brickBit;
+	} else {
+		bricks &= ~brickBit;
+	}
+}
+
+void SectionOccupancy::build(const Section& section) {
+	blocks.fill(0);
+	bricks = 0;
+	if (section.isEmpty()) return;
+
+	const std::vector<BlockId>& palette = section.getPalette();
+	uint32_t bits = section.bitsPerEntry();
+
+	if (bits == 0) {
+		if (isSolid(palette[0])) {
+			blocks.fill(~0ull);
+			bricks = ~0ull;
+		}
+		return;
+	}
+
+	// Decode the packed indices word by word instead of going through
+	// Section::get for every block.
+	std::vector<bool> solid(palette.size());
+	for (size_t i = 0; i < palette.size(); i++) solid[i] = isSolid(palette[i]);
+
+	const std::vector<uint64_t>& data = section.getData();
+	uint32_t perWord = 64 / bits;
+	uint64_t mask = (1ull << bits) - 1;
+	int i = 0;
+
+	for (uint64_t word : data) {
+		for (uint32_t e = 0; e < perWord; e++, i++) {
+			if (solid[(word >> (e * bits)) & mask]) blocks[i >> 6] |= 1ull << (i & 63);
+		}
+	}
+
+	for (int b = 0; b < 64; b++) {
+		int y = (b / 16) * BRICK_SIZE;
+		int z = (b / 4) % 4;
+		uint64_t rows = BRICK_ROWS << ((b % 4) * BRICK_SIZE);
+		uint64_t any = 0;
+		for (int row = 0; row < BRICK_SIZE; row++) {
+			any |= blocks[(y + row) * (SECTION_SIZE / BRICK_SIZE) + z] & rows;
+		}
+		if (any) bricks |= 1ull << b;
+	}
+}
+
+void ChunkOccupancy::set(int x, int y, int z, bool solid) {
+	int s = y / SECTION_SIZE;
+	sections[s].set(x, y % SECTION_SIZE, z, solid);
+
+	if (sections[s].isEmpty()) {
+		solidSections &= ~(1u << s);
+	} else {
+		solidSections |= 1u << s;
+	}
+}
+
+void ChunkOccupancy::build(const Chunk& chunk) {
+	solidSections = 0;
+	for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+		sections[s].build(chunk.sections[s]);
+		if (!sections[s].isEmpty()) solidSections |= 1u << s;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <world/chunk.hpp>
+#include <array>
+#include <cstdint>
+
+const int BRICK_SIZE = 4;
+
+// One bit per block of a section, set where the block is solid, plus one
+// bit per 4x4x4 brick that contains any solid block. Bits follow
+// Section::index, so a word covers four rows of one layer and a brick is
+// four nibble-aligned runs in four consecutive words.
+struct SectionOccupancy {
+	std::array<uint64_t, SECTION_VOLUME / 64> blocks;
+	uint64_t bricks;
+
+	static int brickIndex(int x, int y, int z) {
+		return ((y / BRICK_SIZE) * BRICK_SIZE + z / BRICK_SIZE) * BRICK_SIZE + x / BRICK_SIZE;
+	}
+
+	bool test(int x, int y, int z) const {
+		int i = Section::index(x, y, z);
+		return (blocks[i >> 6] >> (i & 63)) & 1;
+	}
+
+	bool brick(int x, int y, int z) const {
+		return (bricks >> brickIndex(x, y, z)) & 1;
+	}
+
+	bool isEmpty() const { return bricks == 0; }
+
+	void set(int x, int y, int z, bool solid);
+	void build(const Section& section);
+};
+
+// Occupancy of a whole chunk column. Bit y of solidSections is set when
+// section y has any solid block, so a ray can skip the column at once.
+struct ChunkOccupancy {
+	std::array<SectionOccupancy, SECTIONS_PER_CHUNK> sections;
+	uint16_t solidSections = 0;
+
+	bool test(int x, int y, int z) const {
+		return sections[y / SECTION_SIZE].test(x, y % SECTION_SIZE, z);
+	}
+
+	bool isEmpty() const { return solidSections == 0; }
+
+	void set(int x, int y, int z, bool solid);
+	void build(const Chunk& chunk);
+};
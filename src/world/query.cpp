@@ -0,0 +1,261 @@
+#include <world/query.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const int FAR = 1 << 30;
+const size_t RAY_BATCH = 256;
+const float INF = std::numeric_limits<float>::infinity();
+
+// Remembers the last chunk looked up, since consecutive lookups from one
+// ray or one box almost always land in the same column.
+class OccupancyCursor {
+public:
+	OccupancyCursor(const World& world) : world(world) {}
+
+	const ChunkOccupancy *at(int x, int z) {
+		ChunkPos pos = chunkOf(x, z);
+		if (!valid || pos != current) {
+			current = pos;
+			chunk = world.getOccupancy(pos);
+			valid = true;
+		}
+		return chunk;
+	}
+
+	bool solid(int x, int y, int z) {
+		if (y < 0 || y >= CHUNK_HEIGHT) return false;
+
+		const ChunkOccupancy *column = at(x, z);
+		return column && column->test(x & (SECTION_SIZE - 1), y, z & (SECTION_SIZE - 1));
+	}
+private:
+	const World& world;
+	ChunkPos current = {0, 0};
+	const ChunkOccupancy *chunk = nullptr;
+	bool valid = false;
+};
+
+// Finds the largest known-empty box around a block: the space above or
+// below the world, an empty chunk column, an empty section or an empty
+// brick. Returns false when the block's brick has solid blocks, in which
+// case the block itself has to be tested. Bounds are in blocks, hi
+// exclusive.
+static bool emptyRegion(OccupancyCursor& cursor, glm::ivec3 cell, glm::ivec3& lo, glm::ivec3& hi) {
+	if (cell.y < 0 || cell.y >= CHUNK_HEIGHT) {
+		lo = glm::ivec3(-FAR, cell.y < 0 ? -FAR : CHUNK_HEIGHT, -FAR);
+		hi = glm::ivec3(FAR, cell.y < 0 ? 0 : FAR, FAR);
+		return true;
+	}
+
+	glm::ivec3 chunkMin(cell.x & ~(SECTION_SIZE - 1), 0, cell.z & ~(SECTION_SIZE - 1));
+	const ChunkOccupancy *column = cursor.at(cell.x, cell.z);
+
+	if (!column || column->isEmpty()) {
+		lo = chunkMin;
+		hi = chunkMin + glm::ivec3(SECTION_SIZE, CHUNK_HEIGHT, SECTION_SIZE);
+		return true;
+	}
+
+	const SectionOccupancy& section = column->sections[cell.y / SECTION_SIZE];
+	glm::ivec3 local(cell.x - chunkMin.x, cell.y & (SECTION_SIZE - 1), cell.z - chunkMin.z);
+
+	if (section.isEmpty()) {
+		lo = glm::ivec3(chunkMin.x, cell.y - local.y, chunkMin.z);
+		hi = lo + SECTION_SIZE;
+		return true;
+	}
+
+	if (!section.brick(local.x, local.y, local.z)) {
+		lo = cell - local % BRICK_SIZE;
+		hi = lo + BRICK_SIZE;
+		return true;
+	}
+
+	return false;
+}
+
+static RayHit cast(OccupancyCursor& cursor, const Ray& ray) {
+	const glm::vec3& o = ray.origin;
+	const glm::vec3& d = ray.direction;
+
+	glm::ivec3 cell(glm::floor(o));
+	glm::ivec3 step;
+	glm::vec3 tDelta;
+	glm::vec3 tMax;
+
+	for (int a = 0; a < 3; a++) {
+		step[a] = d[a] > 0.0f ? 1 : d[a] < 0.0f ? -1 : 0;
+		tDelta[a] = step[a] != 0 ? 1.0f / std::fabs(d[a]) : INF;
+	}
+
+	auto boundaries = [&] {
+		for (int a = 0; a < 3; a++) {
+			if (step[a] == 0) {
+				tMax[a] = INF;
+			} else {
+				float bound = static_cast<float>(step[a] > 0 ? cell[a] + 1 : cell[a]);
+				tMax[a] = (bound - o[a]) / d[a];
+			}
+		}
+	};
+	boundaries();
+
+	RayHit result;
+	float t = 0.0f;
+	int axis = -1;
+
+	while (t <= ray.maxDistance) {
+		glm::ivec3 lo, hi;
+
+		if (emptyRegion(cursor, cell, lo, hi)) {
+			float exit = INF;
+			int exitAxis = -1;
+			for (int a = 0; a < 3; a++) {
+				if (step[a] == 0) continue;
+
+				float bound = static_cast<float>(step[a] > 0 ? hi[a] : lo[a]);
+				float te = (bound - o[a]) / d[a];
+				if (te < exit) {
+					exit = te;
+					exitAxis = a;
+				}
+			}
+			if (exitAxis < 0) break;
+
+			// The exit axis lands exactly on the next block; the others
+			// are clamped into the box to absorb rounding.
+			t = std::max(t, exit);
+			glm::vec3 p = o + d * t;
+			for (int a = 0; a < 3; a++) {
+				if (a == exitAxis) {
+					cell[a] = step[a] > 0 ? hi[a] : lo[a] - 1;
+				} else {
+					cell[a] = std::clamp(static_cast<int>(std::floor(p[a])), lo[a], hi[a] - 1);
+				}
+			}
+			axis = exitAxis;
+			boundaries();
+			continue;
+		}
+
+		if (cursor.solid(cell.x, cell.y, cell.z)) {
+			result.hit = true;
+			result.block = cell;
+			if (axis >= 0) result.normal[axis] = -step[axis];
+			result.distance = t;
+			return result;
+		}
+
+		axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+		t = tMax[axis];
+		cell[axis] += step[axis];
+		tMax[axis] += tDelta[axis];
+	}
+
+	return result;
+}
+
+bool isSolidAt(const World& world, int x, int y, int z) {
+	OccupancyCursor cursor(world);
+	return cursor.solid(x, y, z);
+}
+
+RayHit raycast(const World& world, const Ray& ray) {
+	OccupancyCursor cursor(world);
+	return cast(cursor, ray);
+}
+
+void raycast(const World& world, const Ray *rays, size_t count, RayHit *hits) {
+	OccupancyCursor cursor(world);
+	for (size_t i = 0; i < count; i++) {
+		hits[i] = cast(cursor, rays[i]);
+	}
+}
+
+void raycast(const World& world, const std::vector<Ray>& rays, std::vector<RayHit>& hits, JobSystem& jobs) {
+	hits.resize(rays.size());
+
+	size_t batches = (rays.size() + RAY_BATCH - 1) / RAY_BATCH;
+	jobs.parallelFor(batches, [&](size_t b) {
+		size_t first = b * RAY_BATCH;
+		size_t count = std::min(RAY_BATCH, rays.size() - first);
+		raycast(world, rays.data() + first, count, hits.data() + first);
+	});
+}
+
+// Blocks overlapping the open interval (min, max) along one axis.
+static int firstBlock(float min) {
+	return static_cast<int>(std::floor(min));
+}
+
+static int lastBlock(float max) {
+	return static_cast<int>(std::ceil(max)) - 1;
+}
+
+bool intersectsSolid(const World& world, const AABB& box) {
+	OccupancyCursor cursor(world);
+
+	for (int y = firstBlock(box.min.y); y <= lastBlock(box.max.y); y++) {
+		for (int z = firstBlock(box.min.z); z <= lastBlock(box.max.z); z++) {
+			for (int x = firstBlock(box.min.x); x <= lastBlock(box.max.x); x++) {
+				if (cursor.solid(x, y, z)) return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Clips the motion of the box along one axis against the first layer of
+// blocks that its leading face would enter.
+static float clipAxis(OccupancyCursor& cursor, const AABB& box, int axis, float motion, bool& collided) {
+	if (motion == 0.0f) return motion;
+
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+
+	int first, last, dir;
+	if (motion > 0.0f) {
+		first = static_cast<int>(std::ceil(box.max[axis]));
+		last = static_cast<int>(std::ceil(box.max[axis] + motion)) - 1;
+		dir = 1;
+	} else {
+		first = static_cast<int>(std::floor(box.min[axis])) - 1;
+		last = static_cast<int>(std::floor(box.min[axis] + motion));
+		dir = -1;
+	}
+
+	glm::ivec3 cell;
+	for (int layer = first; dir > 0 ? layer <= last : layer >= last; layer += dir) {
+		cell[axis] = layer;
+
+		for (cell[u] = firstBlock(box.min[u]); cell[u] <= lastBlock(box.max[u]); cell[u]++) {
+			for (cell[v] = firstBlock(box.min[v]); cell[v] <= lastBlock(box.max[v]); cell[v]++) {
+				if (!cursor.solid(cell.x, cell.y, cell.z)) continue;
+
+				collided = true;
+				return dir > 0 ? static_cast<float>(layer) - box.max[axis] : static_cast<float>(layer + 1) - box.min[axis];
+			}
+		}
+	}
+
+	return motion;
+}
+
+SweepResult sweep(const World& world, const AABB& box, glm::vec3 motion) {
+	OccupancyCursor cursor(world);
+	SweepResult result{glm::vec3(0.0f), glm::bvec3(false)};
+	AABB moved = box;
+
+	// Vertical first, so walking off a ledge or into a wall while falling
+	// behaves the same as on the ground.
+	for (int axis : {1, 0, 2}) {
+		float allowed = clipAxis(cursor, moved, axis, motion[axis], result.collided[axis]);
+		moved.min[axis] += allowed;
+		moved.max[axis] += allowed;
+		result.motion[axis] = allowed;
+	}
+
+	return result;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <world/world.hpp>
+#include <core/jobs.hpp>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Direction must be normalized; distances are in blocks.
+struct Ray {
+	glm::vec3 origin;
+	glm::vec3 direction;
+	float maxDistance;
+};
+
+struct RayHit {
+	bool hit = false;
+	glm::ivec3 block = glm::ivec3(0);
+	// Face the ray entered through; zero when the ray starts inside a block.
+	glm::ivec3 normal = glm::ivec3(0);
+	float distance = 0.0f;
+};
+
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+struct SweepResult {
+	// The part of the requested motion that fits before touching a block.
+	glm::vec3 motion;
+	glm::bvec3 collided;
+};
+
+// Spatial queries against the solid blocks of a world, answered from the
+// occupancy masks the world keeps up to date. Unloaded chunks and space
+// above or below the world count as empty.
+//
+// Raycasts are Amanatides-Woo voxel walks that jump across empty chunk
+// columns, sections and 4x4x4 bricks in one step, so a ray through open
+// air costs a handful of iterations instead of one per block.
+bool isSolidAt(const World& world, int x, int y, int z);
+
+RayHit raycast(const World& world, const Ray& ray);
+void raycast(const World& world, const Ray *rays, size_t count, RayHit *hits);
+void raycast(const World& world, const std::vector<Ray>& rays, std::vector<RayHit>& hits, JobSystem& jobs);
+
+bool intersectsSolid(const World& world, const AABB& box);
+
+// Moves the box along Y, then X, then Z, clipping each axis against the
+// blocks in the way. A box that already overlaps a block is not pushed
+// out of it.
+SweepResult sweep(const World& world, const AABB& box, glm::vec3 motion);
@@ -0,0 +1,307 @@
+#include <world/region.hpp>
+#include <world/chunk_codec.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+uint32_t sectorsFor(size_t length) {
+	return static_cast<uint32_t>((length + SECTOR_SIZE - 1) / SECTOR_SIZE);
+}
+
+ChunkPos regionOf(ChunkPos pos) {
+	return {pos.x >> 5, pos.z >> 5};
+}
+
+static fs::path regionPath(const fs::path& directory, ChunkPos region) {
+	return directory / ("r." + std::to_string(region.x) + "." + std::to_string(region.z) + ".region");
+}
+
+static uint64_t now() {
+	return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+RegionFile::RegionFile(fs::path path) : path(path) {
+	open();
+}
+
+RegionFile::~RegionFile() {
+	close();
+}
+
+int RegionFile::index(ChunkPos pos) {
+	return (pos.x & (REGION_SIZE - 1)) + (pos.z & (REGION_SIZE - 1)) * REGION_SIZE;
+}
+
+void RegionFile::open() {
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		throw std::runtime_error("failed to open region file!");
+	}
+
+	struct stat info;
+	fstat(fd, &info);
+	size_t size = static_cast<size_t>(info.st_size);
+
+	if (size < REGION_HEADER_SIZE) {
+		header.fill({0, 0, 0});
+		writeAt(header.data(), REGION_HEADER_SIZE, 0);
+		size = REGION_HEADER_SIZE;
+	} else if (pread(fd, header.data(), REGION_HEADER_SIZE, 0) != static_cast<ssize_t>(REGION_HEADER_SIZE)) {
+		throw std::runtime_error("failed to read region header!");
+	}
+
+	sectorCount = sectorsFor(size);
+
+	// Entries pointing past the end of the file come from a write that
+	// was interrupted before its payload landed; treat them as missing.
+	for (auto& entry : header) {
+		if (entry.length == 0) continue;
+		if (entry.sector < REGION_HEADER_SECTORS || entry.sector + sectorsFor(entry.length) > sectorCount) {
+			entry = {0, 0, 0};
+		}
+	}
+
+	map();
+}
+
+void RegionFile::close() {
+	unmap();
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+}
+
+void RegionFile::map() {
+	unmap();
+
+	struct stat info;
+	fstat(fd, &info);
+	mappedSize = static_cast<size_t>(info.st_size);
+
+	void *data = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		mappedSize = 0;
+		throw std::runtime_error("failed to map region file!");
+	}
+
+	madvise(data, mappedSize, MADV_RANDOM);
+	mapped = static_cast<uint8_t *>(data);
+}
+
+void RegionFile::unmap() {
+	if (mapped) {
+		munmap(mapped, mappedSize);
+		mapped = nullptr;
+		mappedSize = 0;
+	}
+}
+
+void RegionFile::writeAt(const void *data, size_t size, size_t offset) {
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+	while (size > 0) {
+		ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+		if (written <= 0) {
+			throw std::runtime_error("failed to write region file!");
+		}
+		bytes += written;
+		offset += written;
+		size -= written;
+	}
+}
+
+bool RegionFile::contains(ChunkPos pos) const {
+	return header[index(pos)].length != 0;
+}
+
+const RegionEntry& RegionFile::entry(ChunkPos pos) const {
+	return header[index(pos)];
+}
+
+uint32_t RegionFile::usedSectors() const {
+	uint32_t used = REGION_HEADER_SECTORS;
+	for (const auto& entry : header) used += sectorsFor(entry.length);
+	return used;
+}
+
+bool RegionFile::read(ChunkPos pos, Chunk& chunk) {
+	std::lock_guard<std::mutex> lock(mutex);
+	const RegionEntry& e = header[index(pos)];
+	if (e.length == 0) return false;
+
+	size_t offset = static_cast<size_t>(e.sector) * SECTOR_SIZE;
+	if (offset + e.length > mappedSize) map();
+
+	decodeChunk(mapped + offset, e.length, chunk);
+	return true;
+}
+
+void RegionFile::write(const Chunk& chunk) {
+	writePayload(chunk.pos, encodeChunk(chunk), now());
+}
+
+void RegionFile::writePayload(ChunkPos pos, const std::vector<uint8_t>& payload, uint64_t timestamp) {
+	std::lock_guard<std::mutex> lock(mutex);
+	int i = index(pos);
+	RegionEntry previous = header[i];
+	RegionEntry e;
+	e.sector = allocate(sectorsFor(payload.size()));
+	e.length = static_cast<uint32_t>(payload.size());
+	e.timestamp = timestamp;
+
+	writeAt(payload.data(), payload.size(), static_cast<size_t>(e.sector) * SECTOR_SIZE);
+
+	size_t fileSize = static_cast<size_t>(sectorCount) * SECTOR_SIZE;
+	struct stat info;
+	fstat(fd, &info);
+	if (static_cast<size_t>(info.st_size) < fileSize && ftruncate(fd, static_cast<off_t>(fileSize)) != 0) {
+		throw std::runtime_error("failed to grow region file!");
+	}
+
+	// The payload is on disk before the header entry points at it, so an
+	// interrupted write leaves the previous copy reachable. The same sync
+	// makes every earlier header write durable, so sectors they released
+	// can be handed out again from here on.
+	if (fdatasync(fd) != 0) {
+		throw std::runtime_error("failed to sync region file!");
+	}
+	released.clear();
+
+	header[i] = e;
+	writeAt(&header[i], sizeof(RegionEntry), i * sizeof(RegionEntry));
+	if (previous.length != 0) released.push_back({previous.sector, sectorsFor(previous.length)});
+}
+
+// First run of sectors no header entry uses, including the one about to
+// be replaced, and that no header on disk may still point at; past the
+// end of the file when no gap is big enough.
+uint32_t RegionFile::allocate(uint32_t sectors) {
+	std::vector<bool> used(sectorCount, false);
+	auto reserve = [&](uint32_t start, uint32_t count) {
+		uint32_t end = std::min(start + count, sectorCount);
+		for (uint32_t sector = start; sector < end; sector++) used[sector] = true;
+	};
+	for (const auto& entry : header) {
+		if (entry.length != 0) reserve(entry.sector, sectorsFor(entry.length));
+	}
+	for (const auto& [start, count] : released) reserve(start, count);
+
+	uint32_t run = 0;
+	for (uint32_t sector = REGION_HEADER_SECTORS; sector < sectorCount; sector++) {
+		run = used[sector] ? 0 : run + 1;
+		if (run == sectors) return sector + 1 - sectors;
+	}
+
+	uint32_t start = sectorCount;
+	sectorCount += sectors;
+	return start;
+}
+
+void RegionFile::compact() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (usedSectors() == sectorCount) return;
+
+	fs::path tmpPath = path;
+	tmpPath += ".tmp";
+
+	int out = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (out < 0) {
+		throw std::runtime_error("failed to create compacted region file!");
+	}
+
+	if (mappedSize < static_cast<size_t>(sectorCount) * SECTOR_SIZE) map();
+
+	std::array<RegionEntry, REGION_CHUNKS> compacted;
+	uint32_t next = REGION_HEADER_SECTORS;
+	std::vector<uint8_t> padded;
+
+	for (int i = 0; i < REGION_CHUNKS; i++) {
+		const RegionEntry& e = header[i];
+		if (e.length == 0) {
+			compacted[i] = {0, 0, 0};
+			continue;
+		}
+
+		uint32_t sectors = sectorsFor(e.length);
+		padded.assign(static_cast<size_t>(sectors) * SECTOR_SIZE, 0);
+		memcpy(padded.data(), mapped + static_cast<size_t>(e.sector) * SECTOR_SIZE, e.length);
+
+		if (pwrite(out, padded.data(), padded.size(), static_cast<off_t>(next) * SECTOR_SIZE) != static_cast<ssize_t>(padded.size())) {
+			::close(out);
+			throw std::runtime_error("failed to write compacted region file!");
+		}
+
+		compacted[i] = {next, e.length, e.timestamp};
+		next += sectors;
+	}
+
+	if (pwrite(out, compacted.data(), REGION_HEADER_SIZE, 0) != static_cast<ssize_t>(REGION_HEADER_SIZE) || fsync(out) != 0) {
+		::close(out);
+		throw std::runtime_error("failed to write compacted region file!");
+	}
+	::close(out);
+
+	close();
+	fs::rename(tmpPath, path);
+	released.clear();
+	open();
+}
+
+RegionStorage::RegionStorage(fs::path directory) : directory(directory) {
+	fs::create_directories(directory);
+}
+
+RegionFile& RegionStorage::region(ChunkPos pos) {
+	std::lock_guard<std::mutex> lock(mutex);
+	ChunkPos r = regionOf(pos);
+	auto it = regions.find(r);
+	if (it != regions.end()) return *it->second;
+
+	auto file = std::make_unique<RegionFile>(regionPath(directory, r));
+	return *regions.emplace(r, std::move(file)).first->second;
+}
+
+bool RegionStorage::exists(ChunkPos pos) {
+	std::lock_guard<std::mutex> lock(mutex);
+	ChunkPos r = regionOf(pos);
+	return regions.count(r) != 0 || fs::exists(regionPath(directory, r));
+}
+
+bool RegionStorage::loadChunk(ChunkPos pos, Chunk& chunk) {
+	if (!exists(pos)) return false;
+	return region(pos).read(pos, chunk);
+}
+
+void RegionStorage::saveChunk(const Chunk& chunk) {
+	region(chunk.pos).write(chunk);
+}
+
+void RegionStorage::savePayload(ChunkPos pos, const std::vector<uint8_t>& payload) {
+	region(pos).writePayload(pos, payload, now());
+}
+
+void RegionStorage::compact() {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& [r, file] : regions) file->compact();
+
+	for (const auto& item : fs::directory_iterator(directory)) {
+		if (item.path().extension() != ".region") continue;
+
+		int x, z;
+		if (sscanf(item.path().filename().c_str(), "r.%d.%d.region", &x, &z) != 2) continue;
+		if (regions.count({x, z})) continue;
+
+		RegionFile(item.path()).compact();
+	}
+}
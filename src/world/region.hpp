@@ -0,0 +1,95 @@
+#pragma once
+
+#include <world/chunk.hpp>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+const int REGION_SIZE = 32;
+const int REGION_CHUNKS = REGION_SIZE * REGION_SIZE;
+const size_t SECTOR_SIZE = 4096;
+
+struct RegionEntry {
+	uint32_t sector;
+	uint32_t length;
+	uint64_t timestamp;
+};
+
+const size_t REGION_HEADER_SIZE = REGION_CHUNKS * sizeof(RegionEntry);
+const uint32_t REGION_HEADER_SECTORS = REGION_HEADER_SIZE / SECTOR_SIZE;
+
+// One file holding a 32x32 chunk area. The header is a fixed table of
+// (sector, length, timestamp) per chunk and payloads start on sector
+// boundaries. Reads decode straight out of a read-only mapping. A write
+// never touches the sectors its chunk is stored in: it goes to the first
+// free gap that fits, or the end of the file, is synced, and only then is
+// the header entry switched over. Sectors a write releases are not reused
+// until the next sync has made the new entry durable, so a crash leaves
+// either copy intact. Gaps left behind are reused by later writes or
+// reclaimed by compact(). All operations lock the file, so saves can run
+// on worker threads.
+class RegionFile {
+public:
+	RegionFile(std::filesystem::path path);
+	~RegionFile();
+
+	RegionFile(const RegionFile&) = delete;
+	RegionFile& operator=(const RegionFile&) = delete;
+
+	static int index(ChunkPos pos);
+
+	bool contains(ChunkPos pos) const;
+	const RegionEntry& entry(ChunkPos pos) const;
+	bool read(ChunkPos pos, Chunk& chunk);
+	void write(const Chunk& chunk);
+	void writePayload(ChunkPos pos, const std::vector<uint8_t>& payload, uint64_t timestamp);
+	void compact();
+
+	uint32_t totalSectors() const { return sectorCount; }
+	uint32_t usedSectors() const;
+private:
+	std::filesystem::path path;
+	std::mutex mutex;
+	int fd = -1;
+	std::array<RegionEntry, REGION_CHUNKS> header;
+	uint32_t sectorCount = 0;
+	// (sector, count) of payloads replaced since the last sync.
+	std::vector<std::pair<uint32_t, uint32_t>> released;
+
+	uint8_t *mapped = nullptr;
+	size_t mappedSize = 0;
+
+	void open();
+	void close();
+	void map();
+	void unmap();
+	void writeAt(const void *data, size_t size, size_t offset);
+	uint32_t allocate(uint32_t sectors);
+};
+
+// Keeps the open region files of one world directory, named
+// r.<x>.<z>.region after their region coordinates.
+class RegionStorage {
+public:
+	RegionStorage(std::filesystem::path directory);
+
+	bool loadChunk(ChunkPos pos, Chunk& chunk);
+	void saveChunk(const Chunk& chunk);
+	void savePayload(ChunkPos pos, const std::vector<uint8_t>& payload);
+	void compact();
+private:
+	std::filesystem::path directory;
+	std::mutex mutex;
+	std::unordered_map<ChunkPos, std::unique_ptr<RegionFile>, ChunkPosHash> regions;
+
+	RegionFile& region(ChunkPos pos);
+	bool exists(ChunkPos pos);
+};
+
+uint32_t sectorsFor(size_t length);
+ChunkPos regionOf(ChunkPos pos);
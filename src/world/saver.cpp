@@ -0,0 +1,79 @@
+#include <world/saver.hpp>
+#include <world/chunk_codec.hpp>
+#include <iostream>
+
+WorldSaver::WorldSaver(RegionStorage& storage, JobSystem& jobs) : storage(storage), jobs(jobs) {}
+
+WorldSaver::~WorldSaver() {
+	wait();
+}
+
+void WorldSaver::wait() {
+	group.wait();
+	pending.clear();
+}
+
+bool WorldSaver::snapshot(World& world) {
+	// A chunk must not have two saves in flight, or an older snapshot
+	// could land on disk after a newer one. Unsaved chunks simply wait
+	// for the next autosave.
+	if (busy()) return false;
+	retryFailed(world);
+	start(world, world.takeUnsaved());
+	return true;
+}
+
+bool WorldSaver::save(World& world, const std::vector<ChunkPos>& positions) {
+	if (busy()) return false;
+	retryFailed(world);
+	start(world, world.takeUnsaved(positions));
+	return true;
+}
+
+// Chunks whose write threw are unsaved again, so the next save picks
+// them up instead of the world silently losing them.
+void WorldSaver::retryFailed(World& world) {
+	std::lock_guard<std::mutex> lock(failedMutex);
+	if (failed.empty()) return;
+
+	std::cout << "failed to save " << failed.size() << " chunks, kept them unsaved: " << failedError << std::endl;
+	for (ChunkPos pos : failed) world.markUnsaved(pos);
+	failed.clear();
+}
+
+void WorldSaver::start(World& world, const std::vector<ChunkPos>& positions) {
+	pending.clear();
+	for (ChunkPos pos : positions) {
+		const Chunk *chunk = world.getChunk(pos);
+		if (chunk) pending.push_back(*chunk);
+	}
+
+	savedChunks = pending.size();
+
+	for (size_t i = 0; i < pending.size(); i++) {
+		jobs.submitBackground([this, i] {
+			// Taking the snapshot out of the list drops its section
+			// references as soon as it is written, so the live chunk stops
+			// cloning on write without waiting for the next snapshot.
+			Chunk chunk = std::move(pending[i]);
+			try {
+				storage.savePayload(chunk.pos, encodeChunk(chunk));
+			} catch (std::exception& err) {
+				std::lock_guard<std::mutex> lock(failedMutex);
+				failed.push_back(chunk.pos);
+				failedError = err.what();
+			}
+		}, &group);
+	}
+}
+
+void WorldSaver::flush(World& world) {
+	wait();
+	snapshot(world);
+	wait();
+	// The second snapshot retries whatever the first could not write;
+	// chunks that fail again are reported and left unsaved.
+	snapshot(world);
+	wait();
+	retryFailed(world);
+}
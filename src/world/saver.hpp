@@ -0,0 +1,42 @@
+#pragma once
+
+#include <core/jobs.hpp>
+#include <world/chunk.hpp>
+#include <world/region.hpp>
+#include <world/world.hpp>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Saves the world without stalling the tick. snapshot() runs at a tick
+// boundary and only copies unsaved chunks, which shares their section
+// storage; encoding and writing then happen as background jobs while the
+// live chunks clone any section they write to. A chunk that fails to
+// write is marked unsaved again at the next save.
+class WorldSaver {
+public:
+	WorldSaver(RegionStorage& storage, JobSystem& jobs);
+	~WorldSaver();
+
+	bool snapshot(World& world);
+	// Like snapshot, but only saves those of positions that are unsaved.
+	bool save(World& world, const std::vector<ChunkPos>& positions);
+	void flush(World& world);
+	bool busy() const { return !group.done(); }
+	void wait();
+
+	size_t lastSavedChunks() const { return savedChunks; }
+private:
+	RegionStorage& storage;
+	JobSystem& jobs;
+	JobGroup group;
+	std::vector<Chunk> pending;
+	size_t savedChunks = 0;
+	std::mutex failedMutex;
+	std::vector<ChunkPos> failed;
+	std::string failedError;
+
+	void retryFailed(World& world);
+	void start(World& world, const std::vector<ChunkPos>& positions);
+};
@@ -0,0 +1,209 @@
+#include <world/ticks.hpp>
+#include <world/blocks.hpp>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+// Everything one region does in a tick; written only by its worker.
+struct BlockTicker::Region {
+	ChunkPos pos;
+	std::vector<std::pair<ChunkPos, ChunkUpdates *>> chunks;
+	std::vector<SectionPos> sections;
+	std::vector<BlockChange> changes;
+	RegionTickStats stats;
+};
+
+static int tickRegionOf(int chunk) {
+	return chunk >= 0 ? chunk / TICK_REGION_CHUNKS : (chunk + 1) / TICK_REGION_CHUNKS - 1;
+}
+
+static bool chunkBefore(ChunkPos a, ChunkPos b) {
+	return a.x != b.x ? a.x < b.x : a.z < b.z;
+}
+
+static uint16_t blockIndex(int x, int y, int z) {
+	return static_cast<uint16_t>((y * SECTION_SIZE + (z & (SECTION_SIZE - 1))) * SECTION_SIZE + (x & (SECTION_SIZE - 1)));
+}
+
+static uint64_t mix(uint64_t value) {
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebULL;
+	return value ^ (value >> 31);
+}
+
+// Sand falls through air and sinks through water, one block per update;
+// the blocks it leaves schedule the sand above.
+static void scheduledUpdate(const World& world, BlockPos pos, std::vector<BlockChange>& changes) {
+	BlockId id = world.getBlock(pos.x, pos.y, pos.z);
+	if (id == SAND && pos.y > 0) {
+		BlockId below = world.getBlock(pos.x, pos.y - 1, pos.z);
+		if (below == AIR || below == WATER) {
+			changes.push_back({pos, below});
+			changes.push_back({{pos.x, pos.y - 1, pos.z}, SAND});
+		}
+	}
+}
+
+// Covered grass dies back to dirt; uncovered grass spreads to a random
+// nearby dirt block with nothing opaque on top. Random ticks only peek,
+// so they neither keep chunks from going cold nor thaw cold neighbours.
+static void randomTick(const World& world, BlockPos pos, BlockId id, std::mt19937_64& random, std::vector<BlockChange>& changes) {
+	if (id == GRASS) {
+		if (isOpaque(world.peekBlock(pos.x, pos.y + 1, pos.z))) {
+			changes.push_back({pos, DIRT});
+			return;
+		}
+
+		uint64_t bits = random();
+		int x = pos.x + static_cast<int>(bits % 3) - 1;
+		int y = pos.y + static_cast<int>(bits / 3 % 5) - 3;
+		int z = pos.z + static_cast<int>(bits / 15 % 3) - 1;
+		if (world.peekBlock(x, y, z) == DIRT && !isOpaque(world.peekBlock(x, y + 1, z))) {
+			changes.push_back({{x, y, z}, GRASS});
+		}
+	}
+}
+
+BlockTicker::BlockTicker(uint64_t seed) : seed(seed) {}
+
+void BlockTicker::schedule(BlockPos pos, uint32_t delay) {
+	if (pos.y < 0 || pos.y >= CHUNK_HEIGHT) return;
+
+	std::unique_ptr<ChunkUpdates>& updates = chunks[chunkOf(pos.x, pos.z)];
+	if (!updates) updates = std::make_unique<ChunkUpdates>();
+
+	uint16_t block = blockIndex(pos.x, pos.y, pos.z);
+	if (updates->queued[block]) return;
+
+	uint64_t due = now + std::max<uint32_t>(delay, 1);
+	updates->wheel[due % TICK_WHEEL_SLOTS].push_back({due, block});
+	updates->queued[block] = true;
+	updates->count++;
+	pending++;
+}
+
+void BlockTicker::tick(World& world, JobSystem& jobs) {
+	now++;
+	applied.clear();
+	regions.clear();
+
+	// An edit wakes up the block itself and its six neighbours.
+	const int around[7][3] = {{0, 0, 0}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+	for (BlockPos edit : world.takeBlockEdits()) {
+		for (const auto& offset : around) {
+			BlockPos pos = {edit.x + offset[0], edit.y + offset[1], edit.z + offset[2]};
+			BlockId id = world.getBlock(pos.x, pos.y, pos.z);
+			if (hasScheduledUpdates(id)) schedule(pos, updateDelay(id));
+		}
+	}
+
+	// Updates for chunks that were unloaded are dropped with them.
+	for (auto it = chunks.begin(); it != chunks.end();) {
+		if (!world.getChunk(it->first)) {
+			pending -= it->second->count;
+			it = chunks.erase(it);
+		} else {
+			it++;
+		}
+	}
+
+	size_t slot = now % TICK_WHEEL_SLOTS;
+	std::unordered_map<ChunkPos, Region, ChunkPosHash> work;
+	for (auto& [pos, updates] : chunks) {
+		if (updates->wheel[slot].empty()) continue;
+		work[{tickRegionOf(pos.x), tickRegionOf(pos.z)}].chunks.emplace_back(pos, updates.get());
+	}
+	for (SectionPos section : world.getTickingSections()) {
+		work[{tickRegionOf(section.x), tickRegionOf(section.z)}].sections.push_back(section);
+	}
+	if (work.empty()) return;
+
+	std::vector<Region *> ordered;
+	for (auto& [pos, region] : work) {
+		region.pos = pos;
+		ordered.push_back(&region);
+	}
+	std::sort(ordered.begin(), ordered.end(), [](const Region *a, const Region *b) { return chunkBefore(a->pos, b->pos); });
+
+	jobs.parallelFor(ordered.size(), [&](size_t i) {
+		runRegion(*ordered[i], world, slot);
+	});
+
+	for (Region *region : ordered) {
+		for (const BlockChange& change : region->changes) {
+			if (!world.getChunk(chunkOf(change.pos.x, change.pos.z))) continue;
+			if (world.getBlock(change.pos.x, change.pos.y, change.pos.z) == change.id) continue;
+
+			world.setBlock(change.pos.x, change.pos.y, change.pos.z, change.id);
+			applied.push_back(change);
+			region->stats.changes++;
+		}
+		pending -= region->stats.scheduledUpdates;
+		regions.push_back(region->stats);
+	}
+
+	for (auto it = chunks.begin(); it != chunks.end();) {
+		if (it->second->count == 0) {
+			it = chunks.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+void BlockTicker::runRegion(Region& region, const World& world, size_t slot) {
+	auto start = std::chrono::steady_clock::now();
+	region.stats.region = region.pos;
+
+	std::sort(region.chunks.begin(), region.chunks.end(), [](const auto& a, const auto& b) { return chunkBefore(a.first, b.first); });
+	for (auto& [pos, updates] : region.chunks) {
+		std::vector<PendingUpdate>& due = updates->wheel[slot];
+
+		// Runs in the order they were scheduled; later turns stay put.
+		size_t kept = 0;
+		for (const PendingUpdate& update : due) {
+			if (update.due != now) {
+				due[kept++] = update;
+				continue;
+			}
+
+			updates->queued[update.block] = false;
+			updates->count--;
+			int x = update.block % SECTION_SIZE;
+			int z = update.block / SECTION_SIZE % SECTION_SIZE;
+			int y = update.block / (SECTION_SIZE * SECTION_SIZE);
+			scheduledUpdate(world, {pos.x * SECTION_SIZE + x, y, pos.z * SECTION_SIZE + z}, region.changes);
+			region.stats.scheduledUpdates++;
+		}
+		due.resize(kept);
+	}
+
+	uint64_t regionKey = (static_cast<uint64_t>(static_cast<uint32_t>(region.pos.x)) << 32) | static_cast<uint32_t>(region.pos.z);
+	std::mt19937_64 random(mix(seed ^ mix(now ^ mix(regionKey))));
+	std::sort(region.sections.begin(), region.sections.end(), [](SectionPos a, SectionPos b) {
+		if (a.x != b.x) return a.x < b.x;
+		if (a.z != b.z) return a.z < b.z;
+		return a.y < b.y;
+	});
+	for (SectionPos pos : region.sections) {
+		const Chunk *chunk = world.peekChunk({pos.x, pos.z});
+		if (!chunk) continue;
+
+		const Section& section = chunk->sections[pos.y];
+		for (int sample = 0; sample < RANDOM_TICKS_PER_SECTION; sample++) {
+			int index = static_cast<int>(random() % SECTION_VOLUME);
+			BlockId id = section.get(index);
+			if (!ticksRandomly(id)) continue;
+
+			int x = index % SECTION_SIZE;
+			int z = index / SECTION_SIZE % SECTION_SIZE;
+			int y = index / (SECTION_SIZE * SECTION_SIZE);
+			randomTick(world, {pos.x * SECTION_SIZE + x, pos.y * SECTION_SIZE + y, pos.z * SECTION_SIZE + z}, id, random, region.changes);
+			region.stats.randomTicks++;
+		}
+	}
+
+	region.stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <core/jobs.hpp>
+#include <world/chunk.hpp>
+#include <world/world.hpp>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Ticks per turn of a chunk's timing wheel. Updates due further out sit
+// in their slot for more turns.
+const uint32_t TICK_WHEEL_SLOTS = 64;
+// Blocks sampled per tick in each section with randomly ticking blocks.
+const int RANDOM_TICKS_PER_SECTION = 3;
+// Chunks per side of the regions that tick in parallel.
+const int TICK_REGION_CHUNKS = 4;
+
+struct BlockChange {
+	BlockPos pos;
+	BlockId id;
+};
+
+struct RegionTickStats {
+	ChunkPos region;
+	uint32_t scheduledUpdates = 0;
+	uint32_t randomTicks = 0;
+	uint32_t changes = 0;
+	double milliseconds = 0.0;
+};
+
+// Runs block updates once per simulation tick. Blocks with scheduled
+// updates are queued when they or a neighbour change, in a timing wheel
+// per chunk that only exists while the chunk has updates pending, and
+// random ticks sample only the sections World lists as having randomly
+// ticking blocks, and skip cold chunks, so a tick costs what is happening
+// rather than what is loaded.
+//
+// Regions of TICK_REGION_CHUNKS chunks run in parallel against the world
+// as it was at the start of the tick and only collect the changes they
+// want. The changes are then applied one region at a time in region
+// order, so updates that reach across a border resolve the same way
+// however the regions were scheduled. Random ticks are seeded per region
+// and tick, which makes the whole tick deterministic.
+class BlockTicker {
+public:
+	explicit BlockTicker(uint64_t seed);
+
+	// Queues an update delay ticks from now, at least one; a block already
+	// queued keeps its earlier update.
+	void schedule(BlockPos pos, uint32_t delay);
+	void tick(World& world, JobSystem& jobs);
+
+	uint64_t currentTick() const { return now; }
+	size_t pendingUpdates() const { return pending; }
+	// Changes the last tick applied, in order, for sending to clients.
+	const std::vector<BlockChange>& changes() const { return applied; }
+	// Only regions that had work in the last tick.
+	const std::vector<RegionTickStats>& regionStats() const { return regions; }
+private:
+	struct PendingUpdate {
+		uint64_t due;
+		uint16_t block;
+	};
+
+	struct ChunkUpdates {
+		std::array<std::vector<PendingUpdate>, TICK_WHEEL_SLOTS> wheel;
+		std::bitset<SECTION_SIZE * SECTION_SIZE * CHUNK_HEIGHT> queued;
+		size_t count = 0;
+	};
+
+	struct Region;
+
+	uint64_t seed;
+	uint64_t now = 0;
+	size_t pending = 0;
+	std::unordered_map<ChunkPos, std::unique_ptr<ChunkUpdates>, ChunkPosHash> chunks;
+	std::vector<BlockChange> applied;
+	std::vector<RegionTickStats> regions;
+
+	void runRegion(Region& region, const World& world, size_t slot);
+};
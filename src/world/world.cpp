@@ -0,0 +1,289 @@
+#include <world/world.hpp>
+#include <world/blocks.hpp>
+#include <world/chunk_codec.hpp>
+#include <world/compression.hpp>
+#include <algorithm>
+#include <chrono>
+
+ChunkPos chunkOf(int x, int z) {
+	return {x >> 4, z >> 4};
+}
+
+SectionPos sectionOf(int x, int y, int z) {
+	return {x >> 4, y >> 4, z >> 4};
+}
+
+// Thawing changes nothing a caller can observe, so const lookups do it
+// too. Only the first lookup of a tick writes the stamp, which keeps
+// parallel readers from contending on it.
+World::LoadedChunk *World::use(ChunkPos pos) const {
+	auto it = chunks.find(pos);
+	if (it == chunks.end()) return nullptr;
+
+	LoadedChunk& loaded = const_cast<LoadedChunk&>(it->second);
+	if (loaded.cold.load(std::memory_order_acquire)) thaw(pos, loaded);
+	if (loaded.lastUsed.load(std::memory_order_relaxed) != accessClock) {
+		loaded.lastUsed.store(accessClock, std::memory_order_relaxed);
+	}
+	return &loaded;
+}
+
+void World::thaw(ChunkPos pos, LoadedChunk& loaded) const {
+	std::lock_guard<std::mutex> lock(thawMutex);
+	if (!loaded.cold.load(std::memory_order_relaxed)) return;
+
+	auto start = std::chrono::steady_clock::now();
+	auto chunk = std::make_unique<Chunk>(pos);
+	decodeChunk(loaded.packedChunk.data(), loaded.packedChunk.size(), *chunk);
+	auto light = std::make_unique<ChunkLight>();
+	decompressBlock(loaded.packedLight.data(), loaded.packedLight.size(), reinterpret_cast<uint8_t *>(light.get()), sizeof(ChunkLight));
+	auto occupancy = std::make_unique<ChunkOccupancy>();
+	occupancy->build(*chunk);
+
+	cold.coldChunks--;
+	cold.coldBytes -= loaded.packedChunk.size() + loaded.packedLight.size();
+	cold.thaws++;
+	cold.thawMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	loaded.chunk = std::move(chunk);
+	loaded.light = std::move(light);
+	loaded.occupancy = std::move(occupancy);
+	std::vector<uint8_t>().swap(loaded.packedChunk);
+	std::vector<uint8_t>().swap(loaded.packedLight);
+	loaded.cold.store(false, std::memory_order_release);
+}
+
+// Drops a cold chunk's compressed form from the totals.
+void World::release(LoadedChunk& loaded) {
+	if (!loaded.cold.load(std::memory_order_relaxed)) return;
+
+	std::lock_guard<std::mutex> lock(thawMutex);
+	cold.coldChunks--;
+	cold.coldBytes -= loaded.packedChunk.size() + loaded.packedLight.size();
+	std::vector<uint8_t>().swap(loaded.packedChunk);
+	std::vector<uint8_t>().swap(loaded.packedLight);
+	loaded.cold.store(false, std::memory_order_relaxed);
+}
+
+Chunk *World::getChunk(ChunkPos pos) {
+	LoadedChunk *loaded = use(pos);
+	return loaded ? loaded->chunk.get() : nullptr;
+}
+
+const Chunk *World::getChunk(ChunkPos pos) const {
+	LoadedChunk *loaded = use(pos);
+	return loaded ? loaded->chunk.get() : nullptr;
+}
+
+const Chunk *World::peekChunk(ChunkPos pos) const {
+	auto it = chunks.find(pos);
+	if (it == chunks.end() || it->second.cold.load(std::memory_order_acquire)) return nullptr;
+	return it->second.chunk.get();
+}
+
+Chunk& World::addChunk(std::unique_ptr<Chunk> chunk) {
+	ChunkPos pos = chunk->pos;
+	LoadedChunk& loaded = chunks[pos];
+	release(loaded);
+	loaded.chunk = std::move(chunk);
+	loaded.occupancy = std::make_unique<ChunkOccupancy>();
+	loaded.occupancy->build(*loaded.chunk);
+	loaded.light = std::make_unique<ChunkLight>();
+	loaded.lastUsed.store(accessClock, std::memory_order_relaxed);
+	for (int y = 0; y < SECTIONS_PER_CHUNK; y++) {
+		const std::vector<BlockId>& palette = loaded.chunk->sections[y].getPalette();
+		if (std::any_of(palette.begin(), palette.end(), ticksRandomly)) {
+			tickingSections.insert({pos.x, y, pos.z});
+		} else {
+			tickingSections.erase({pos.x, y, pos.z});
+		}
+	}
+	unlitChunks.push_back(pos);
+	markChunkDirty(pos);
+	return *loaded.chunk;
+}
+
+void World::removeChunk(ChunkPos pos) {
+	auto it = chunks.find(pos);
+	if (it != chunks.end()) {
+		release(it->second);
+		chunks.erase(it);
+	}
+	for (int y = 0; y < SECTIONS_PER_CHUNK; y++) {
+		tickingSections.erase({pos.x, y, pos.z});
+	}
+	markChunkDirty(pos);
+
+	// Reported even though the chunk is gone so its meshes get dropped.
+	for (int y = 0; y < SECTIONS_PER_CHUNK; y++) {
+		dirtySections.insert({pos.x, y, pos.z});
+	}
+}
+
+// Loading or unloading a chunk changes which border faces of its four
+// neighbours are exposed, so their sections are remeshed as well.
+void World::markChunkDirty(ChunkPos pos) {
+	const ChunkPos around[] = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+	for (auto offset : around) {
+		ChunkPos neighbour = {pos.x + offset.x, pos.z + offset.z};
+		if (!chunks.count(neighbour)) continue;
+
+		for (int y = 0; y < SECTIONS_PER_CHUNK; y++) {
+			dirtySections.insert({neighbour.x, y, neighbour.z});
+		}
+	}
+}
+
+const ChunkOccupancy *World::getOccupancy(ChunkPos pos) const {
+	LoadedChunk *loaded = use(pos);
+	return loaded ? loaded->occupancy.get() : nullptr;
+}
+
+const ChunkLight *World::getLight(ChunkPos pos) const {
+	LoadedChunk *loaded = use(pos);
+	return loaded ? loaded->light.get() : nullptr;
+}
+
+ChunkLight *World::getLight(ChunkPos pos) {
+	LoadedChunk *loaded = use(pos);
+	return loaded ? loaded->light.get() : nullptr;
+}
+
+BlockId World::getBlock(int x, int y, int z) const {
+	if (y < 0 || y >= CHUNK_HEIGHT) return AIR;
+
+	const Chunk *chunk = getChunk(chunkOf(x, z));
+	if (!chunk) return AIR;
+
+	return chunk->getBlock(x & (SECTION_SIZE - 1), y, z & (SECTION_SIZE - 1));
+}
+
+BlockId World::peekBlock(int x, int y, int z) const {
+	if (y < 0 || y >= CHUNK_HEIGHT) return AIR;
+
+	const Chunk *chunk = peekChunk(chunkOf(x, z));
+	if (!chunk) return AIR;
+
+	return chunk->getBlock(x & (SECTION_SIZE - 1), y, z & (SECTION_SIZE - 1));
+}
+
+void World::setBlock(int x, int y, int z, BlockId id) {
+	if (y < 0 || y >= CHUNK_HEIGHT) return;
+
+	ChunkPos pos = chunkOf(x, z);
+	LoadedChunk *loaded = use(pos);
+	if (!loaded) return;
+
+	loaded->chunk->setBlock(x & (SECTION_SIZE - 1), y, z & (SECTION_SIZE - 1), id);
+	loaded->occupancy->set(x & (SECTION_SIZE - 1), y, z & (SECTION_SIZE - 1), isSolid(id));
+	unsaved.insert(pos);
+	lightEdits.push_back({x, y, z});
+	blockEdits.push_back({x, y, z});
+
+	// An edit on a section border can expose or hide faces of the
+	// neighbouring section, which then needs a rebuild too.
+	SectionPos section = sectionOf(x, y, z);
+	int lx = x & (SECTION_SIZE - 1);
+	int ly = y & (SECTION_SIZE - 1);
+	int lz = z & (SECTION_SIZE - 1);
+
+	if (ticksRandomly(id)) tickingSections.insert(section);
+
+	markSectionDirty(section);
+	if (lx == 0) markSectionDirty({section.x - 1, section.y, section.z});
+	if (lx == SECTION_SIZE - 1) markSectionDirty({section.x + 1, section.y, section.z});
+	if (ly == 0) markSectionDirty({section.x, section.y - 1, section.z});
+	if (ly == SECTION_SIZE - 1) markSectionDirty({section.x, section.y + 1, section.z});
+	if (lz == 0) markSectionDirty({section.x, section.y, section.z - 1});
+	if (lz == SECTION_SIZE - 1) markSectionDirty({section.x, section.y, section.z + 1});
+}
+
+void World::markUnsaved(ChunkPos pos) {
+	unsaved.insert(pos);
+}
+
+std::vector<ChunkPos> World::takeUnsaved() {
+	std::vector<ChunkPos> positions(unsaved.begin(), unsaved.end());
+	unsaved.clear();
+	return positions;
+}
+
+std::vector<ChunkPos> World::takeUnsaved(const std::vector<ChunkPos>& positions) {
+	std::vector<ChunkPos> taken;
+	for (ChunkPos pos : positions) {
+		if (unsaved.erase(pos)) taken.push_back(pos);
+	}
+	return taken;
+}
+
+void World::markSectionDirty(SectionPos pos) {
+	if (pos.y < 0 || pos.y >= SECTIONS_PER_CHUNK) return;
+	if (!chunks.count({pos.x, pos.z})) return;
+
+	dirtySections.insert(pos);
+}
+
+std::vector<SectionPos> World::takeDirtySections() {
+	std::vector<SectionPos> positions(dirtySections.begin(), dirtySections.end());
+	dirtySections.clear();
+	return positions;
+}
+
+std::vector<ChunkPos> World::takeUnlitChunks() {
+	std::vector<ChunkPos> positions;
+	positions.swap(unlitChunks);
+	return positions;
+}
+
+std::vector<BlockPos> World::takeLightEdits() {
+	std::vector<BlockPos> positions;
+	positions.swap(lightEdits);
+	return positions;
+}
+
+std::vector<BlockPos> World::takeBlockEdits() {
+	std::vector<BlockPos> positions;
+	positions.swap(blockEdits);
+	return positions;
+}
+
+std::vector<ChunkUsage> World::chunkUsage() const {
+	std::vector<ChunkUsage> usage;
+	usage.reserve(chunks.size());
+	for (const auto& [pos, loaded] : chunks) {
+		if (loaded.cold.load(std::memory_order_relaxed)) continue;
+
+		size_t bytes = sizeof(Chunk) + sizeof(ChunkOccupancy) + sizeof(ChunkLight);
+		for (const Section& section : loaded.chunk->sections) {
+			bytes += section.getPalette().capacity() * sizeof(BlockId) + section.getData().capacity() * sizeof(uint64_t);
+		}
+		usage.push_back({pos, loaded.lastUsed.load(std::memory_order_relaxed), bytes, unsaved.count(pos) > 0, loaded.chunk.get(), loaded.light.get()});
+	}
+	return usage;
+}
+
+bool World::freeze(ChunkPos pos, uint64_t lastUsed, std::vector<uint8_t> packedChunk, std::vector<uint8_t> packedLight) {
+	auto it = chunks.find(pos);
+	if (it == chunks.end()) return false;
+
+	LoadedChunk& loaded = it->second;
+	if (loaded.cold.load(std::memory_order_relaxed) || loaded.lastUsed.load(std::memory_order_relaxed) != lastUsed || unsaved.count(pos)) return false;
+
+	std::lock_guard<std::mutex> lock(thawMutex);
+	cold.coldChunks++;
+	cold.coldBytes += packedChunk.size() + packedLight.size();
+	cold.freezes++;
+	loaded.chunk.reset();
+	loaded.occupancy.reset();
+	loaded.light.reset();
+	loaded.packedChunk = std::move(packedChunk);
+	loaded.packedLight = std::move(packedLight);
+	loaded.cold.store(true, std::memory_order_release);
+	return true;
+}
+
+ColdStats World::coldStats() const {
+	std::lock_guard<std::mutex> lock(thawMutex);
+	return cold;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <world/chunk.hpp>
+#include <world/occupancy.hpp>
+#include <world/light.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct BlockPos {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+};
+
+// A loaded chunk as ChunkCompactor sees it; reading it is not an access.
+struct ChunkUsage {
+	ChunkPos pos;
+	uint64_t lastUsed;
+	// Chunk, light and occupancy, roughly.
+	size_t bytes;
+	// Unsaved chunks are left for the saver before they are compressed.
+	bool unsaved;
+	const Chunk *chunk;
+	const ChunkLight *light;
+};
+
+struct ColdStats {
+	size_t coldChunks = 0;
+	uint64_t coldBytes = 0;
+	uint64_t freezes = 0;
+	uint64_t thaws = 0;
+	double thawMilliseconds = 0.0;
+};
+
+// Loaded chunks plus the state derived from them. Edits to loaded chunks
+// go through setBlock so the occupancy masks and dirty sets stay current.
+//
+// A loaded chunk may be cold: compressed together with its light, with
+// nothing else kept. Any lookup of a cold chunk, its light or occupancy
+// thaws it first, from any thread, so callers never see the difference.
+// Chunks only turn cold through freeze(), between ticks.
+class World {
+public:
+	Chunk *getChunk(ChunkPos pos);
+	const Chunk *getChunk(ChunkPos pos) const;
+	Chunk& addChunk(std::unique_ptr<Chunk> chunk);
+	void removeChunk(ChunkPos pos);
+
+	BlockId getBlock(int x, int y, int z) const;
+	void setBlock(int x, int y, int z, BlockId id);
+
+	// Null for cold chunks; neither thaws nor counts as an access.
+	const Chunk *peekChunk(ChunkPos pos) const;
+	BlockId peekBlock(int x, int y, int z) const;
+
+	size_t chunkCount() const { return chunks.size(); }
+	const ChunkOccupancy *getOccupancy(ChunkPos pos) const;
+	const ChunkLight *getLight(ChunkPos pos) const;
+	ChunkLight *getLight(ChunkPos pos);
+
+	void markUnsaved(ChunkPos pos);
+	std::vector<ChunkPos> takeUnsaved();
+	// Only those of positions that are unsaved.
+	std::vector<ChunkPos> takeUnsaved(const std::vector<ChunkPos>& positions);
+	size_t unsavedCount() const { return unsaved.size(); }
+
+	void markSectionDirty(SectionPos pos);
+	std::vector<SectionPos> takeDirtySections();
+	size_t dirtySectionCount() const { return dirtySections.size(); }
+
+	std::vector<ChunkPos> takeUnlitChunks();
+	std::vector<BlockPos> takeLightEdits();
+	// Every setBlock since the last call, for scheduling block updates.
+	std::vector<BlockPos> takeBlockEdits();
+
+	// Sections whose palette has a block that ticks randomly. Palettes
+	// keep ids no longer in use until reencoded, so some may have none.
+	const std::unordered_set<SectionPos, SectionPosHash>& getTickingSections() const { return tickingSections; }
+
+	// Lookups stamp chunks with the access clock, advanced once per tick.
+	void advanceClock() { accessClock++; }
+	uint64_t clock() const { return accessClock; }
+	std::vector<ChunkUsage> chunkUsage() const;
+	// Swaps a chunk for its compressed form, unless it was used after
+	// lastUsed, unloaded or edited since; returns whether it did.
+	bool freeze(ChunkPos pos, uint64_t lastUsed, std::vector<uint8_t> packedChunk, std::vector<uint8_t> packedLight);
+	ColdStats coldStats() const;
+private:
+	struct LoadedChunk {
+		std::unique_ptr<Chunk> chunk;
+		std::unique_ptr<ChunkOccupancy> occupancy;
+		std::unique_ptr<ChunkLight> light;
+		// The encoded chunk and compressed light while cold.
+		std::vector<uint8_t> packedChunk;
+		std::vector<uint8_t> packedLight;
+		std::atomic<bool> cold{false};
+		std::atomic<uint64_t> lastUsed{0};
+	};
+
+	std::unordered_map<ChunkPos, LoadedChunk, ChunkPosHash> chunks;
+	uint64_t accessClock = 0;
+	mutable std::mutex thawMutex;
+	mutable ColdStats cold;
+	std::vector<ChunkPos> unlitChunks;
+	std::vector<BlockPos> lightEdits;
+	std::vector<BlockPos> blockEdits;
+	std::unordered_set<SectionPos, SectionPosHash> tickingSections;
+	std::unordered_set<ChunkPos, ChunkPosHash> unsaved;
+	std::unordered_set<SectionPos, SectionPosHash> dirtySections;
+
+	void markChunkDirty(ChunkPos pos);
+	LoadedChunk *use(ChunkPos pos) const;
+	void thaw(ChunkPos pos, LoadedChunk& loaded) const;
+	void release(LoadedChunk& loaded);
+};
+
+ChunkPos chunkOf(int x, int z);
+SectionPos sectionOf(int x, int y, int z);